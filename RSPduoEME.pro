@@ -17,6 +17,9 @@ TEMPLATE = app
 # deprecated API in order to know how to port your code away from it.
 DEFINES += QT_DEPRECATED_WARNINGS
 
+# constexpr filter tables (filters.h) need C++17
+CONFIG += c++17
+
 # You can also make your code fail to compile if you use deprecated APIs.
 # In order to do so, uncomment the following line.
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
@@ -30,22 +33,55 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # LIBS += -L D:\Qt\RSPapi\x86 -l_sdrplay_api -l fftw3-3
 
 # Where the library files are located in the project directory
-LIBS += -L "$$shell_path($$_PRO_FILE_PWD_)" -l_sdrplay_api
+win32: LIBS += -L "$$shell_path($$_PRO_FILE_PWD_)" -l_sdrplay_api
+
+# Elsewhere link the installed SDRplay API, or the hardware free emulator built from emulator/sdrplay_emulator.pro
+unix: LIBS += -lsdrplay_api
 
 
 SOURCES += \
         main.cpp \
         mainwindow.cpp \
+        samplesource.cpp \
+        inputstats.cpp \
         rspduointerface.cpp \
+        filesource.cpp \
+        signalgenerator.cpp \
+        generatorsource.cpp \
         processthread.cpp \
-        dspthread.cpp
+        dspthread.cpp \
+        firkernels.cpp \
+        fftfilter.cpp \
+        cicfilter.cpp \
+        fixedpoint.cpp \
+        filterdesign.cpp \
+        frameassembler.cpp
 
 HEADERS += \
         mainwindow.h \
+        samplesource.h \
         rspduointerface.h \
+        eventqueue.h \
+        filesource.h \
+        signalgenerator.h \
+        generatorsource.h \
+        inputring.h \
+        inputstats.h \
+        wakeup.h \
+        frameassembler.h \
         processthread.h \
         sdrplay_api.h \
         filters.h \
+        firkernels.h \
+        fftfilter.h \
+        cicfilter.h \
+        fixedpoint.h \
+        filterdesign.h \
+        delayline.h \
+        multirate.h \
+        spscqueue.h \
+        pipeline.h \
+        forkjoin.h \
         dspthread.h
 
 FORMS += \
@@ -0,0 +1,251 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+#include "cicfilter.h"
+#include "filters.h"
+#include "multirate.h"
+#include "samplesource.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+
+
+// *****************************  CIC Decimator  ****************************** //
+
+
+CICDecimator::~CICDecimator()
+{
+    delete[] SinTable;
+    delete[] CosTable;
+    delete[] Compensation;
+    delete[] HistoryI;
+    delete[] HistoryQ;
+    delete[] Saved;
+}
+
+void CICDecimator::SetOscillator(const double *Sin, const double *Cos, int Length)
+{
+    if(Length != TableLength)
+    {
+        delete[] SinTable;
+        delete[] CosTable;
+        SinTable = new short[Length];
+        CosTable = new short[Length];
+        TableLength = Length;
+        Pointer = 0;
+    }
+    for(int p = 0; p < Length; p++)
+    {
+        SinTable[p] = short(std::lround(Sin[p] * 32767));
+        CosTable[p] = short(std::lround(Cos[p] * 32767));
+    }
+}
+
+void CICDecimator::SetRatio(int Ratio, const double *Coef, int Length)
+{
+    // the 30 bit mixer product grows by Stages bits for each bit of Ratio, drop enough to stay inside 32
+    int Bits = 0;
+    while((1 << Bits) < Ratio) Bits++;
+    R = Ratio;
+    Shift = (Stages * Bits) - 1;
+
+    double Gain = std::pow(double(R), Stages) * 32767 / (1 << Shift);
+    delete[] Compensation;
+    delete[] HistoryI;
+    delete[] HistoryQ;
+    delete[] Saved;
+    Taps = Length;
+    Compensation = new float[Taps];
+    HistoryI = new float[Taps];
+    HistoryQ = new float[Taps];
+    Saved = new float[Taps];
+    for(int k = 0; k < Taps; k++) Compensation[k] = float(Coef[k] / Gain);
+    Reset();
+}
+
+void CICDecimator::Reset(void)
+{
+    Pointer = 0;
+    Phase = 0;
+    for(int s = 0; s < Stages; s++) IntegratorI[s] = IntegratorQ[s] = CombI[s] = CombQ[s] = 0;
+    for(int k = 0; k < Taps; k++) HistoryI[k] = HistoryQ[k] = 0;
+}
+
+int CICDecimator::Process(const short *In, int Count, float *OutI, float *OutQ)
+{
+    // the four stages written out with the registers in locals, so the compiler keeps them all in CPU registers
+    unsigned int I1 = IntegratorI[0], I2 = IntegratorI[1], I3 = IntegratorI[2], I4 = IntegratorI[3];
+    unsigned int Q1 = IntegratorQ[0], Q2 = IntegratorQ[1], Q3 = IntegratorQ[2], Q4 = IntegratorQ[3];
+    unsigned int CI1 = CombI[0], CI2 = CombI[1], CI3 = CombI[2], CI4 = CombI[3];
+    unsigned int CQ1 = CombQ[0], CQ2 = CombQ[1], CQ3 = CombQ[2], CQ4 = CombQ[3];
+    const int Round = 1 << (Shift - 1);
+    int p = Pointer, Step = Phase, OP = 0;
+
+    for(int n = 0; n < Count; n++)
+    {
+        // mix, then integrate at the input rate
+        I1 += (unsigned int)(((In[n] * SinTable[p]) + Round) >> Shift);
+        Q1 += (unsigned int)(((In[n] * CosTable[p]) + Round) >> Shift);
+        if(++p >= TableLength) p = 0;
+        I2 += I1; I3 += I2; I4 += I3;
+        Q2 += Q1; Q3 += Q2; Q4 += Q3;
+        if(++Step < R) continue;
+        Step = 0;
+
+        // differentiate at the output rate
+        unsigned int D1 = I4 - CI1, D2 = D1 - CI2, D3 = D2 - CI3;
+        CI1 = I4; CI2 = D1; CI3 = D2;
+        OutI[OP] = float(int(D3 - CI4));
+        CI4 = D3;
+        D1 = Q4 - CQ1; D2 = D1 - CQ2; D3 = D2 - CQ3;
+        CQ1 = Q4; CQ2 = D1; CQ3 = D2;
+        OutQ[OP] = float(int(D3 - CQ4));
+        CQ4 = D3;
+        OP++;
+    }
+
+    IntegratorI[0] = I1; IntegratorI[1] = I2; IntegratorI[2] = I3; IntegratorI[3] = I4;
+    IntegratorQ[0] = Q1; IntegratorQ[1] = Q2; IntegratorQ[2] = Q3; IntegratorQ[3] = Q4;
+    CombI[0] = CI1; CombI[1] = CI2; CombI[2] = CI3; CombI[3] = CI4;
+    CombQ[0] = CQ1; CombQ[1] = CQ2; CombQ[2] = CQ3; CombQ[3] = CQ4;
+    Pointer = p;
+    Phase = Step;
+
+    Compensate(OutI, OP, HistoryI);
+    Compensate(OutQ, OP, HistoryQ);
+    return OP;
+}
+
+void CICDecimator::Compensate(float *x, int Count, float *History)
+{
+    // keep the newest Taps-1 raw samples for the next block before they are overwritten
+    int Keep = Taps - 1;
+    for(int k = 0; k < Keep; k++) Saved[k] = (k < Count) ? x[Count - 1 - k] : History[k - Count];
+
+    int m = Count - 1;
+    for(; m >= Keep; m--)
+    {
+        float Acc = 0;
+        for(int k = 0; k < Taps; k++) Acc += Compensation[k] * x[m - k];
+        x[m] = Acc;
+    }
+    for(; m >= 0; m--)
+    {
+        float Acc = 0;
+        for(int k = 0; k < Taps; k++) Acc += Compensation[k] * ((k <= m) ? x[m - k] : History[k - m - 1]);
+        x[m] = Acc;
+    }
+
+    for(int k = 0; k < Keep; k++) History[k] = Saved[k];
+}
+
+
+// *****************************  Responses  ****************************** //
+
+
+static double Response(const double *Coef, int Taps, double Cycles)   // magnitude, Cycles per sample
+{
+    std::complex<double> Sum = 0;
+    for(int k = 0; k < Taps; k++) Sum += Coef[k] * std::polar(1.0, -2 * M_PI * Cycles * k);
+    return std::abs(Sum);
+}
+
+const double *CICCompensation(int Ratio)
+{
+    return (Ratio == 4) ? CIC4Comp : CIC2Comp;
+}
+
+double FIRFrontEndResponse(int Ratio, double Frequency)
+{
+    double Gain = Response(D2ACoef, D2A_Order, Frequency / INPUT_SAMPLE_RATE);
+    if(Ratio == 4) Gain *= Response(D2BCoef, D2B_Order, 2 * Frequency / INPUT_SAMPLE_RATE);
+    return Gain;
+}
+
+double CICFrontEndResponse(int Ratio, double Frequency)
+{
+    double x = M_PI * Frequency / INPUT_SAMPLE_RATE;
+    double Gain = (std::fabs(std::sin(x)) < 1e-12) ? 1 : std::pow(std::fabs(std::sin(Ratio * x) / (Ratio * std::sin(x))), CICDecimator::Stages);
+    return Gain * Response(CICCompensation(Ratio), CICComp_Order, Ratio * Frequency / INPUT_SAMPLE_RATE);
+}
+
+double AliasRejection(double (*Response)(int, double), int Ratio)
+{
+    const int Points = 400;
+    double Rate = double(INPUT_SAMPLE_RATE) / Ratio;
+    double Passband = 0.0925 * Rate;
+
+    double Weakest = Response(Ratio, 0);
+    for(int i = 1; i <= Points; i++) Weakest = std::min(Weakest, Response(Ratio, Passband * i / Points));
+
+    double Strongest = 0;
+    for(int k = 1; (k * Rate) - Passband <= INPUT_SAMPLE_RATE / 2; k++)
+        for(int i = 0; i <= Points; i++)
+        {
+            double Frequency = (k * Rate) - Passband + (2 * Passband * i / Points);
+            if(Frequency <= INPUT_SAMPLE_RATE / 2) Strongest = std::max(Strongest, Response(Ratio, Frequency));
+        }
+    return 20 * std::log10(Weakest / Strongest);
+}
+
+
+// *****************************  Benchmark  ****************************** //
+
+
+FrontEndBenchmark BenchmarkFrontEnds(int Ratio)
+{
+    // the FIR front end is Mixer (D2A) and D2B as in the receive chain, the CIC the same Mixer switched over
+    const int Total = INPUT_SAMPLE_RATE, Runs = 10;
+    short *Input = new short[Total];
+    unsigned int Seed = 12345;
+    for(int n = 0; n < Total; n++) { Seed = Seed * 1103515245 + 12345; Input[n] = short((int)(Seed >> 16) % 32768 - 16384); }
+
+    double Sin[40], Cos[40];
+    for(int p = 0; p < 40; p++) { Sin[p] = std::sin(0.45 * M_PI * p); Cos[p] = -std::cos(0.45 * M_PI * p); }
+
+    Chain<Mixer<2, D2A_Order, float, 1>, Decimator<2, D2B_Order, float, 1>> FrontEnd;
+    FrontEnd.Stage<0>().Setup(D2ACoef, 40);
+    FrontEnd.Stage<0>().SetOscillator(0, Sin, Cos);
+    FrontEnd.Stage<1>().Setup(D2BPhase);
+    FrontEnd.Allocate(FILTER_BLOCK_SIZE);
+    decltype(FrontEnd)::Buffer Output;
+    Output.Allocate(Total / 2 + 1);
+
+    auto Time = [&]()
+    {
+        double Best = 0;
+        for(int Run = 0; Run < Runs; Run++)
+        {
+            FrontEnd.Reset();
+            const short *In[1] = { Input };
+            auto Start = std::chrono::steady_clock::now();
+            FrontEnd.Process(In, Total, Output);
+            double Taken = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+            if((Run == 0) || (Taken < Best)) Best = Taken;
+        }
+        return 1e9 * Best / Total;
+    };
+
+    FrontEndBenchmark Result;
+    FrontEnd.Stage<1>().Enabled = (Ratio == 4);
+    Result.FIRTime = Time();
+    FrontEnd.Stage<0>().UseCIC(Ratio, CICCompensation(Ratio), CICComp_Order);
+    FrontEnd.Stage<1>().Enabled = false;
+    Result.CICTime = Time();
+    Result.FIRRejection = AliasRejection(FIRFrontEndResponse, Ratio);
+    Result.CICRejection = AliasRejection(CICFrontEndResponse, Ratio);
+
+    delete[] Input;
+    return Result;
+}
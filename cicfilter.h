@@ -0,0 +1,91 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+#ifndef CICFILTER_H
+#define CICFILTER_H
+
+
+// CIC front end, an alternative to the D2A/D2B FIR decimators for the first 2MHz to 1MHz or 500KHz.
+//
+// The int16 input is mixed to baseband with a 15 bit integer copy of the tuner oscillator, then decimated by Ratio in
+// a Stages order cascaded integrator comb filter: integrators at the input rate and combs at the output rate, all
+// adds in 32 bit registers that wrap around (the wrap cancels in the combs as long as the output fits). The product
+// of the mixer is scaled down by enough bits to leave room for the CIC gain of Ratio^Stages. The sinc^Stages response
+// droops across the passband, a short symmetric FIR at the output rate (CIC4Comp, CIC2Comp in filters.h) flattens it
+// and takes the gain back to that of the FIR front end. It runs in float over each block of outputs once the CIC has
+// produced them, in place from the last output back so every output only overwrites samples already used.
+//
+// Worst alias into the D5 passband, 4 stages: decimate by 4 -76dB, by 2 -67dB (D2A/D2B -59dB, D2A alone -56dB).
+
+class CICDecimator
+{
+public:
+    static constexpr int Stages = 4;            // integrator/comb pairs, as written out in Process, and the compensation filters designed for
+
+    CICDecimator() {}
+    ~CICDecimator();
+    CICDecimator(const CICDecimator &) = delete;
+    CICDecimator &operator=(const CICDecimator &) = delete;
+
+    void SetOscillator(const double *Sin, const double *Cos, int Length);   // tuner table, repeats every Length inputs
+    void SetRatio(int Ratio, const double *Compensation, int Taps);         // decimate by Ratio (2 to 16), compensate
+
+    // Count real input samples to complex outputs at 1/Ratio of the rate, returns the number of outputs
+    int Process(const short *In, int Count, float *OutI, float *OutQ);
+    void Reset(void);
+
+    int Ratio(void) const { return R; }
+
+private:
+    void Compensate(float *x, int Count, float *History);
+
+    short *SinTable = nullptr;                  // tuner oscillator, 15 bit
+    short *CosTable = nullptr;
+    int TableLength = 0;
+    int Pointer = 0;                            // oscillator position of the next input sample
+    int R = 0;                                  // decimation ratio
+    int Shift = 0;                              // bits dropped from the mixer product
+    int Phase = 0;                              // input samples since the last output
+    unsigned int IntegratorI[Stages] {};        // integrator and comb registers, modulo 2^32
+    unsigned int IntegratorQ[Stages] {};
+    unsigned int CombI[Stages] {};
+    unsigned int CombQ[Stages] {};
+    float *Compensation = nullptr;              // compensation filter, scaled by the inverse of the CIC gain
+    int Taps = 0;
+    float *HistoryI = nullptr;                  // last Taps-1 CIC outputs before the block, newest first
+    float *HistoryQ = nullptr;
+    float *Saved = nullptr;                     // the last of the block, while the block is filtered
+};
+
+
+// Front end frequency responses, magnitude at Frequency Hz of the 2MHz input, unity gain at DC
+double FIRFrontEndResponse(int Ratio, double Frequency);    // D2A, then D2B for Ratio 4
+double CICFrontEndResponse(int Ratio, double Frequency);    // CIC and its compensation filter
+
+const double *CICCompensation(int Ratio);                   // compensation filter (CICComp_Order taps) for Ratio 2 or 4
+
+// Alias rejection (dB) of a front end decimating the 2MHz input by Ratio: the weakest response in the passband
+// (D5 passband, 0.0925 of the output rate) over the strongest in the input bands that fold onto it
+double AliasRejection(double (*Response)(int, double), int Ratio);
+
+// Time both front ends on one channel of pseudo random input, through the FIR kernels in use
+struct FrontEndBenchmark
+{
+    double FIRTime;             // nS per input sample, mixer and D2A (and D2B)
+    double CICTime;             // nS per input sample, mixer, CIC and compensation
+    double FIRRejection;        // alias rejection (dB)
+    double CICRejection;
+};
+
+FrontEndBenchmark BenchmarkFrontEnds(int Ratio);
+
+#endif // CICFILTER_H
@@ -0,0 +1,98 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+#ifndef DELAYLINE_H
+#define DELAYLINE_H
+
+#include <cstring>
+
+
+// Filter delay line holding the last Length input samples, newest first, as one contiguous window.
+//
+// The history is kept twice over in a buffer of 2 * Length, every sample is written at the write position and again
+// Length further on. The write position steps backwards, so the Length samples from it are always the newest sample
+// followed by the older ones in order, and the FIR kernels read them straight from there. Each new sample costs two
+// stores instead of moving the whole history down by one.
+//
+// A delay line can also be kept oldest first (write position stepping forwards, window ending at the newest sample),
+// which gives the mirrored half of a symmetric filter its history in the same order as the coefficients.
+//
+// Several streams going through the same filter can share one delay line as Lanes interleaved samples per tap
+// (tap k of lane l at Window()[k * Lanes + l]), so a vector kernel takes one tap of every stream in one load.
+
+template<typename T = float>
+class DelayLine
+{
+public:
+    DelayLine() {}
+    DelayLine(const DelayLine &) = delete;
+    DelayLine &operator=(const DelayLine &) = delete;
+
+    ~DelayLine()
+    {
+        delete[] Buffer;
+    }
+
+    void Allocate(int Taps, bool OldestFirst = false, int Lanes = 1)
+    {
+        delete[] Buffer;
+        Length = Taps;
+        Width = Lanes;
+        Step = OldestFirst ? 1 : -1;
+        Start = OldestFirst ? 1 : 0;
+        Buffer = new T[2 * Length * Width];
+        Clear();
+    }
+
+    void Clear(void)
+    {
+        memset(Buffer, 0, 2 * Length * Width * sizeof(T));
+        Position = 0;
+    }
+
+    void Push(T Sample)    // single lane only
+    {
+        Position += Step;
+        if(Position < 0) Position = Length - 1;
+        else if(Position >= Length) Position = 0;
+        Buffer[Position] = Sample;
+        Buffer[Position + Length] = Sample;
+    }
+
+    // one sample for each of the Lanes streams
+    void Push(const T *Samples)
+    {
+        Position += Step;
+        if(Position < 0) Position = Length - 1;
+        else if(Position >= Length) Position = 0;
+        for(int Lane = 0; Lane < Width; Lane++)
+        {
+            Buffer[(Position * Width) + Lane] = Samples[Lane];
+            Buffer[((Position + Length) * Width) + Lane] = Samples[Lane];
+        }
+    }
+
+    // the last Length samples, Window()[0] is the newest (oldest if kept oldest first)
+    const T *Window(void) const { return &Buffer[(Position + Start) * Width]; }
+
+    int Taps(void) const { return Length; }
+
+private:
+    T *Buffer = nullptr;                            // history, stored twice
+    int Length = 0;                                 // number of taps
+    int Width = 1;                                  // interleaved streams (lanes) per tap
+    int Position = 0;                               // where the newest sample is
+    int Step = -1;                                  // write direction, -1 newest first, +1 oldest first
+    int Start = 0;                                  // window offset from the newest sample, 0 or 1
+};
+
+#endif // DELAYLINE_H
@@ -12,167 +12,155 @@
 
 #include "dspthread.h"
 #include "filters.h"
+#include "firkernels.h"
+#include "fftfilter.h"
+#include "cicfilter.h"
+#include "filterdesign.h"
 #include <QThread>
 #include <QDebug>
 
 #include <QtMath>
 
-DSPthread::DSPthread(QObject *parent) : QObject(parent)
-{
-
-    Timer = new QTimer;  // Initalise Timer Object
-    connect (Timer, SIGNAL(timeout()), this, SLOT(onTimer()));
-    Timer->start(20);  //20 mS
+// Set up the D2B, D5, US6 and US4 stages of a receive filter chain (see ReceiveChain in dspthread.h) on their
+// loaded designs, or the filters.h tables (Q15 for a fixed point chain) where there is none, and the D2A mixer on
+// the filters.h coefficients
 
-    // initiaate list of process times for performance measurement by MainWindow
-    ProcessTimes = new QList<double>;
+template<typename Stage, typename Design, typename Table>
+static void SetupStage(Stage &Filter, const Design &Loaded, const Table &Default)
+{
+    if(Loaded.Taps) Filter.Setup(Loaded);
+    else Filter.Setup(Default);
+}
 
-    // Initalise Circular Buffers and Filter Arrays
+template<typename ChainType, typename T>
+static void SetupStages(ChainType &Receive, const T &Tables)
+{
+    if constexpr(std::is_same<typename decltype(Tables.D2B.Coef)::value_type, int>::value)
+    {
+        SetupStage(Receive.template Stage<1>(), Tables.D2B, D2BPhaseQ15);
+        SetupStage(Receive.template Stage<2>(), Tables.D5, D5PhaseQ15);
+        SetupStage(Receive.template Stage<3>(), Tables.US6, US6PhaseQ15);
+        SetupStage(Receive.template Stage<4>(), Tables.US4, US4PhaseQ15);
+    }
+    else
+    {
+        SetupStage(Receive.template Stage<1>(), Tables.D2B, D2BPhase);
+        SetupStage(Receive.template Stage<2>(), Tables.D5, D5Phase);
+        SetupStage(Receive.template Stage<3>(), Tables.US6, US6Phase);
+        SetupStage(Receive.template Stage<4>(), Tables.US4, US4Phase);
+    }
+}
 
-    I_BufferA = new double[INPUT_BUFFER_SIZE];            // allocate buffer arrays
-    Q_BufferA = new double[INPUT_BUFFER_SIZE];
-    I_BufferB = new double[INPUT_BUFFER_SIZE];
-    Q_BufferB = new double[INPUT_BUFFER_SIZE];
-
-    I_D5FilterOutA = new double[INPUT_BUFFER_SIZE];       // allocate D5 output arrays
-    Q_D5FilterOutA = new double[INPUT_BUFFER_SIZE];
-    I_D5FilterOutB = new double[INPUT_BUFFER_SIZE];
-    Q_D5FilterOutB = new double[INPUT_BUFFER_SIZE];
-
-    I_US6FilterOutA = new double[INPUT_BUFFER_SIZE * 6];  // allocate US6 output arrays
-    Q_US6FilterOutA = new double[INPUT_BUFFER_SIZE * 6];  // (larger than needed!)
-    I_US6FilterOutB = new double[INPUT_BUFFER_SIZE * 6];
-    Q_US6FilterOutB = new double[INPUT_BUFFER_SIZE * 6];
-
-    I_US4FilterOutA = new double[INPUT_BUFFER_SIZE * 6];  // allocate US4 output arrays
-    Q_US4FilterOutA = new double[INPUT_BUFFER_SIZE * 6];  // (larger than needed!)
-    I_US4FilterOutB = new double[INPUT_BUFFER_SIZE * 6];
-    Q_US4FilterOutB = new double[INPUT_BUFFER_SIZE * 6];
-
-    I_SoundCardOutA = new double[INPUT_BUFFER_SIZE * 6];   // allocate Sound Card output arrays
-    Q_SoundCardOutA = new double[INPUT_BUFFER_SIZE * 6];   // (larger than needed!)
-    I_SoundCardOutB = new double[INPUT_BUFFER_SIZE * 6];
-    Q_SoundCardOutB = new double[INPUT_BUFFER_SIZE * 6];
-
-    I_CircularOutputBufferA = new double[CircularOutputBufferSize];
-    Q_CircularOutputBufferA = new double[CircularOutputBufferSize];
-    I_CircularOutputBufferB = new double[CircularOutputBufferSize];
-    Q_CircularOutputBufferB = new double[CircularOutputBufferSize];
-    I_CircularOutputBufferSCA = new double[CircularOutputBufferSize];
-    Q_CircularOutputBufferSCA = new double[CircularOutputBufferSize];
-    I_CircularOutputBufferSCB = new double[CircularOutputBufferSize];
-    Q_CircularOutputBufferSCB = new double[CircularOutputBufferSize];
+template<typename ChainType, typename T>
+static void SetupChain(ChainType &Receive, const T &Tables, int TableLength)
+{
+    Receive.template Stage<0>().Setup(D2ACoef, TableLength);
+    SetupStages(Receive, Tables);
+}
 
-    // initialise Sin / Cos lookup table arrays
+// set up, allocate and tune the three chains of a ChainSet (see dspthread.h)
 
-    PhaseInc = 0.45*M_PI;     // to tune to 0.45 bandwith
-    SinCosTableLength = 40;   // for this frequency repeats after 40
-
-    SinTableA = new double[SinCosTableLength];
-    CosTableA = new double[SinCosTableLength];
-    SinTableB = new double[SinCosTableLength];
-    CosTableB = new double[SinCosTableLength];
+template<typename Set, typename T>
+static void SetupChains(Set &Chains, const T &Tables, int TableLength)
+{
+    SetupChain(Chains.A, Tables, TableLength);
+    SetupChain(Chains.B, Tables, TableLength);
+    SetupChain(Chains.AB, Tables, TableLength);
+}
 
-    GenerateSinCosTable(0,0); // initalise arrays with 0 starting phases
+template<typename Set>
+static void AllocateChains(Set &Chains, int Pass)
+{
+    Chains.A.Allocate(Pass);
+    Chains.B.Allocate(Pass);
+    Chains.AB.Allocate(Pass);
+}
 
+template<typename Set>
+static void SetOscillators(Set &Chains, const double *SinA, const double *CosA, const double *SinB, const double *CosB)
+{
+    Chains.A.template Stage<0>().SetOscillator(0, SinA, CosA);
+    Chains.B.template Stage<0>().SetOscillator(0, SinB, CosB);
+    Chains.AB.template Stage<0>().SetOscillator(0, SinA, CosA);
+    Chains.AB.template Stage<0>().SetOscillator(1, SinB, CosB);
+}
 
-    // initalise D2A Ch A arrays and filters (polyphase decimation by 2)
-    I_D2AA = new double[2][D2A_Order/2];
-    Q_D2AA = new double[2][D2A_Order/2];
-    for(int filter = 0; filter < 2; filter++) // zero all 2 sub filters
-    { for(int loop = 0;loop < D2A_Order/2; loop++) { I_D2AA[filter][loop]=0; Q_D2AA[filter][loop]=0; }}
+// an int16 output sample of the fixed point chain negated, saturating, for the TIMF2 rotation
 
-    // initalise D2A Ch B arrays and filters (polyphase decimation by 2)
-    I_D2AB = new double[2][D2A_Order/2];
-    Q_D2AB = new double[2][D2A_Order/2];
-    for(int filter = 0; filter < 2; filter++) // zero all 2 sub filters
-    { for(int loop = 0;loop < D2A_Order/2; loop++) { I_D2AB[filter][loop]=0; Q_D2AB[filter][loop]=0; }}
+static inline short Negated(short Sample)
+{
+    return (Sample == -32768) ? 32767 : short(-Sample);
+}
 
 
-    // initalise D2B Ch A arrays and filters (polyphase decimation by 2)
-    I_D2BA = new double[2][D2B_Order/2];
-    Q_D2BA = new double[2][D2B_Order/2];
-    for(int filter = 0; filter < 2; filter++) // zero all 2 sub filters
-    { for(int loop = 0;loop < D2B_Order/2; loop++) { I_D2BA[filter][loop]=0; Q_D2BA[filter][loop]=0; }}
+DSPthread::DSPthread(QObject *parent) : QObject(parent)
+{
 
-    // initalise D2B Ch B arrays and filters (polyphase decimation by 2)
-    I_D2BB = new double[2][D2B_Order/2];
-    Q_D2BB = new double[2][D2B_Order/2];
-    for(int filter = 0; filter < 2; filter++) // zero all 2 sub filters
-    { for(int loop = 0;loop < D2B_Order/2; loop++) { I_D2BB[filter][loop]=0; Q_D2BB[filter][loop]=0; }}
+    // input statistics are passed to the GUI thread by queued signal
+    qRegisterMetaType<BlockStats>("BlockStats");
 
+    // initiaate list of process times for performance measurement by MainWindow
+    ProcessTimes = new QList<double>;
 
-    // initalise D5 Ch A arrays and filters (polyphase decimation by 5)
-    I_D5A = new double[5][D5_Order/5];
-    Q_D5A = new double[5][D5_Order/5];
-    for(int filter = 0; filter < 5; filter++) // zero all 5 sub filters
-    { for(int loop = 0;loop < D5_Order/5; loop++) { I_D5A[filter][loop]=0; Q_D5A[filter][loop]=0; }}
+    // initialise the A/B frame assembler on the input rings, which wake Run() as blocks arrive
+    Assembler = new FrameAssembler(&A_InputRing, &B_InputRing);
+    A_InputRing.SetWakeUp(&DataReady);
+    B_InputRing.SetWakeUp(&DataReady);
 
-    // initalise D5 Ch B arrays and filters (polyphase decimation by 5)
-    I_D5B = new double[5][D5_Order/5];
-    Q_D5B = new double[5][D5_Order/5];
-    for(int filter = 0; filter < 5; filter++) // zero all 5 sub filters
-    { for(int loop = 0;loop < D5_Order/5; loop++) { I_D5B[filter][loop]=0; Q_D5B[filter][loop]=0; }}
+    // Initalise Circular Buffers and Filter Arrays
 
+    Float.OutputA.Allocate(INPUT_BUFFER_SIZE / 10 + 1);        // allocate chain output buffers
+    Float.OutputB.Allocate(INPUT_BUFFER_SIZE / 10 + 1);
+    Float.OutputAB.Allocate(INPUT_BUFFER_SIZE / 10 + 1);       // (at most 192KHz from 2MHz input)
+    Fixed.OutputA.Allocate(INPUT_BUFFER_SIZE / 10 + 1);
+    Fixed.OutputB.Allocate(INPUT_BUFFER_SIZE / 10 + 1);
+    Fixed.OutputAB.Allocate(INPUT_BUFFER_SIZE / 10 + 1);
+
+    I_SoundCardOutA = new float[INPUT_BUFFER_SIZE / 10 + 1](); // allocate Sound Card output arrays
+    Q_SoundCardOutA = new float[INPUT_BUFFER_SIZE / 10 + 1]();
+    I_SoundCardOutB = new float[INPUT_BUFFER_SIZE / 10 + 1]();
+    Q_SoundCardOutB = new float[INPUT_BUFFER_SIZE / 10 + 1]();
+
+    I_CircularOutputBufferA = new float[CircularOutputBufferSize];
+    Q_CircularOutputBufferA = new float[CircularOutputBufferSize];
+    I_CircularOutputBufferB = new float[CircularOutputBufferSize];
+    Q_CircularOutputBufferB = new float[CircularOutputBufferSize];
+    I_CircularOutputBufferA16 = new short[CircularOutputBufferSize];
+    Q_CircularOutputBufferA16 = new short[CircularOutputBufferSize];
+    I_CircularOutputBufferB16 = new short[CircularOutputBufferSize];
+    Q_CircularOutputBufferB16 = new short[CircularOutputBufferSize];
+    I_CircularOutputBufferSCA = new short[CircularOutputBufferSize];
+    Q_CircularOutputBufferSCA = new short[CircularOutputBufferSize];
+    I_CircularOutputBufferSCB = new short[CircularOutputBufferSize];
+    Q_CircularOutputBufferSCB = new short[CircularOutputBufferSize];
 
-    // initalise US6 Ch A filters (polyphase upsample by 6, hence / 6)
-    I_US6A = new double[US6_Order/6];
-    Q_US6A = new double[US6_Order/6];
-    for(int loop = 0;loop < US6_Order/6; loop++) { I_US6A[loop]=0; Q_US6A[loop]=0; }
+    // initialise Sin / Cos lookup table arrays
 
-    // initalise US6 Ch B filters (polyphase upsample by 6, hence / 6)
-    I_US6B = new double[US6_Order/6];
-    Q_US6B = new double[US6_Order/6];
-    for(int loop = 0;loop < US6_Order/6; loop++) { I_US6B[loop]=0; Q_US6B[loop]=0; }
+    PhaseInc = 0.45*M_PI;     // to tune to 0.45 bandwith
+    SinCosTableLength = 40;   // for this frequency repeats after 40
 
+    SinTableA = new double[SinCosTableLength];
+    CosTableA = new double[SinCosTableLength];
+    SinTableB = new double[SinCosTableLength];
+    CosTableB = new double[SinCosTableLength];
 
-    // initalise US4 Ch A filters (polyphase upsample by 4, hence / 4)
-    I_US4A = new double[US4_Order/4];
-    Q_US4A = new double[US4_Order/4];
-    for(int loop = 0;loop < US4_Order/4; loop++) { I_US4A[loop]=0; Q_US4A[loop]=0; }
+    // initialise the filter chains, before the tuner tables are folded into D2A
+    SetupChains(Float, Tables, SinCosTableLength);
+    SetupChains(Fixed, TablesQ15, SinCosTableLength);
+    AllocateChains(Float, FILTER_BLOCK_SIZE);                  // filter chains run in cache sized passes, each
+    AllocateChains(Fixed, FILTER_BLOCK_SIZE);                  // stage planned as direct form or FFT for them
 
-    // initalise US4 Ch B filters (polyphase upsample by 4, hence / 4)
-    I_US4B = new double[US4_Order/4];
-    Q_US4B = new double[US4_Order/4];
-    for(int loop = 0;loop < US4_Order/4; loop++) { I_US4B[loop]=0; Q_US4B[loop]=0; }
+    GenerateSinCosTable(0,0); // initalise arrays with 0 starting phases
 
 }
 
 DSPthread::~DSPthread()
 {
-    // Stop timer and delete Timer object
-    Timer->stop();
-    delete Timer;
+    A_InputRing.SetWakeUp(nullptr);
+    B_InputRing.SetWakeUp(nullptr);
+    delete Assembler;
 
     // delete filter buffers and tables
-    delete I_BufferA;
-    delete Q_BufferA;
-    delete I_BufferB;
-    delete Q_BufferB;
-    delete I_D5A;
-    delete Q_D5A;
-    delete I_D5B;
-    delete Q_D5B;
-    delete I_US6A;
-    delete Q_US6A;
-    delete I_US6B;
-    delete Q_US6B;
-    delete I_US4A;
-    delete Q_US4A;
-    delete I_US4B;
-    delete Q_US4B;
-    delete I_D5FilterOutA;
-    delete Q_D5FilterOutA;
-    delete I_D5FilterOutB;
-    delete Q_D5FilterOutB;
-    delete I_US6FilterOutA;
-    delete Q_US6FilterOutA;
-    delete I_US6FilterOutB;
-    delete Q_US6FilterOutB;
-    delete I_US4FilterOutA;
-    delete Q_US4FilterOutA;
-    delete I_US4FilterOutB;
-    delete Q_US4FilterOutB;
     delete I_SoundCardOutA;
     delete Q_SoundCardOutA;
     delete I_SoundCardOutB;
@@ -181,6 +169,10 @@ DSPthread::~DSPthread()
     delete Q_CircularOutputBufferA;
     delete I_CircularOutputBufferB;
     delete Q_CircularOutputBufferB;
+    delete[] I_CircularOutputBufferA16;
+    delete[] Q_CircularOutputBufferA16;
+    delete[] I_CircularOutputBufferB16;
+    delete[] Q_CircularOutputBufferB16;
     delete I_CircularOutputBufferSCA;
     delete Q_CircularOutputBufferSCA;
     delete I_CircularOutputBufferSCB;
@@ -217,269 +209,455 @@ void DSPthread::GenerateSinCosTable(double Aphase, double Bphase)
         //qDebug() << "Phase Table B " + QString::number(loop) + "  Value = " + QString::number(SinTableB[loop]);
     }
 
+    // Fold the tables into the D2A filter of each chain (see Mixer)
+    SetOscillators(Float, SinTableA, CosTableA, SinTableB, CosTableB);
+    SetOscillators(Fixed, SinTableA, CosTableA, SinTableB, CosTableB);
+
 }
 
 
-void DSPthread::onTimer(void)
+void DSPthread::SetPhases(double Aphase, double Bphase)
 {
-    // Check if previous input buffer is processed and if so start another
+    // the tables belong to the DSP thread, which picks the phases up between frames or when Run() next starts
+    {
+        std::lock_guard<std::mutex> Lock(PhaseLock);
+        PendingA = Aphase;
+        PendingB = Bphase;
+        PhasesPending.store(true, std::memory_order_release);
+    }
+    DataReady.Notify();
+}
 
-    if(DSPMode == 0) return; // 0 = no processing
 
-    if(Finished != 1) return; // previous process not finished
+void DSPthread::ApplyPhases(void)
+{
+    if(!PhasesPending.exchange(false, std::memory_order_acquire)) return;
+    double Aphase, Bphase;
+    {
+        std::lock_guard<std::mutex> Lock(PhaseLock);
+        Aphase = PendingA;
+        Bphase = PendingB;
+    }
+    GenerateSinCosTable(Aphase, Bphase);
+}
 
-    // return if no new input buffer available
-    if(A_LastBuffer == PreviousLastBuffer) return;
 
-    // Incremnet previous buffer pointer and use
-    PreviousLastBuffer++;
-    if(PreviousLastBuffer >= BUFFERS) PreviousLastBuffer = 0;
+void DSPthread::RunQueued(void)
+{
+    std::lock_guard<std::mutex> Lock(RunLock);
+    RunsPending++;
+}
 
-    // flag any missmatch in buffer numbers
-    if(A_LastBuffer != B_LastBuffer)
+
+void DSPthread::WaitStopped(void)
+{
+    DSPMode = 0;
+    DataReady.Notify();
+    std::unique_lock<std::mutex> Lock(RunLock);
+    RunsDone.wait(Lock, [this]{ return RunsPending == 0; });
+}
+
+
+void DSPthread::Run(void)
+{
+    // Process every frame as soon as the input rings publish it, sleeping on DataReady in between, until
+    // DSPMode is set back to 0. A frame belongs to this thread from NextFrame() until ReleaseFrame() hands
+    // its blocks back to the input rings, nothing else touches the assembler while Run() is active.
+
+    // discard any stale input blocks, processing starts with the next aligned frame
+    Assembler->Reset();
+    ResetState();
+    ApplyPhases();
+    CheckKernels();
+    bool Planned = PlanChains();
+
+    unsigned int Seen = DataReady.Count();
+    int Mode;
+    while(Planned && ((Mode = DSPMode) != 0))  // 0 = no processing
     {
-        QString Message = "Buffer Missmatch";
-        //emit StatusMessage(Message);
-        qDebug() << Message;
-    }
+        if(Pipelined) FixedPoint ? StartPipeline(Fixed, Mode) : StartPipeline(Float, Mode);
+        else if(Mode == 2) FixedPoint ? StartChannelB(Fixed) : StartChannelB(Float);
 
+        while(Assembler->NextFrame(Mode == 2))
+        {
+            // flag any change in alignment between channels A and B
+            if(Mode == 2) ReportAlignment();
 
-    // Set next buffer number and initate a new process by DSPthread
+            if(Mode == 1) ProcessBufferA();          // process channel A only
+            else ProcessBufferAB();                  // process channels A and B
 
-    BufferNo = PreviousLastBuffer;              // set bufer number
-    Finished = 0;                               // reset Finished flag
-    if(DSPMode == 1) ProcessBufferA();          // process channel A only
-    if (DSPMode == 2) ProcessBufferAB();        // process channels A and B
+            // hand the processed frame back to the input rings
+            Assembler->ReleaseFrame();
+            ApplyPhases();                           // new tuner phases between frames
+            ReportOverrun();
+            ReportStats();
+            if(Pipelined) ReportPipeline();
 
-}
+            if(DSPMode != Mode) break;               // stopped while processing
+        }
 
+        ApplyPhases();
 
-// *****************************  Process Buffer A only  ****************************** //
+        // sleep until a block is published, or Stop/SetPhases ring DataReady
+        Seen = DataReady.Wait(Seen);
+    }
 
+    // finish the passes still in the pipeline before the output is left alone
+    StopPipeline();
+    ChannelB.Stop();
 
-void DSPthread::ProcessBufferA(void)
-{
+    // the input rings and chains are free for WaitStopped's caller
+    {
+        std::lock_guard<std::mutex> Lock(RunLock);
+        RunsPending--;
+    }
+    RunsDone.notify_all();
 
-        start = clock();
+}
 
-        // Tune to centre of IF i.e. 450KHz. (sample rate is 2MHz, Signal Real)
 
-        int LookupTablePointer = 0;
-        for(int loop = 0; loop < INPUT_BUFFER_SIZE; loop++)
-        {
-            // multiply input with Tuner Oscillator
-            I_BufferA[loop] = SinTableA[LookupTablePointer] * A_InputBuffer[BufferNo][loop];
-            Q_BufferA[loop] = CosTableA[LookupTablePointer] * A_InputBuffer[BufferNo][loop];
-            LookupTablePointer ++;  // increment and loop
-            if(LookupTablePointer >= SinCosTableLength) LookupTablePointer = 0;
-         }
+void DSPthread::ResetState(void)
+{
+    // restart the filter chains, only called while DSPMode is 0
+    Float.A.Reset();
+    Float.B.Reset();
+    Float.AB.Reset();
+    Fixed.A.Reset();
+    Fixed.B.Reset();
+    Fixed.AB.Reset();
+}
 
-        // signal here is at 2MHz sample rate complex, bandwith 1MHz, in I/Q_Buffer
 
+void DSPthread::CheckKernels(void)
+{
+    // validate the FIR kernels in use against the scalar reference once, before they are first used
+    if(KernelsChecked) return;
+    KernelsChecked = true;
+
+    const FIRKernels *Selected = FIR;
+    float Error = ValidateFIRKernels(Selected);
+    if(Error > 1e-5f) FIR = ScalarFIRKernels();   // disagrees with the reference, do not trust it
+
+    QString Message = QString::asprintf("FIR Kernels: %s (max relative error %.1e)", FIR->Name, Error);
+    if(FIR != Selected) Message = QString::asprintf("Warning: FIR Kernels %s failed validation (error %.1e), using %s", Selected->Name, Error, FIR->Name);
+    emit StatusMessage(Message);
+    qDebug() << Message;
+
+    // the FFT filters against the direct form, with the kernels now in use
+    if(FFTFilters == FFTFiltersOff) return;
+    Error = ValidateFFTFilters();
+    if(Error <= 1e-5f) return;
+    FFTFilters = FFTFiltersOff;
+    Message = QString::asprintf("Warning: FFT Filters failed validation (error %.1e), using direct form only", Error);
+    emit StatusMessage(Message);
+    qDebug() << Message;
+}
 
-        // Decimation by 2 polyphase filter (D2A)
 
-        double I_D2AsubAccA[2] {0,0};
-        double Q_D2AsubAccA[2] {0,0};
-        int D2Astage = 0;
-        int D2A_OP = 0;
-        for(int loop = 0; loop < INPUT_BUFFER_SIZE; loop++)
+bool DSPthread::PlanChains(void)
+{
+    // the front end decimates to 500KHz (96KHz) or 1MHz (192KHz), with D2B for the FIR at 96KHz
+    int Ratio = (SampleRate == 96000) ? 4 : 2;
+    Float.A.Stage<0>().UseCIC(FrontEnd ? Ratio : 0, CICCompensation(Ratio), CICComp_Order);
+    Float.B.Stage<0>().UseCIC(FrontEnd ? Ratio : 0, CICCompensation(Ratio), CICComp_Order);
+    Float.AB.Stage<0>().UseCIC(FrontEnd ? Ratio : 0, CICCompensation(Ratio), CICComp_Order);
+
+    // D2B for the FIR front end at 96KHz only, set before the plan so the later stages plan for their real input
+    bool D2B = (SampleRate == 96000) && (FrontEnd == 0);
+    Float.A.Stage<1>().Enabled = Float.B.Stage<1>().Enabled = Float.AB.Stage<1>().Enabled = D2B;
+    Fixed.A.Stage<1>().Enabled = Fixed.B.Stage<1>().Enabled = Fixed.AB.Stage<1>().Enabled = D2B;
+
+    // the stage designs before the plan, an FFT stage takes its coefficients when it is planned
+    LoadDesigns();
+
+    // passes are a whole input frame unless it is longer than FILTER_BLOCK_SIZE, only called while DSPMode is 0
+    int Pass = std::min(FILTER_BLOCK_SIZE, A_InputRing.BlockLength());
+    AllocateChains(Float, Pass);
+    AllocateChains(Fixed, Pass);
+
+    if(FixedPoint)
+    {
+        // the CIC front end and FFT filters are float only, so forced on they are not quietly left out
+        QString Message;
+        if(FrontEnd || (FFTFilters == FFTFiltersOn))
+            Message = QString::asprintf("Warning: Fixed Point has no %s, not started", FrontEnd ? "CIC front end" : "FFT filters");
+        else
         {
+            double Rejection = AliasRejection(FIRFrontEndResponse, Ratio);
+            Message = QString::asprintf("Filter Plan: fixed point int32/Q15 (%s mixer kernels), D2A direct%s (alias rejection %.0fdB), D5 direct, US6 direct, US4 direct",
+                                        FIR->Name, (Ratio == 4) ? ", D2B direct" : "", Rejection);
+        }
+        emit StatusMessage(Message);
+        qDebug() << Message;
+        return !(FrontEnd || (FFTFilters == FFTFiltersOn));
+    }
 
-            // shift in a new sample to subfilter
-            for(int index = (D2A_Order/2)-1; index >= 0 ; index--)   // read in every index if I/Q_Buffer
-            {
-                if(index != 0)
-                {
-                    I_D2AA[D2Astage][index] = I_D2AA[D2Astage][index-1];
-                    Q_D2AA[D2Astage][index] = Q_D2AA[D2Astage][index-1];
-                }
-                else { I_D2AA[D2Astage][0] = I_BufferA[loop]; Q_D2AA[D2Astage][0] = Q_BufferA[loop];}
-            }
-            // multiply and accumulate subfilter
-            I_D2AsubAccA[D2Astage] = 0; Q_D2AsubAccA[D2Astage] = 0;
-            for(int index = 0; index < (D2A_Order/2); index++)
-            {
-                I_D2AsubAccA[D2Astage] += (I_D2AA[D2Astage][index] * D2ACoef[(1-D2Astage)+(index*2)]);
-                Q_D2AsubAccA[D2Astage] += (Q_D2AA[D2Astage][index] * D2ACoef[(1-D2Astage)+(index*2)]);
-            }
-            D2Astage += 1;
-            if(D2Astage >= 2)
+    auto Method = [](int Size) { return Size ? QString::asprintf("FFT %d", Size) : QString("direct"); };
+    QString Front = FrontEnd ? QString::asprintf("CIC /%d", Ratio) : (Ratio == 4) ? "D2A direct, D2B " + Method(Float.A.Stage<1>().FFTSize()) : QString("D2A direct");
+    double Rejection = AliasRejection(FrontEnd ? CICFrontEndResponse : FIRFrontEndResponse, Ratio);
+    QString Message = "Filter Plan: " + Front + QString::asprintf(" (alias rejection %.0fdB)", Rejection) + ", D5 " + Method(Float.A.Stage<2>().FFTSize())
+                      + ", US6 " + Method(Float.A.Stage<3>().FFTSize()) + ", US4 " + Method(Float.A.Stage<4>().FFTSize());
+    emit StatusMessage(Message);
+    qDebug() << Message;
+    return true;
+}
+
+
+void DSPthread::LoadDesigns(void)
+{
+    // StageFilters is a list of NAME=spec separated by ';', NAME one of D2B, D5, US6 or US4 and the spec as for
+    // --design-filter, designed or taken from the filter cache. A design runs in its stage at its own length (see
+    // LoadDesign), a stage without one runs on filters.h.
+    Tables = {};
+    TablesQ15 = {};
+
+    // the rate of each stage as a spec gives it, the input of a decimator and the output of an interpolator
+    double D5Rate = 2000000.0 / ((SampleRate == 96000) ? 4 : 2);
+    double US6Rate = D5Rate / 5 * 6;
+    double US4Rate = US6Rate / 5 * 4;
+
+    auto Load = [this](const QString &Name, const QString &Text, FilterSpec::Use Use, int Ratio, double Rate, int Order, auto &Table, auto &TableQ15)
+    {
+        FilterSpec Spec;
+        QString Message;
+        if(!Spec.Parse(Text.toStdString()) || !Spec.Valid()) Message = "Warning: Stage Filter " + Name + " spec not valid: " + Text;
+        else if((Spec.Stage != Use) || (Spec.Ratio != Ratio))
+            Message = QString::asprintf("Warning: Stage Filter %s must %s by %d", qPrintable(Name), (Use == FilterSpec::Decimate) ? "decimate" : "interpolate", Ratio);
+        else
+        {
+            bool Designed = false;
+            std::vector<double> Coef = CachedFilter(Spec, &Designed);
+            if(Coef.empty()) Message = "Warning: Stage Filter " + Name + " spec not reachable: " + Text;
+            else
             {
-                // accumulate all subfilters and output
-                I_BufferA[loop-1] = I_D2AsubAccA[0] + I_D2AsubAccA[1];  // write out every 2nd index of I/Q_Buffer
-                Q_BufferA[loop-1] = Q_D2AsubAccA[0] + Q_D2AsubAccA[1];
-                D2Astage = 0;
-                D2A_OP++;  // inc D2A filter O/P size
+                LoadDesign(Coef, Use, Table);
+                LoadDesign(Coef, Use, TableQ15);
+                FilterResponse Response = MeasureFilter(Coef, Spec);
+                Message = QString::asprintf("Stage Filter: %s %s %d taps (filters.h %d), ripple %.3fdB, attenuation %.1fdB", qPrintable(Name),
+                                            Designed ? "designed" : "cached", Table.Taps * Ratio, Order, Response.Ripple, Response.Attenuation);
+                if(Spec.SampleRate != Rate) Message += QString::asprintf(", designed at %.0fHz for a stage at %.0fHz", Spec.SampleRate, Rate);
             }
+        }
+        emit StatusMessage(Message);
+        qDebug() << Message;
+    };
 
+    for(const QString &Entry : StageFilters.split(';'))
+    {
+        if(Entry.trimmed().isEmpty()) continue;
+        QString Name = Entry.section('=', 0, 0).trimmed().toUpper();
+        QString Text = Entry.section('=', 1).trimmed();
+        if(Name == "D2B") Load(Name, Text, FilterSpec::Decimate, 2, 1000000.0, D2B_Order, Tables.D2B, TablesQ15.D2B);
+        else if(Name == "D5") Load(Name, Text, FilterSpec::Decimate, 5, D5Rate, D5_Order, Tables.D5, TablesQ15.D5);
+        else if(Name == "US6") Load(Name, Text, FilterSpec::Interpolate, 6, US6Rate, US6_Order, Tables.US6, TablesQ15.US6);
+        else if(Name == "US4") Load(Name, Text, FilterSpec::Interpolate, 4, US4Rate, US4_Order, Tables.US4, TablesQ15.US4);
+        else
+        {
+            QString Message = "Warning: Stage Filter " + Entry.trimmed() + " not recognised, expected D2B, D5, US6 or US4=spec";
+            emit StatusMessage(Message);
+            qDebug() << Message;
         }
+    }
 
+    // the stages take their tables again, which checks them for symmetry and clears the histories
+    SetupStages(Float.A, Tables);
+    SetupStages(Float.B, Tables);
+    SetupStages(Float.AB, Tables);
+    SetupStages(Fixed.A, TablesQ15);
+    SetupStages(Fixed.B, TablesQ15);
+    SetupStages(Fixed.AB, TablesQ15);
+}
 
-        if(SampleRate == 96000)  // extra decimation stage for 96000 Sample Rate
-        {
 
-            // Decimation by 2 polyphase filter (D2B)
+void DSPthread::ReportAlignment(void)
+{
+    // only report when something has changed, so the status display is not flooded
+    unsigned long long Gaps = A_InputRing.Padded() + B_InputRing.Padded();
+    if((Assembler->Skew == 0) && (Assembler->DroppedB == ReportedDroppedB) && (Assembler->PaddedB == ReportedPaddedB)
+            && (Gaps == ReportedGaps) && (Assembler->Resyncs == ReportedResyncs)) return;
+
+    QString Message = QString::asprintf("A/B Alignment: Skew=%lld Dropped=%llu Padded=%llu Gaps=%llu Resyncs=%llu",
+                                        Assembler->Skew, Assembler->DroppedB, Assembler->PaddedB, Gaps, Assembler->Resyncs);
+    emit StatusMessage(Message);
+    qDebug() << Message;
+
+    ReportedDroppedB = Assembler->DroppedB;
+    ReportedPaddedB = Assembler->PaddedB;
+    ReportedGaps = Gaps;
+    ReportedResyncs = Assembler->Resyncs;
+}
 
-            double I_D2BsubAccA[2] {0,0};
-            double Q_D2BsubAccA[2] {0,0};
-            int D2Bstage = 0;
-            int D2B_OP = 0;
-            for(int loop = 0; loop < INPUT_BUFFER_SIZE; loop+=2)  // read in every 2nd index of I/Q_Buffer
-            {
 
-                // shift in a new sample to subfilter
-                for(int index = (D2B_Order/2)-1; index >= 0 ; index--)
-                {
-                    if(index != 0)
-                    {
-                        I_D2BA[D2Bstage][index] = I_D2BA[D2Bstage][index-1];
-                        Q_D2BA[D2Bstage][index] = Q_D2BA[D2Bstage][index-1];
-                    }
-                    else { I_D2BA[D2Bstage][0] = I_BufferA[loop]; Q_D2BA[D2Bstage][0] = Q_BufferA[loop];}
-                }
-                // multiply and accumulate subfilter
-                I_D2BsubAccA[D2Bstage] = 0; Q_D2BsubAccA[D2Bstage] = 0;
-                for(int index = 0; index < (D2B_Order/2); index++)
-                {
-                    I_D2BsubAccA[D2Bstage] += (I_D2BA[D2Bstage][index] * D2BCoef[(1-D2Bstage)+(index*2)]);
-                    Q_D2BsubAccA[D2Bstage] += (Q_D2BA[D2Bstage][index] * D2BCoef[(1-D2Bstage)+(index*2)]);
-                }
-                D2Bstage += 1;
-                if(D2Bstage >= 2)
-                {
-                    // accumulate all subfilters and output
-                    I_BufferA[loop-2] = I_D2BsubAccA[0] + I_D2BsubAccA[1];  // write out every 4th index of I/Q_Buffer
-                    Q_BufferA[loop-2] = Q_D2BsubAccA[0] + Q_D2BsubAccA[1];
-                    D2Bstage = 0;
-                    D2B_OP++;  // inc D2A filter O/P size
-                }
+void DSPthread::ReportOverrun(void)
+{
+    // warn once the backlog passes half the ring, and again each time it reaches a new high
+    unsigned int HalfRing = A_InputRing.BlockCount() / 2;
+    if((Assembler->MaxBacklog > HalfRing) && (Assembler->MaxBacklog > ReportedBacklog))
+    {
+        QString Message = QString::asprintf("Warning: Input Backlog %u of %d Blocks", Assembler->MaxBacklog, A_InputRing.BlockCount());
+        emit StatusMessage(Message);
+        qDebug() << Message;
+        ReportedBacklog = Assembler->MaxBacklog;
+    }
 
-            }
+    if(Assembler->Overruns == ReportedOverruns) return;
 
-        }
+    double BlockTime = (1000.0 * A_InputRing.BlockLength()) / INPUT_SAMPLE_RATE;   // mS
+    QString Message = QString::asprintf("Input Overrun: Lost A=%llu B=%llu Blocks (%.1f mS) Overruns=%llu, %s",
+                                        Assembler->LostA, Assembler->LostB, BlockTime * Assembler->LostA, Assembler->Overruns,
+                                        (Assembler->Policy == ResyncBoth) ? "resynced" : "skipped to newest");
+    emit StatusMessage(Message);
+    qDebug() << Message;
 
-        // Decimated by 4 output (500KHz) now in I/Q_Buffer index 4  (for 96KHz output rate)
-        // decimated by 2 output (1000KHz) now in I/Q_Buffer index 2 (for 192KHz output rate)
+    ReportedOverruns = Assembler->Overruns;
+}
 
-        // Select buffer index dependant on output rate 96KHz v 192KHz
 
-        int RateIndex;
-        if(SampleRate == 192000) RateIndex = 2;  // for 192KHz Sample Rate
-        else RateIndex = 4;                      // default for 96KHz Sample Rate
+void DSPthread::ReportStats(void)
+{
+    IntervalA.Merge(Assembler->StatsA);
+    IntervalB.Merge(Assembler->StatsB);   // stays empty when processing channel A only
+    if(IntervalA.Count < INPUT_SAMPLE_RATE / 10) return;
 
-        // Decimation by 5 polyphase filter (D5)
+    emit InputStats(IntervalA, IntervalB);
+    IntervalA.Clear();
+    IntervalB.Clear();
+}
 
-        double I_D5subAccA[5] {0,0,0,0,0,};
-        double Q_D5subAccA[5] {0,0,0,0,0,};
-        int D5stage = 0;
-        int D5_OP = 0;
-        for(int loop = 0; loop < INPUT_BUFFER_SIZE/RateIndex; loop++)
-        {
 
-            // shift in a new sample to subfilter
-            for(int index = (D5_Order/5)-1; index >= 0 ; index--)
-            {
-                if(index != 0)
-                {
-                    I_D5A[D5stage][index] = I_D5A[D5stage][index-1];
-                    Q_D5A[D5stage][index] = Q_D5A[D5stage][index-1];
-                }
-                else { I_D5A[D5stage][0] = I_BufferA[loop*RateIndex]; Q_D5A[D5stage][0] = Q_BufferA[loop*RateIndex];}
-            }
-            // multiply and accumulate subfilter
-            I_D5subAccA[D5stage] = 0; Q_D5subAccA[D5stage] = 0;
-            for(int index = 0; index < (D5_Order/5); index++)
-            {
-                I_D5subAccA[D5stage] += (I_D5A[D5stage][index] * D5Coef[(4-D5stage)+(index*5)]);
-                Q_D5subAccA[D5stage] += (Q_D5A[D5stage][index] * D5Coef[(4-D5stage)+(index*5)]);
-            }
-            D5stage += 1;
-            if(D5stage >= 5)
-            {
-                // accumulate all subfilters and output
-                I_D5FilterOutA[(loop/5)] = I_D5subAccA[0] + I_D5subAccA[1] + I_D5subAccA[2] + I_D5subAccA[3] + I_D5subAccA[4];
-                Q_D5FilterOutA[(loop/5)] = Q_D5subAccA[0] + Q_D5subAccA[1] + Q_D5subAccA[2] + Q_D5subAccA[3] + Q_D5subAccA[4];
-                D5stage = 0;
-                D5_OP++;  // inc D5 filter O/P size
-            }
+template<typename Set>
+void DSPthread::StartPipeline(Set &Chains, int Mode)
+{
+    // Mixer/D2 runs on this thread, feeding the passes to D5, the resampler and the output formatting
 
-        }
+    if(Mode == 1)
+    {
+        if(Chains.PipelineA.Running()) return;
+        Chains.PipelineAB.Stop();
+        Chains.PipelineA.Start({ [&Chains](auto &In, auto &Out) { Chains.A.template ProcessPass<2, 2>(In, Out); },
+                                 [&Chains](auto &In, auto &Out) { Chains.A.template ProcessPass<3, 4>(In, Out); } },
+                               [this](auto &In) { FormatOutputA(In); },
+                               { "Mixer/D2", "D5", "Resampler", "Output" }, PIPELINE_DEPTH, FILTER_BLOCK_SIZE);
+    }
+    else
+    {
+        if(Chains.PipelineAB.Running()) return;
+        Chains.PipelineA.Stop();
+        Chains.PipelineAB.Start({ [&Chains](auto &In, auto &Out) { Chains.AB.template ProcessPass<2, 2>(In, Out); },
+                                  [&Chains](auto &In, auto &Out) { Chains.AB.template ProcessPass<3, 4>(In, Out); } },
+                                [this](auto &In) { FormatOutputAB(In.I, In.Q, In.Count); },
+                                { "Mixer/D2", "D5", "Resampler", "Output" }, PIPELINE_DEPTH, FILTER_BLOCK_SIZE);
+    }
+    PipelineSamples = 0;
 
-        // Decimated by 5 output (100KHz/200KHz) now in I/Q_D5FilterOut
+    bool Pinned = (Mode == 1) ? Chains.PipelineA.Pinned() : Chains.PipelineAB.Pinned();
+    QString Message = QString::asprintf("DSP Pipeline: 4 threads, %s", Pinned ? "pinned to cores of their own" : "not pinned (fewer than 4 cores in the affinity mask)");
+    emit StatusMessage(Message);
+    qDebug() << Message;
+}
 
 
-        // Perform Polyphase upsample by 6 filter (US6)
+void DSPthread::StopPipeline(void)
+{
+    Float.PipelineA.Stop();
+    Float.PipelineAB.Stop();
+    Fixed.PipelineA.Stop();
+    Fixed.PipelineAB.Stop();
+}
 
-        double I_AccumulatorA = 0;
-        double Q_AccumulatorA = 0;
-        int US6_OP = 0;
 
-        for(int x = 0; x < D5_OP; x++)  // loop D5 output size
-        {
-            // shift in new sample to filter register (size US6_Order/6)
-            for(int SR = (US6_Order/6)-1; SR >= 0; SR--)
-            {
-                if(SR != 0) { I_US6A[SR] = I_US6A[SR-1]; Q_US6A[SR] = Q_US6A[SR-1]; }
-                else { I_US6A[0] = I_D5FilterOutA[x]; Q_US6A[0] = Q_D5FilterOutA[x]; }
-            }
-            //loop 6 times to multiply / accumulate and output upsampled samples
-            for(int loop = 0; loop < 6; loop++)
-            {
-                I_AccumulatorA = 0; Q_AccumulatorA = 0;
-                for(int index = 0; index < (US6_Order/6); index++)
-                {
-                    I_AccumulatorA += (I_US6A[index] * US6Coef[loop+(index*6)]);
-                    Q_AccumulatorA += (Q_US6A[index] * US6Coef[loop+(index*6)]);
-                }
-                I_US6FilterOutA[US6_OP+loop] = I_AccumulatorA * 6; // adjust gain
-                Q_US6FilterOutA[US6_OP+loop] = Q_AccumulatorA * 6;
-            }
-            US6_OP += 6; // inc US6 filter output size
-        }
+void DSPthread::ReportPipeline(void)
+{
+    PipelineSamples += Assembler->FrameSize;
+    if(PipelineSamples < 10LL * INPUT_SAMPLE_RATE) return;
+    PipelineSamples = 0;
+
+    const auto &Load = FixedPoint ? (Fixed.PipelineA.Running() ? Fixed.PipelineA.Load() : Fixed.PipelineAB.Load())
+                                  : (Float.PipelineA.Running() ? Float.PipelineA.Load() : Float.PipelineAB.Load());
+    QString Message = "DSP Pipeline Load:";
+    for(const auto &Stage : Load) Message += QString::asprintf(" %s %.0f%% (blocked %.0f%%)", Stage.Name, 100 * Stage.Busy, 100 * Stage.Blocked);
+    emit StatusMessage(Message);
+    qDebug() << Message;
+}
 
 
-        // Upsample by 6 Decimate 5 (120KHz/240KHz) output now in I/Q_US6FilterOut index * 5;
+template<typename Set>
+void DSPthread::StartChannelB(Set &Chains)
+{
+    // with a second core filter channels A and B concurrently on separate chains, on one core keep them
+    // interleaved in the AB chain where they share each SIMD multiply
+    if(ChannelB.Running() || (std::thread::hardware_concurrency() < 2)) return;
 
+    ChannelB.Start([this, &Chains]
+    {
+        const short *Input[1] = { Assembler->FrameB };
+        Chains.B.Process(Input, Assembler->FrameSize, Chains.OutputB);
+    });
 
-        // Perform Polyphase upsample by 4 filter (US4)
+    QString Message = "A/B Channels: filtered concurrently on 2 threads";
+    emit StatusMessage(Message);
+    qDebug() << Message;
+}
 
-        I_AccumulatorA = 0;
-        Q_AccumulatorA = 0;
-        int US4_OP = 0;
 
-        for(int x = 0; x < US6_OP; x += 5)  // decimate by 5, using US6 filter output size
-        {
+// *****************************  Process Buffer A only  ****************************** //
 
-            // shift in new sample to filter register (size US4_Order/4)
-            for(int SR = (US4_Order/4)-1; SR >= 0; SR--)
-            {
-                if(SR != 0) { I_US4A[SR] = I_US4A[SR-1]; Q_US4A[SR] = Q_US4A[SR-1]; }
-                else { I_US4A[0] = I_US6FilterOutA[x]; Q_US4A[0] = Q_US6FilterOutA[x]; }
-            }
-            //loop 4 times to multiply / accumulate and output upsampled samples
-            for(int loop = 0; loop < 4; loop++)
+
+void DSPthread::ProcessBufferA(void)
+{
+    if(FixedPoint) ProcessFrameA(Fixed);
+    else ProcessFrameA(Float);
+}
+
+
+template<typename Set>
+void DSPthread::ProcessFrameA(Set &Chains)
+{
+
+        start = std::chrono::steady_clock::now();
+
+        // Filter the channel A frame down to 96KHz/192KHz complex (see ReceiveChain), D2B enabled by PlanChains
+
+        if(Pipelined)
+        {
+            // Mixer/D2 each pass here and hand it on, the rest of the chain and the output run on the pipeline
+            for(int Start = 0; Start < Assembler->FrameSize; Start += FILTER_BLOCK_SIZE)
             {
-                I_AccumulatorA = 0; Q_AccumulatorA = 0;
-                for(int index = 0; index < (US4_Order/4); index++)
-                {
-                    I_AccumulatorA += (I_US4A[index] * US4Coef[loop+(index*4)]);
-                    Q_AccumulatorA += (Q_US4A[index] * US4Coef[loop+(index*4)]);
-                }
-                I_US4FilterOutA[US4_OP+loop] = I_AccumulatorA * 4; // adjust gain
-                Q_US4FilterOutA[US4_OP+loop] = Q_AccumulatorA * 4;
+                const short *Pass[1] = { Assembler->FrameA + Start };
+                auto *Slot = Chains.PipelineA.Claim();
+                Chains.A.template ProcessPass<1>(Pass, std::min(FILTER_BLOCK_SIZE, Assembler->FrameSize - Start), *Slot);
+                Chains.PipelineA.Publish();
             }
-            US4_OP += 4; // inc output pointer
+        }
+        else
+        {
+            const short *Input[1] = { Assembler->FrameA };
+            FormatOutputA(Chains.A.Process(Input, Assembler->FrameSize, Chains.OutputA));
         }
 
-        // Upsampled by 4 Decimated by 5 (96KHz/192KHz) output in I/Q_US4FilterOut index * 5
+        // pipelined, the load is that of the busiest stage thread rather than this thread's share of the work
+        double time_taken = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if(Pipelined) time_taken = Chains.PipelineA.Slowest();
+        ProcessTimes->append(time_taken);
+
+        //qDebug() << "DSP1 time = " + QString::number(time_taken);
+
+}
+
+
+void DSPthread::FormatOutputA(ReceiveChain<1>::Buffer &Output)
+{
+
+        float *I_US4FilterOutA = Output.I[0];   // 96KHz/192KHz output, the US4 stage
+        float *Q_US4FilterOutA = Output.Q[0];
+        int Output_OP = Output.Count;
 
 
         if(SoundCardOutput != 0)
         {
             // Save US4FilterOut (Soundcard Format Spectrum) in SoundCardOut buffer
 
-            for(int loop = 0; loop < US4_OP; loop+=5)  // (decimating by five)
+            for(int loop = 0; loop < Output_OP; loop++)
             {
                 I_SoundCardOutA[loop] = I_US4FilterOutA[loop];
                 Q_SoundCardOutA[loop] = Q_US4FilterOutA[loop];
@@ -489,13 +667,13 @@ void DSPthread::ProcessBufferA(void)
 
         if(TIMF2Output == 1)
         {
-            // Rotate spectrum 180 degrees (pi) to MAP65 format (in-place using US4 buffer index 5)
+            // Rotate spectrum 180 degrees (pi) to MAP65 format (in-place in US4 buffer)
 
             double IoutA, QoutA, IoutB, QoutB;
             static double PhaseAcc = 0;
             double PhaseInc = M_PI;
 
-            for(int loop = 0; loop < US4_OP; loop+=5)
+            for(int loop = 0; loop < Output_OP; loop++)
             {
                 // incremet the tuner oscillator each sample period
                 PhaseAcc += PhaseInc;
@@ -508,9 +686,9 @@ void DSPthread::ProcessBufferA(void)
             }
         }
 
-        // Move Output Data to Circular Output Buffers, decimated by 5
+        // Move Output Data to Circular Output Buffers
 
-        for(int loop = 0; loop < US4_OP; loop+=5)
+        for(int loop = 0; loop < Output_OP; loop++)
         {
             I_CircularOutputBufferA[InPoint] = I_US4FilterOutA[loop]; // UDP format data
             Q_CircularOutputBufferA[InPoint] = Q_US4FilterOutA[loop];
@@ -524,316 +702,109 @@ void DSPthread::ProcessBufferA(void)
             if(InPoint >= CircularOutputBufferSize) InPoint = 0;
         }
 
-        Finished = 1; // Flag completion of DSP processing for this buffer
-
-        end = clock();
-        double time_taken = double(end - start) / double(CLOCKS_PER_SEC);
-        ProcessTimes->append(time_taken);
-
-        //qDebug() << "DSP1 time = " + QString::number(time_taken);
-
 }
 
 
-// *****************************  Process Both Buffers A & B  ****************************** //
-
-
-void DSPthread::ProcessBufferAB(void)
+void DSPthread::FormatOutputA(FixedPointChain<1>::Buffer &Output)
 {
+    // as for the float chain, in int16: the sound card buffers take the output as it is, the UDP buffers the same
+    // rotated 180 degrees to MAP65 format if TIMF2, which negates I and Q on alternate samples
 
-    start = clock();
-
-    // Tune to centre of IF i.e. 450KHz. (sample rate is 2MHz, Signal Real)
+    static bool Rotated = false;
 
-    int LookupTablePointer = 0;
-    for(int loop = 0; loop < INPUT_BUFFER_SIZE; loop++)
-    {
-        // multiply input with Tuner Oscillator
-        I_BufferA[loop] = SinTableA[LookupTablePointer] * A_InputBuffer[BufferNo][loop];
-        Q_BufferA[loop] = CosTableA[LookupTablePointer] * A_InputBuffer[BufferNo][loop];
-        I_BufferB[loop] = SinTableB[LookupTablePointer] * B_InputBuffer[BufferNo][loop];
-        Q_BufferB[loop] = CosTableB[LookupTablePointer] * B_InputBuffer[BufferNo][loop];
-        LookupTablePointer ++;  // increment and loop
-        if(LookupTablePointer >= SinCosTableLength) LookupTablePointer = 0;
-     }
-
-    // signal here is at 2MHz sample rate complex, bandwith 1MHz, in I/Q_Buffer
-
-
-    // Decimation by 2 polyphase filter (D2A)
-
-    double I_D2AsubAccA[2] {0,0};
-    double Q_D2AsubAccA[2] {0,0};
-    double I_D2AsubAccB[2] {0,0};
-    double Q_D2AsubAccB[2] {0,0};
-    int D2Astage = 0;
-    int D2A_OP = 0;
-    for(int loop = 0; loop < INPUT_BUFFER_SIZE; loop++)
+    for(int loop = 0; loop < Output.Count; loop++)
     {
+        short I = MAC<int>::ToInt16(Output.I[0][loop]);
+        short Q = MAC<int>::ToInt16(Output.Q[0][loop]);
+        if(TIMF2Output == 1) Rotated = !Rotated;
 
-        // shift in a new sample to subfilter
-        for(int index = (D2A_Order/2)-1; index >= 0 ; index--)   // read in every index if I/Q_Buffer
-        {
-            if(index != 0)
-            {
-                I_D2AA[D2Astage][index] = I_D2AA[D2Astage][index-1];
-                Q_D2AA[D2Astage][index] = Q_D2AA[D2Astage][index-1];
-                I_D2AB[D2Astage][index] = I_D2AB[D2Astage][index-1];
-                Q_D2AB[D2Astage][index] = Q_D2AB[D2Astage][index-1];
-            }
-            else
-            {   I_D2AA[D2Astage][0] = I_BufferA[loop];
-                Q_D2AA[D2Astage][0] = Q_BufferA[loop];
-                I_D2AB[D2Astage][0] = I_BufferB[loop];
-                Q_D2AB[D2Astage][0] = Q_BufferB[loop];
-            }
-        }
-        // multiply and accumulate subfilter
-        I_D2AsubAccA[D2Astage] = 0; Q_D2AsubAccA[D2Astage] = 0;
-        I_D2AsubAccB[D2Astage] = 0; Q_D2AsubAccB[D2Astage] = 0;
-        for(int index = 0; index < (D2A_Order/2); index++)
-        {
-            I_D2AsubAccA[D2Astage] += (I_D2AA[D2Astage][index] * D2ACoef[(1-D2Astage)+(index*2)]);
-            Q_D2AsubAccA[D2Astage] += (Q_D2AA[D2Astage][index] * D2ACoef[(1-D2Astage)+(index*2)]);
-            I_D2AsubAccB[D2Astage] += (I_D2AB[D2Astage][index] * D2ACoef[(1-D2Astage)+(index*2)]);
-            Q_D2AsubAccB[D2Astage] += (Q_D2AB[D2Astage][index] * D2ACoef[(1-D2Astage)+(index*2)]);
-        }
-        D2Astage += 1;
-        if(D2Astage >= 2)
-        {
-            // accumulate all subfilters and output
-            I_BufferA[loop-1] = I_D2AsubAccA[0] + I_D2AsubAccA[1];  // write out every 2nd index of I/Q_Buffer
-            Q_BufferA[loop-1] = Q_D2AsubAccA[0] + Q_D2AsubAccA[1];
-            I_BufferB[loop-1] = I_D2AsubAccB[0] + I_D2AsubAccB[1];
-            Q_BufferB[loop-1] = Q_D2AsubAccB[0] + Q_D2AsubAccB[1];
-            D2Astage = 0;
-            D2A_OP++;  // inc D2A filter O/P size
-        }
-
-    }
+        I_CircularOutputBufferA16[InPoint] = ((TIMF2Output == 1) && Rotated) ? Negated(I) : I;    // UDP format data
+        Q_CircularOutputBufferA16[InPoint] = ((TIMF2Output == 1) && !Rotated) ? Negated(Q) : Q;
+        I_CircularOutputBufferB16[InPoint] = 0; // zero unused channel in case
+        Q_CircularOutputBufferB16[InPoint] = 0; // UDP Mode is used for single channel
 
+        I_CircularOutputBufferSCA[InPoint] = I; // Sound Card format data
+        Q_CircularOutputBufferSCA[InPoint] = Q;
 
-    if(SampleRate == 96000)  // extra decimation stage for 96000 Sample Rate
-    {
+        InPoint++;
+        if(InPoint >= CircularOutputBufferSize) InPoint = 0;
+    }
 
-        // Decimation by 2 polyphase filter (D2B)
+}
 
-        double I_D2BsubAccA[2] {0,0};
-        double Q_D2BsubAccA[2] {0,0};
-        double I_D2BsubAccB[2] {0,0};
-        double Q_D2BsubAccB[2] {0,0};
-        int D2Bstage = 0;
-        int D2B_OP = 0;
-        for(int loop = 0; loop < INPUT_BUFFER_SIZE; loop+=2)  // read in every 2nd index of I/Q_Buffer
-        {
 
-            // shift in a new sample to subfilter
-            for(int index = (D2B_Order/2)-1; index >= 0 ; index--)
-            {
-                if(index != 0)
-                {
-                    I_D2BA[D2Bstage][index] = I_D2BA[D2Bstage][index-1];
-                    Q_D2BA[D2Bstage][index] = Q_D2BA[D2Bstage][index-1];
-                    I_D2BB[D2Bstage][index] = I_D2BB[D2Bstage][index-1];
-                    Q_D2BB[D2Bstage][index] = Q_D2BB[D2Bstage][index-1];
-                }
-                else
-                {
-                    I_D2BA[D2Bstage][0] = I_BufferA[loop];
-                    Q_D2BA[D2Bstage][0] = Q_BufferA[loop];
-                    I_D2BB[D2Bstage][0] = I_BufferB[loop];
-                    Q_D2BB[D2Bstage][0] = Q_BufferB[loop];
-                }
-            }
-            // multiply and accumulate subfilter
-            I_D2BsubAccA[D2Bstage] = 0; Q_D2BsubAccA[D2Bstage] = 0;
-            I_D2BsubAccB[D2Bstage] = 0; Q_D2BsubAccB[D2Bstage] = 0;
-            for(int index = 0; index < (D2B_Order/2); index++)
-            {
-                I_D2BsubAccA[D2Bstage] += (I_D2BA[D2Bstage][index] * D2BCoef[(1-D2Bstage)+(index*2)]);
-                Q_D2BsubAccA[D2Bstage] += (Q_D2BA[D2Bstage][index] * D2BCoef[(1-D2Bstage)+(index*2)]);
-                I_D2BsubAccB[D2Bstage] += (I_D2BB[D2Bstage][index] * D2BCoef[(1-D2Bstage)+(index*2)]);
-                Q_D2BsubAccB[D2Bstage] += (Q_D2BB[D2Bstage][index] * D2BCoef[(1-D2Bstage)+(index*2)]);
-            }
-            D2Bstage += 1;
-            if(D2Bstage >= 2)
-            {
-                // accumulate all subfilters and output
-                I_BufferA[loop-2] = I_D2BsubAccA[0] + I_D2BsubAccA[1];  // write out every 4th index of I/Q_Buffer
-                Q_BufferA[loop-2] = Q_D2BsubAccA[0] + Q_D2BsubAccA[1];
-                I_BufferB[loop-2] = I_D2BsubAccB[0] + I_D2BsubAccB[1];
-                Q_BufferB[loop-2] = Q_D2BsubAccB[0] + Q_D2BsubAccB[1];
-                D2Bstage = 0;
-                D2B_OP++;  // inc D2A filter O/P size
-            }
+// *****************************  Process Both Buffers A & B  ****************************** //
 
-        }
 
-    }
+void DSPthread::ProcessBufferAB(void)
+{
+    if(FixedPoint) ProcessFrameAB(Fixed);
+    else ProcessFrameAB(Float);
+}
 
-    // Decimated by 4 output (500KHz) now in I/Q_Buffer index 4  (for 96KHz output rate)
-    // decimated by 2 output (1000KHz) now in I/Q_Buffer index 2 (for 192KHz output rate)
 
-    // Select buffer index dependant on output rate 96KHz v 192KHz
+template<typename Set>
+void DSPthread::ProcessFrameAB(Set &Chains)
+{
 
-    int RateIndex;
-    if(SampleRate == 192000) RateIndex = 2;  // for 192KHz Sample Rate
-    else RateIndex = 4;                      // default for 96KHz Sample Rate
+    start = std::chrono::steady_clock::now();
 
-    // Decimation by 5 polyphase filter (D5)
+    // Filter the channel A and B frames down to 96KHz/192KHz complex (see ReceiveChain), D2B enabled by PlanChains
 
-    double I_D5subAccA[5] {0,0,0,0,0,};
-    double Q_D5subAccA[5] {0,0,0,0,0,};
-    double I_D5subAccB[5] {0,0,0,0,0,};
-    double Q_D5subAccB[5] {0,0,0,0,0,};
-    int D5stage = 0;
-    int D5_OP = 0;
-    for(int loop = 0; loop < INPUT_BUFFER_SIZE/RateIndex; loop++)
+    if(Pipelined)
     {
-
-        // shift in a new sample to subfilter
-        for(int index = (D5_Order/5)-1; index >= 0 ; index--)
-        {
-            if(index != 0)
-            {
-                I_D5A[D5stage][index] = I_D5A[D5stage][index-1];
-                Q_D5A[D5stage][index] = Q_D5A[D5stage][index-1];
-                I_D5B[D5stage][index] = I_D5B[D5stage][index-1];
-                Q_D5B[D5stage][index] = Q_D5B[D5stage][index-1];
-            }
-            else
-            {
-                I_D5A[D5stage][0] = I_BufferA[loop*RateIndex];
-                Q_D5A[D5stage][0] = Q_BufferA[loop*RateIndex];
-                I_D5B[D5stage][0] = I_BufferB[loop*RateIndex];
-                Q_D5B[D5stage][0] = Q_BufferB[loop*RateIndex];
-            }
-        }
-        // multiply and accumulate subfilter
-        I_D5subAccA[D5stage] = 0; Q_D5subAccA[D5stage] = 0;
-        I_D5subAccB[D5stage] = 0; Q_D5subAccB[D5stage] = 0;
-        for(int index = 0; index < (D5_Order/5); index++)
-        {
-            I_D5subAccA[D5stage] += (I_D5A[D5stage][index] * D5Coef[(4-D5stage)+(index*5)]);
-            Q_D5subAccA[D5stage] += (Q_D5A[D5stage][index] * D5Coef[(4-D5stage)+(index*5)]);
-            I_D5subAccB[D5stage] += (I_D5B[D5stage][index] * D5Coef[(4-D5stage)+(index*5)]);
-            Q_D5subAccB[D5stage] += (Q_D5B[D5stage][index] * D5Coef[(4-D5stage)+(index*5)]);
-        }
-        D5stage += 1;
-        if(D5stage >= 5)
+        // Mixer/D2 each pass here and hand it on, the rest of the chain and the output run on the pipeline
+        for(int Start = 0; Start < Assembler->FrameSize; Start += FILTER_BLOCK_SIZE)
         {
-            // accumulate all subfilters and output
-            I_D5FilterOutA[(loop/5)] = I_D5subAccA[0] + I_D5subAccA[1] + I_D5subAccA[2] + I_D5subAccA[3] + I_D5subAccA[4];
-            Q_D5FilterOutA[(loop/5)] = Q_D5subAccA[0] + Q_D5subAccA[1] + Q_D5subAccA[2] + Q_D5subAccA[3] + Q_D5subAccA[4];
-            I_D5FilterOutB[(loop/5)] = I_D5subAccB[0] + I_D5subAccB[1] + I_D5subAccB[2] + I_D5subAccB[3] + I_D5subAccB[4];
-            Q_D5FilterOutB[(loop/5)] = Q_D5subAccB[0] + Q_D5subAccB[1] + Q_D5subAccB[2] + Q_D5subAccB[3] + Q_D5subAccB[4];
-            D5stage = 0;
-            D5_OP++;  // inc D5 filter O/P size
+            const short *Pass[2] = { Assembler->FrameA + Start, Assembler->FrameB + Start };
+            auto *Slot = Chains.PipelineAB.Claim();
+            Chains.AB.template ProcessPass<1>(Pass, std::min(FILTER_BLOCK_SIZE, Assembler->FrameSize - Start), *Slot);
+            Chains.PipelineAB.Publish();
         }
     }
-
-    // Decimated by 5 output (100KHz/200KHz) now in I/Q_D5FilterOut
-
-
-    // Perform Polyphase upsample by 6 filter (US6)
-
-    double I_AccumulatorA = 0;
-    double Q_AccumulatorA = 0;
-    double I_AccumulatorB = 0;
-    double Q_AccumulatorB = 0;
-    int US6_OP = 0;
-
-    for(int x = 0; x < D5_OP; x++)  // loop D5 output size
+    else if(ChannelB.Running())
     {
-        // shift in new sample to filter register (size US6_Order/6)
-        for(int SR = (US6_Order/6)-1; SR >= 0; SR--)
-        {
-            if(SR != 0)
-            {
-                I_US6A[SR] = I_US6A[SR-1]; Q_US6A[SR] = Q_US6A[SR-1];
-                I_US6B[SR] = I_US6B[SR-1]; Q_US6B[SR] = Q_US6B[SR-1];
-            }
-            else
-            {
-                I_US6A[0] = I_D5FilterOutA[x]; Q_US6A[0] = Q_D5FilterOutA[x];
-                I_US6B[0] = I_D5FilterOutB[x]; Q_US6B[0] = Q_D5FilterOutB[x];
-            }
-        }
-        //loop 6 times to multiply / accumulate and output upsampled samples
-        for(int loop = 0; loop < 6; loop++)
-        {
-            I_AccumulatorA = 0; Q_AccumulatorA = 0;
-            I_AccumulatorB = 0; Q_AccumulatorB = 0;
-            for(int index = 0; index < (US6_Order/6); index++)
-            {
-                I_AccumulatorA += (I_US6A[index] * US6Coef[loop+(index*6)]);
-                Q_AccumulatorA += (Q_US6A[index] * US6Coef[loop+(index*6)]);
-                I_AccumulatorB += (I_US6B[index] * US6Coef[loop+(index*6)]);
-                Q_AccumulatorB += (Q_US6B[index] * US6Coef[loop+(index*6)]);
-            }
-            I_US6FilterOutA[US6_OP+loop] = I_AccumulatorA * 6; // adjust gain
-            Q_US6FilterOutA[US6_OP+loop] = Q_AccumulatorA * 6;
-            I_US6FilterOutB[US6_OP+loop] = I_AccumulatorB * 6;
-            Q_US6FilterOutB[US6_OP+loop] = Q_AccumulatorB * 6;
-        }
-        US6_OP += 6; // inc US6 filter output size
+        // channel B on the ChannelB thread while channel A is filtered here, both are complete after Join() so the
+        // circular buffers always get A and B samples of the same frame
+        ChannelB.Fork();
+        const short *Input[1] = { Assembler->FrameA };
+        Chains.A.Process(Input, Assembler->FrameSize, Chains.OutputA);
+        ChannelB.Join();
+
+        typename decltype(Chains.OutputA)::Sample *I[2] = { Chains.OutputA.I[0], Chains.OutputB.I[0] };
+        typename decltype(Chains.OutputA)::Sample *Q[2] = { Chains.OutputA.Q[0], Chains.OutputB.Q[0] };
+        FormatOutputAB(I, Q, Chains.OutputA.Count);
+    }
+    else
+    {
+        const short *Input[2] = { Assembler->FrameA, Assembler->FrameB };   // channel B sample aligned with channel A
+        auto &Output = Chains.AB.Process(Input, Assembler->FrameSize, Chains.OutputAB);
+        FormatOutputAB(Output.I, Output.Q, Output.Count);
     }
 
+    // pipelined, the load is that of the busiest stage thread rather than this thread's share of the work
+    double time_taken = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if(Pipelined) time_taken = Chains.PipelineAB.Slowest();
+    ProcessTimes->append(time_taken);
 
-    // Upsample by 6 Decimate 5 (120KHz/240KHz) output now in I/Q_US6FilterOut index * 5;
-
-
-    // Perform Polyphase upsample by 4 filter (US4)
+    //qDebug() << "DSP2 time = " + QString::number(time_taken);
 
-    I_AccumulatorA = 0;
-    Q_AccumulatorA = 0;
-    I_AccumulatorB = 0;
-    Q_AccumulatorB = 0;
-    int US4_OP = 0;
+}
 
-    for(int x = 0; x < US6_OP; x += 5)  // decimate by 5, using US6 filter output size
-    {
 
-        // shift in new sample to filter register (size US4_Order/4)
-        for(int SR = (US4_Order/4)-1; SR >= 0; SR--)
-        {
-            if(SR != 0)
-            {
-                I_US4A[SR] = I_US4A[SR-1]; Q_US4A[SR] = Q_US4A[SR-1];
-                I_US4B[SR] = I_US4B[SR-1]; Q_US4B[SR] = Q_US4B[SR-1];
-            }
-            else
-            {
-                I_US4A[0] = I_US6FilterOutA[x]; Q_US4A[0] = Q_US6FilterOutA[x];
-                I_US4B[0] = I_US6FilterOutB[x]; Q_US4B[0] = Q_US6FilterOutB[x];
-            }
-        }
-        //loop 4 times to multiply / accumulate and output upsampled samples
-        for(int loop = 0; loop < 4; loop++)
-        {
-            I_AccumulatorA = 0; Q_AccumulatorA = 0;
-            I_AccumulatorB = 0; Q_AccumulatorB = 0;
-            for(int index = 0; index < (US4_Order/4); index++)
-            {
-                I_AccumulatorA += (I_US4A[index] * US4Coef[loop+(index*4)]);
-                Q_AccumulatorA += (Q_US4A[index] * US4Coef[loop+(index*4)]);
-                I_AccumulatorB += (I_US4B[index] * US4Coef[loop+(index*4)]);
-                Q_AccumulatorB += (Q_US4B[index] * US4Coef[loop+(index*4)]);
-            }
-            I_US4FilterOutA[US4_OP+loop] = I_AccumulatorA * 4; // adjust gain
-            Q_US4FilterOutA[US4_OP+loop] = Q_AccumulatorA * 4;
-            I_US4FilterOutB[US4_OP+loop] = I_AccumulatorB * 4;
-            Q_US4FilterOutB[US4_OP+loop] = Q_AccumulatorB * 4;
-        }
-        US4_OP += 4; // inc output pointer
-    }
+void DSPthread::FormatOutputAB(float *const *I, float *const *Q, int Count)
+{
 
-    // Upsampled by 4 Decimated by 5 (96KHz/192KHz) output in I/Q_US4FilterOut index * 5
+    float *I_US4FilterOutA = I[0];   // 96KHz/192KHz output, the US4 stage
+    float *Q_US4FilterOutA = Q[0];
+    float *I_US4FilterOutB = I[1];
+    float *Q_US4FilterOutB = Q[1];
+    int Output_OP = Count;
 
 
     // Save US4FilterOut (Soundcard Format Spectrum) in SoundCardOut buffers
 
-    for(int loop = 0; loop < US4_OP; loop+=5)  // (decimating by five)
+    for(int loop = 0; loop < Output_OP; loop++)
         {
             I_SoundCardOutA[loop] = I_US4FilterOutA[loop];
             Q_SoundCardOutA[loop] = Q_US4FilterOutA[loop];
@@ -842,13 +813,13 @@ void DSPthread::ProcessBufferAB(void)
         }
 
 
-    // Rotate spectrum 180 degrees (pi) to MAP65 (TIMF2) format (in-place using US4 buffer index 5)
+    // Rotate spectrum 180 degrees (pi) to MAP65 (TIMF2) format (in-place in US4 buffer)
 
     double IoutA, QoutA, IoutB, QoutB;
     static double PhaseAcc = 0;
     double PhaseInc = M_PI;
 
-    for(int loop = 0; loop < US4_OP; loop+=5)
+    for(int loop = 0; loop < Output_OP; loop++)
     {
         // incremet the tuner oscillator each sample period
         PhaseAcc += PhaseInc;
@@ -864,9 +835,9 @@ void DSPthread::ProcessBufferAB(void)
     }
 
 
-    // Move Output Data to Circular Output Buffers, decimated by 5
+    // Move Output Data to Circular Output Buffers
 
-    for(int loop = 0; loop < US4_OP; loop+=5)
+    for(int loop = 0; loop < Output_OP; loop++)
     {
         I_CircularOutputBufferA[InPoint] = I_US4FilterOutA[loop];
         Q_CircularOutputBufferA[InPoint] = Q_US4FilterOutA[loop];
@@ -891,16 +862,43 @@ void DSPthread::ProcessBufferAB(void)
         if(InPoint >= CircularOutputBufferSize) InPoint = 0;
     }
 
-    Finished = 1; // Flag completion of DSP processing for this buffer
+}
+
 
-    end = clock();
-    double time_taken = double(end - start) / double(CLOCKS_PER_SEC);
-    ProcessTimes->append(time_taken);
+void DSPthread::FormatOutputAB(int *const *I, int *const *Q, int Count)
+{
+    // as for the float chain, in int16: the sound card buffers take the output as it is, the UDP buffers the same
+    // rotated 180 degrees to MAP65 (TIMF2) format, which negates I and Q on alternate samples
 
-    //qDebug() << "DSP2 time = " + QString::number(time_taken);
+    static bool Rotated = false;
 
-}
+    for(int loop = 0; loop < Count; loop++)
+    {
+        short IA = MAC<int>::ToInt16(I[0][loop]), QA = MAC<int>::ToInt16(Q[0][loop]);
+        short IB = MAC<int>::ToInt16(I[1][loop]), QB = MAC<int>::ToInt16(Q[1][loop]);
+        Rotated = !Rotated;
 
+        I_CircularOutputBufferA16[InPoint] = Rotated ? Negated(IA) : IA;
+        Q_CircularOutputBufferA16[InPoint] = Rotated ? QA : Negated(QA);
 
+        if(DuplicateA == 1) // Duplicate channle A in channel B
+        {
+            I_CircularOutputBufferB16[InPoint] = I_CircularOutputBufferA16[InPoint];
+            Q_CircularOutputBufferB16[InPoint] = Q_CircularOutputBufferA16[InPoint];
+        }
+        else
+        {
+            I_CircularOutputBufferB16[InPoint] = Rotated ? Negated(IB) : IB;
+            Q_CircularOutputBufferB16[InPoint] = Rotated ? QB : Negated(QB);
+        }
+
+        I_CircularOutputBufferSCA[InPoint] = IA;
+        Q_CircularOutputBufferSCA[InPoint] = QA;
+        I_CircularOutputBufferSCB[InPoint] = IB;
+        Q_CircularOutputBufferSCB[InPoint] = QB;
 
+        InPoint++;
+        if(InPoint >= CircularOutputBufferSize) InPoint = 0;
+    }
 
+}
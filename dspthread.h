@@ -13,18 +13,25 @@
 #ifndef DSPTHREAD_H
 #define DSPTHREAD_H
 
-#include "rspduointerface.h"
+#include "samplesource.h"
+#include "frameassembler.h"
+#include "wakeup.h"
+#include "filters.h"
+#include "multirate.h"
+#include "pipeline.h"
+#include "forkjoin.h"
 
 #include <bits/stdc++.h> //for timimg
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 
 #include <QObject>
-#include <QTimer>
+#include <QMetaType>
 
-extern short (*A_InputBuffer)[INPUT_BUFFER_SIZE];  // pointer to channel A input array [BufferNo][Buffer]
-extern short (*B_InputBuffer)[INPUT_BUFFER_SIZE];  // pointer to channel B input array [BufferNo][Buffer]
+Q_DECLARE_METATYPE(BlockStats)
 
-extern volatile int A_LastBuffer;      // Last Input Buffer number for channel A
-extern volatile int B_LastBuffer;      // Last Input Buffer number for channel B
 
 class DSPthread : public QObject
 {
@@ -34,65 +41,153 @@ public:
     ~DSPthread();
 
     int SampleRate = 96000;      // selected sample rate, default to 96000
-    int BufferNo = 0;            // current InputBuffer number, set by caller
-    int PreviousLastBuffer = 0;  // copy of previous channel A input buffer number
-    int DSPMode = 0;             // Mode for DSP process, 0=Off, 1=Channel A, 2=Channels A and B
+    FrameAssembler *Assembler;   // pointer to A/B input frame assembler
+    volatile int DSPMode = 0;    // Mode for DSP process, 0=Off, 1=Channel A, 2=Channels A and B
     int DuplicateA = 0;          // duplicate channel A in channel B if = 1
     int TIMF2Output = 0;         // Linrad TIMF2 UDP output = 1, else 0
     int RAW16Output = 0;         // Linrad RAW16 UDP Output = 1, else 0
     int SoundCardOutput = 0;     // Sound Card Output, 1 = 2 Audio Channels, 2 = 4 Audio Channels, else 0
-    volatile int Finished = 1;   // Flag = 1 to indicate processin has finished
+    int Pipelined = 0;           // run the filter stages on a pipeline of threads = 1, all on this thread = 0
+    int FrontEnd = 0;            // first decimation from 2MHz, 0 = D2A/D2B FIR, 1 = CIC and compensation filter
+    int FixedPoint = 0;          // filter chain arithmetic, 0 = float, 1 = fixed point (FixedPointChain, int16 output)
+    QString StageFilters;        // designs for the D2B, D5, US6 and US4 stages, "NAME=spec;..." (see LoadDesigns), empty for filters.h
     QList<double> *ProcessTimes; // pointer to list of process times for performance measurement
+    WakeUp DataReady;            // notified by the input rings, or to make Run() check DSPMode and queued slots
 
 
     int CircularOutputBufferSize = 96000;  // 500mS @ 192Khz rate (192000 samples / 2)
-    double *I_CircularOutputBufferA;       // pointers to Circular Output Buffer for Ch A UDP Mode
-    double *Q_CircularOutputBufferA;
-    double *I_CircularOutputBufferB;       // pointers to Circular Output Buffer for Ch B UDP Mode
-    double *Q_CircularOutputBufferB;
-    double *I_CircularOutputBufferSCA;     // pointers to Circular Output Buffers for Sound Card
-    double *Q_CircularOutputBufferSCA;
-    double *I_CircularOutputBufferSCB;
-    double *Q_CircularOutputBufferSCB;
+    float *I_CircularOutputBufferA;        // pointers to Circular Output Buffer for Ch A UDP Mode
+    float *Q_CircularOutputBufferA;
+    float *I_CircularOutputBufferB;        // pointers to Circular Output Buffer for Ch B UDP Mode
+    float *Q_CircularOutputBufferB;
+    short *I_CircularOutputBufferA16;      // the same from the fixed point chain, in its place when FixedPoint = 1
+    short *Q_CircularOutputBufferA16;
+    short *I_CircularOutputBufferB16;
+    short *Q_CircularOutputBufferB16;
+    short *I_CircularOutputBufferSCA;      // pointers to Circular Output Buffers for Sound Card
+    short *Q_CircularOutputBufferSCA;
+    short *I_CircularOutputBufferSCB;
+    short *Q_CircularOutputBufferSCB;
     volatile int InPoint = 0;              // input pointer for Circular Output Buffers
 
+    void SetPhases(double Aphase, double Bphase);   // new tuner phases from any thread, Run() applies them between frames
+    void RunQueued(void);        // count a Run() about to be queued by StartDSP, so WaitStopped waits for it
+    void WaitStopped(void);      // set DSPMode to 0 and block until every queued Run() has returned
+
 public slots:
 
-    void onTimer(void);
-    void GenerateSinCosTable(double Aphase, double Bphase);
+    void Run(void);
+    void ResetState(void);
     void ProcessBufferA(void);
     void ProcessBufferAB(void);
 
 signals:
 
     void StatusMessage(QString);
+    void InputStats(BlockStats, BlockStats);   // channel A and B input statistics, every 100mS of input
 
 private:
 
-    QTimer *Timer;                // pointer to Timer Object
-
-    clock_t start, end;           // for interval time measurement
-
-    double *I_BufferA;            // pointers to I buffer Ch A
-    double *Q_BufferA;
-    double *I_BufferB;            // pointers to I buffer Ch B
-    double *Q_BufferB;
-    double *I_D5FilterOutA;       // pointers to D5 filter output Ch A
-    double *Q_D5FilterOutA;
-    double *I_D5FilterOutB;       // pointers to D5 filter output Ch B
-    double *Q_D5FilterOutB;
-    double *I_US6FilterOutA;      // pointer to US6 filter output Ch A
-    double *Q_US6FilterOutA;
-    double *I_US6FilterOutB;      // pointer to US6 filter output Ch B
-    double *Q_US6FilterOutB;
-    double *I_US4FilterOutA;      // pointer to US4 filter output Ch A
-    double *Q_US4FilterOutA;
-    double *I_US4FilterOutB;      // pointer to US4 filter output Ch B
-    double *Q_US4FilterOutB;
-    double *I_SoundCardOutA;      // pointer to Sound Card device output Buffers
-    double *Q_SoundCardOutA;
-    double *I_SoundCardOutB;
-    double *Q_SoundCardOutB;
+    void GenerateSinCosTable(double Aphase, double Bphase);   // tuner tables, folded into the D2A stage of each chain
+    void ApplyPhases(void);       // regenerate the tuner tables if SetPhases has been called since
+    void CheckKernels(void);      // validate and report the FIR kernels and FFT filters, once
+    bool PlanChains(void);        // plan the filter stages for the input block size and report the plan, false if the settings cannot run
+    void LoadDesigns(void);       // load the StageFilters designs into the stage tables, or filters.h where there are none
+    void ReportAlignment(void);   // report any change in A/B input alignment
+    void ReportOverrun(void);     // report input overruns and a growing backlog
+    void ReportStats(void);       // collect frame input statistics and send them on every 100mS
+    void StopPipeline(void);      // drain and stop the stage threads
+    void ReportPipeline(void);    // report the pipeline stage utilisation every 10S of input
+
+    // on the chains of one arithmetic (a ChainSet below), ProcessBufferA/AB run them on Float or Fixed
+    template<typename Set> void ProcessFrameA(Set &Chains);
+    template<typename Set> void ProcessFrameAB(Set &Chains);
+    template<typename Set> void StartPipeline(Set &Chains, int Mode);   // stage threads for DSP mode 1 or 2, if not already running
+    template<typename Set> void StartChannelB(Set &Chains);             // channel B thread for concurrent A/B filtering, if there are 2 cores
+
+    std::mutex RunLock;                        // guards RunsPending
+    std::condition_variable RunsDone;          // notified as each Run() returns
+    int RunsPending = 0;                       // Run() calls queued or active
+    std::mutex PhaseLock;                      // guards PendingA/B between SetPhases and ApplyPhases
+    double PendingA = 0;                       // tuner phases from the last SetPhases
+    double PendingB = 0;
+    std::atomic<bool> PhasesPending {false};   // SetPhases called since the last ApplyPhases
+    bool KernelsChecked = false;               // FIR kernels validated and reported
+    unsigned long long ReportedDroppedB = 0;   // alignment counters at last report
+    unsigned long long ReportedPaddedB = 0;
+    unsigned long long ReportedGaps = 0;
+    unsigned long long ReportedResyncs = 0;
+    unsigned long long ReportedOverruns = 0;   // overrun counter at last report
+    unsigned int ReportedBacklog = 0;          // largest backlog reported so far
+    BlockStats IntervalA;                      // input statistics collected since the last InputStats
+    BlockStats IntervalB;
+    long long PipelineSamples = 0;             // input samples fed to the pipeline since the last report
+
+    std::chrono::steady_clock::time_point start;   // for interval time measurement
+
+    // receive filter chain, 2MHz real input down to 96KHz/192KHz complex: tuner and decimate by 2 in one complex
+    // band-pass filter (D2A), decimate by 2 (D2B, 96KHz only), decimate by 5 (D5), then resample by 24/25 as
+    // upsample by 6 (US6) and upsample by 4 (US4) each keeping every 5th output. With the CIC front end the first
+    // stage mixes and decimates by 4 (96KHz) or 2 (192KHz) itself, and D2B is bypassed.
+    template<int Channels>
+    using ReceiveChain = Chain<Mixer<2, D2A_Order, float, Channels>,
+                               Decimator<2, D2B_Order, float, Channels>,
+                               Decimator<5, D5_Order, float, Channels>,
+                               Interpolator<6, US6_Order, float, Channels, 5>,
+                               Interpolator<4, US4_Order, float, Channels, 5>>;
+
+    // the same chain in fixed point: int32 samples with MAC<int>::Fraction bits below the input count between the
+    // stages, Q15 coefficients, the int16 input mixed on the Q15 kernels; rounded to int16 for the output buffers
+    // (see fixedpoint.h for its accuracy). Direct form with the D2A/D2B front end only, Run() will not start it
+    // with the CIC front end or FFT filters forced on.
+    template<int Channels>
+    using FixedPointChain = Chain<Mixer<2, D2A_Order, int, Channels>,
+                                  Decimator<2, D2B_Order, int, Channels>,
+                                  Decimator<5, D5_Order, int, Channels>,
+                                  Interpolator<6, US6_Order, int, Channels, 5>,
+                                  Interpolator<4, US4_Order, int, Channels, 5>>;
+
+    // designs loaded by LoadDesigns for the D2B, D5, US6 and US4 stages of the chains, float for the ReceiveChains
+    // and Q15 for the FixedPointChains, each at its own length; a stage with none (Taps 0) runs on filters.h
+    template<typename T>
+    struct StageTables
+    {
+        PolyphaseVector<T, 2> D2B;
+        PolyphaseVector<T, 5> D5;
+        PolyphaseVector<T, 6> US6;
+        PolyphaseVector<T, 4> US4;
+    };
+    StageTables<float> Tables;
+    StageTables<int> TablesQ15;
+
+    // the chains of one arithmetic with their output buffers and pipelines. Pipelined: Mixer/D2 on this thread, D5,
+    // the resampler (US6 and US4) and the output formatting on threads of their own, passes of FILTER_BLOCK_SIZE
+    // input samples handed on through queues of PIPELINE_DEPTH slots
+    template<template<int> class ChainType>
+    struct ChainSet
+    {
+        ChainType<1> A;                   // Ch A (DSP mode 1, or mode 2 with A and B concurrent), state carried from frame to frame
+        ChainType<1> B;                   // Ch B (DSP mode 2 with A and B concurrent), run on ChannelB
+        ChainType<2> AB;                  // Ch A and B in step (DSP mode 2 on a single core)
+        typename ChainType<1>::Buffer OutputA;   // chain output for one frame
+        typename ChainType<1>::Buffer OutputB;
+        typename ChainType<2>::Buffer OutputAB;
+        Pipeline<typename ChainType<1>::Buffer> PipelineA;
+        Pipeline<typename ChainType<2>::Buffer> PipelineAB;
+    };
+    ChainSet<ReceiveChain> Float;
+    ChainSet<FixedPointChain> Fixed;
+    ForkJoin ChannelB;                    // filters the channel B frame while this thread filters channel A
+
+    void FormatOutputA(ReceiveChain<1>::Buffer &Output);    // chain output to the circular output buffers
+    void FormatOutputAB(float *const *I, float *const *Q, int Count);
+    void FormatOutputA(FixedPointChain<1>::Buffer &Output);
+    void FormatOutputAB(int *const *I, int *const *Q, int Count);
+
+    float *I_SoundCardOutA;       // pointer to Sound Card device output Buffers
+    float *Q_SoundCardOutA;
+    float *I_SoundCardOutB;
+    float *Q_SoundCardOutB;
     double *SinTableA;            // pointer to array of Sin values for tuning channel A
     double *CosTableA;            // pointer to array of Cos values for tuning channel A
     double *SinTableB;            // pointer to array of Sin values for tuning channel B
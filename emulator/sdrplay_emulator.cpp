@@ -0,0 +1,474 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+// Stand in for the SDRplay API library, emulating one RSPduo in dual tuner mode.
+//
+// Exports the same functions as sdrplay_api.dll / libsdrplay_api.so so RSPduoEME links and runs unchanged. After
+// sdrplay_api_Init a streaming thread calls the registered stream callbacks with packets of real IF samples from the
+// synthetic EME signal generator (2MHz, 450KHz IF) at real time pace, and the event callback with gain change,
+// power overload and device removed events. The emulation is set through environment variables read by
+// sdrplay_api_Open:
+//
+//   SDRPLAY_EMU_PACKET    samples per stream callback (default 1008)
+//   SDRPLAY_EMU_JITTER    maximum random lateness of each callback in uS (default 1000)
+//   SDRPLAY_EMU_STALL     length in mS of a stall in the callbacks every 10 seconds (default 0, none)
+//   SDRPLAY_EMU_DROP      drop one packet in this many, leaving a gap in firstSampleNum (default 0, none)
+//   SDRPLAY_EMU_OVERLOAD  seconds between power overload detected / corrected events (default 0, none)
+//   SDRPLAY_EMU_REMOVE    seconds after Init to report the device removed and stop streaming (default 0, never)
+//   SDRPLAY_EMU_SEED      signal generator seed (default 1)
+//
+// A summary of the callback timing is printed to stderr by sdrplay_api_Uninit.
+
+
+
+#include "sdrplay_api.h"
+#include "signalgenerator.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+
+
+struct EmulatorSettings
+{
+    int Packet = 1008;                      // samples per stream callback
+    int Jitter = 1000;                      // maximum callback lateness (uS)
+    int Stall = 0;                          // stall length every 10 seconds (mS)
+    int Drop = 0;                           // drop one packet in this many
+    double Overload = 0;                    // seconds between overload events
+    double Remove = 0;                      // seconds after Init to remove the device
+    unsigned int Seed = 1;                  // generator seed
+};
+
+
+struct EmulatedDevice
+{
+    bool Open = false;                      // sdrplay_api_Open called
+    bool Selected = false;                  // device selected
+    bool Initialised = false;               // streaming
+
+    sdrplay_api_DevParamsT DevParams;
+    sdrplay_api_RxChannelParamsT ChannelA;
+    sdrplay_api_RxChannelParamsT ChannelB;
+    sdrplay_api_DeviceParamsT Params;
+
+    sdrplay_api_CallbackFnsT Callbacks;
+    void *Context = nullptr;
+
+    std::atomic<int> GainA {50};            // gain reduction in force on each tuner (dB)
+    std::atomic<int> GainB {50};
+    std::atomic<int> GainChanged {0};       // tuners with a gain change to report (bit 0 = A, bit 1 = B)
+    std::atomic<bool> RfChanged {false};    // frequency change to flag in the next packet
+    std::atomic<bool> OverloadAcked {true}; // application has acknowledged the last overload event
+
+    std::thread Streamer;
+    std::atomic<bool> Running {false};
+
+    unsigned long long Packets = 0;         // timing summary for Uninit
+    unsigned long long Dropped = 0;
+    double MaxLate = 0;
+    double TotalLate = 0;
+};
+
+
+static EmulatorSettings Settings;
+static EmulatedDevice Device;
+static sdrplay_api_ErrorInfoT LastError;
+
+
+static int Environment(const char *Name, int Default)
+{
+    const char *Value = getenv(Name);
+    return (Value != nullptr) ? atoi(Value) : Default;
+}
+
+
+static double EnvironmentDouble(const char *Name, double Default)
+{
+    const char *Value = getenv(Name);
+    return (Value != nullptr) ? atof(Value) : Default;
+}
+
+
+static void SetDefaultParams(void)
+{
+    memset(&Device.DevParams, 0, sizeof(Device.DevParams));
+    memset(&Device.ChannelA, 0, sizeof(Device.ChannelA));
+    memset(&Device.ChannelB, 0, sizeof(Device.ChannelB));
+
+    Device.DevParams.fsFreq.fsHz = 2000000.0;
+    Device.DevParams.mode = sdrplay_api_ISOCH;
+    Device.DevParams.samplesPerPkt = Settings.Packet;
+
+    sdrplay_api_RxChannelParamsT *Channels[2] = {&Device.ChannelA, &Device.ChannelB};
+    for(sdrplay_api_RxChannelParamsT *Channel : Channels)
+    {
+        Channel->tunerParams.bwType = sdrplay_api_BW_0_200;
+        Channel->tunerParams.ifType = sdrplay_api_IF_0_450;
+        Channel->tunerParams.loMode = sdrplay_api_LO_Auto;
+        Channel->tunerParams.gain.gRdB = 50;
+        Channel->tunerParams.gain.minGr = sdrplay_api_NORMAL_MIN_GR;
+        Channel->tunerParams.rfFreq.rfHz = 200000000.0;
+        Channel->ctrlParams.decimation.decimationFactor = 1;
+    }
+
+    Device.Params.devParams = &Device.DevParams;
+    Device.Params.rxChannelA = &Device.ChannelA;
+    Device.Params.rxChannelB = &Device.ChannelB;
+}
+
+
+static void SendEvent(sdrplay_api_EventT Event, sdrplay_api_TunerSelectT Tuner, sdrplay_api_EventParamsT *Params)
+{
+    if(Device.Callbacks.EventCbFn != nullptr) Device.Callbacks.EventCbFn(Event, Tuner, Params, Device.Context);
+}
+
+
+static void SendGainChange(sdrplay_api_TunerSelectT Tuner, int gRdB, int LNAstate)
+{
+    sdrplay_api_EventParamsT Params;
+    Params.gainParams.gRdB = gRdB;
+    Params.gainParams.lnaGRdB = LNAstate * 6;                      // nominal, the real LNA steps vary with band
+    Params.gainParams.currGain = 100.0 - gRdB - Params.gainParams.lnaGRdB;
+    SendEvent(sdrplay_api_GainChange, Tuner, &Params);
+}
+
+
+// scale one channel of the generator output for the gain reduction in force on that tuner
+static void ApplyGain(short *Samples, int Count, int gRdB)
+{
+    float Scale = (float)pow(10.0, (40 - gRdB) / 20.0);           // generator levels are set for 40dB gain reduction
+    for(int loop = 0; loop < Count; loop++)
+    {
+        float Value = Samples[loop] * Scale;
+        Value = (Value > 32767.0f) ? 32767.0f : ((Value < -32768.0f) ? -32768.0f : Value);
+        Samples[loop] = (short)Value;
+    }
+}
+
+
+static void Stream(void)
+{
+    GeneratorSettings Signal;
+    Signal.Seed = Settings.Seed;
+    SignalGenerator Generator(Signal);
+
+    short *xiA = new short[Settings.Packet];
+    short *xiB = new short[Settings.Packet];
+    short *xq = new short[Settings.Packet];             // low IF mode, the application only uses xi
+    memset(xq, 0, Settings.Packet * sizeof(short));
+
+    std::mt19937 Random(Settings.Seed);
+    std::uniform_int_distribution<int> Lateness(0, Settings.Jitter > 0 ? Settings.Jitter : 0);
+
+    const double PacketTime = Settings.Packet / SignalGenerator::SampleRate;
+    unsigned int SampleNum = 0;
+    bool Overloaded = false;
+    double NextOverload = Settings.Overload;
+    bool FirstPacket = true;
+
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+    SendGainChange(sdrplay_api_Tuner_A, Device.GainA, Device.ChannelA.tunerParams.gain.LNAstate);
+    SendGainChange(sdrplay_api_Tuner_B, Device.GainB, Device.ChannelA.tunerParams.gain.LNAstate);
+
+    for(unsigned long long Packet = 0; Device.Running; Packet++)
+    {
+        double Due = Packet * PacketTime;
+
+        // a stall holds back every packet due in its window, they then arrive in a burst
+        if(Settings.Stall > 0)
+        {
+            double Period = fmod(Due, 10.0);
+            if((Due >= 10.0) && (Period < Settings.Stall / 1000.0)) Due += Settings.Stall / 1000.0 - Period;
+        }
+
+        std::chrono::steady_clock::time_point When = Start + std::chrono::microseconds((long long)(Due * 1e6) + Lateness(Random));
+        std::this_thread::sleep_until(When);
+        if(!Device.Running) break;
+
+        double Late = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count() - Packet * PacketTime;
+        if(Late > Device.MaxLate) Device.MaxLate = Late;
+        Device.TotalLate += Late;
+        Device.Packets++;
+
+        // device removal ends streaming, as when the USB cable is pulled
+        if((Settings.Remove > 0) && (Due >= Settings.Remove))
+        {
+            SendEvent(sdrplay_api_DeviceRemoved, sdrplay_api_Tuner_Both, nullptr);
+            break;
+        }
+
+        // power overload events, a new one is only sent once the last has been acknowledged
+        if((Settings.Overload > 0) && (Due >= NextOverload) && Device.OverloadAcked)
+        {
+            sdrplay_api_EventParamsT Params;
+            Overloaded = !Overloaded;
+            Params.powerOverloadParams.powerOverloadChangeType = Overloaded ? sdrplay_api_Overload_Detected :
+                                                                              sdrplay_api_Overload_Corrected;
+            Device.OverloadAcked = false;
+            SendEvent(sdrplay_api_PowerOverloadChange, sdrplay_api_Tuner_A, &Params);
+            NextOverload += Settings.Overload;
+        }
+
+        // gain changes requested through sdrplay_api_Update
+        int Changed = Device.GainChanged.exchange(0);
+        if(Changed & 1) SendGainChange(sdrplay_api_Tuner_A, Device.GainA, Device.ChannelA.tunerParams.gain.LNAstate);
+        if(Changed & 2) SendGainChange(sdrplay_api_Tuner_B, Device.GainB, Device.ChannelA.tunerParams.gain.LNAstate);
+
+        Generator.Generate(xiA, xiB, Settings.Packet);
+
+        if((Settings.Drop > 0) && ((Random() % Settings.Drop) == 0))
+        {
+            Device.Dropped++;                           // lost on the USB, the sample numbers jump
+        }
+        else
+        {
+            ApplyGain(xiA, Settings.Packet, Device.GainA);
+            ApplyGain(xiB, Settings.Packet, Device.GainB);
+
+            sdrplay_api_StreamCbParamsT Params;
+            Params.firstSampleNum = SampleNum;
+            Params.grChanged = Changed ? 1 : 0;
+            Params.rfChanged = Device.RfChanged.exchange(false) ? 1 : 0;
+            Params.fsChanged = FirstPacket ? 1 : 0;
+            Params.numSamples = Settings.Packet;
+
+            if(Device.Callbacks.StreamACbFn != nullptr)
+                Device.Callbacks.StreamACbFn(xiA, xq, &Params, Settings.Packet, FirstPacket, Device.Context);
+            if(Device.Callbacks.StreamBCbFn != nullptr)
+                Device.Callbacks.StreamBCbFn(xiB, xq, &Params, Settings.Packet, FirstPacket, Device.Context);
+            FirstPacket = false;
+        }
+
+        SampleNum += Settings.Packet;
+    }
+
+    delete[] xiA;
+    delete[] xiB;
+    delete[] xq;
+}
+
+
+// ---- Exported API ---- //
+
+sdrplay_api_ErrT sdrplay_api_Open(void)
+{
+    Settings.Packet = Environment("SDRPLAY_EMU_PACKET", Settings.Packet);
+    Settings.Jitter = Environment("SDRPLAY_EMU_JITTER", Settings.Jitter);
+    Settings.Stall = Environment("SDRPLAY_EMU_STALL", Settings.Stall);
+    Settings.Drop = Environment("SDRPLAY_EMU_DROP", Settings.Drop);
+    Settings.Overload = EnvironmentDouble("SDRPLAY_EMU_OVERLOAD", Settings.Overload);
+    Settings.Remove = EnvironmentDouble("SDRPLAY_EMU_REMOVE", Settings.Remove);
+    Settings.Seed = (unsigned int)Environment("SDRPLAY_EMU_SEED", (int)Settings.Seed);
+    if(Settings.Packet < 1) Settings.Packet = 1;
+
+    Device.Open = true;
+    return sdrplay_api_Success;
+}
+
+
+sdrplay_api_ErrT sdrplay_api_Close(void)
+{
+    if(Device.Initialised) return sdrplay_api_Fail;
+    Device.Open = false;
+    return sdrplay_api_Success;
+}
+
+
+sdrplay_api_ErrT sdrplay_api_ApiVersion(float *apiVer)
+{
+    if(apiVer == nullptr) return sdrplay_api_InvalidParam;
+    *apiVer = SDRPLAY_API_VERSION;
+    return sdrplay_api_Success;
+}
+
+
+sdrplay_api_ErrT sdrplay_api_LockDeviceApi(void)
+{
+    return Device.Open ? sdrplay_api_Success : sdrplay_api_NotInitialised;
+}
+
+
+sdrplay_api_ErrT sdrplay_api_UnlockDeviceApi(void)
+{
+    return Device.Open ? sdrplay_api_Success : sdrplay_api_NotInitialised;
+}
+
+
+sdrplay_api_ErrT sdrplay_api_GetDevices(sdrplay_api_DeviceT *devices, unsigned int *numDevs, unsigned int maxDevs)
+{
+    if(!Device.Open) return sdrplay_api_NotInitialised;
+    if((devices == nullptr) || (numDevs == nullptr)) return sdrplay_api_InvalidParam;
+
+    *numDevs = 0;
+    if(maxDevs < 1 || Device.Selected) return sdrplay_api_Success;     // a selected device is no longer listed
+
+    memset(&devices[0], 0, sizeof(sdrplay_api_DeviceT));
+    strcpy(devices[0].SerNo, "EMULATOR0001");
+    devices[0].hwVer = SDRPLAY_RSPduo_ID;
+    devices[0].tuner = sdrplay_api_Tuner_Both;
+    devices[0].rspDuoMode = (sdrplay_api_RspDuoModeT)(sdrplay_api_RspDuoMode_Single_Tuner |
+                                                      sdrplay_api_RspDuoMode_Dual_Tuner | sdrplay_api_RspDuoMode_Master);
+    *numDevs = 1;
+    return sdrplay_api_Success;
+}
+
+
+sdrplay_api_ErrT sdrplay_api_SelectDevice(sdrplay_api_DeviceT *device)
+{
+    if(!Device.Open) return sdrplay_api_NotInitialised;
+    if(device == nullptr) return sdrplay_api_InvalidParam;
+    if(Device.Selected) return sdrplay_api_AlreadyInitialised;
+    if(device->rspDuoMode != sdrplay_api_RspDuoMode_Dual_Tuner) return sdrplay_api_InvalidMode;   // only dual tuner emulated
+
+    SetDefaultParams();
+    device->dev = (HANDLE)&Device;
+    Device.Selected = true;
+    return sdrplay_api_Success;
+}
+
+
+sdrplay_api_ErrT sdrplay_api_ReleaseDevice(sdrplay_api_DeviceT *device)
+{
+    if((device == nullptr) || (device->dev != (HANDLE)&Device)) return sdrplay_api_InvalidParam;
+    if(Device.Initialised) return sdrplay_api_Fail;
+    Device.Selected = false;
+    return sdrplay_api_Success;
+}
+
+
+const char *sdrplay_api_GetErrorString(sdrplay_api_ErrT err)
+{
+    static const char *Strings[] = {"sdrplay_api_Success", "sdrplay_api_Fail", "sdrplay_api_InvalidParam",
+        "sdrplay_api_OutOfRange", "sdrplay_api_GainUpdateError", "sdrplay_api_RfUpdateError", "sdrplay_api_FsUpdateError",
+        "sdrplay_api_HwError", "sdrplay_api_AliasingError", "sdrplay_api_AlreadyInitialised", "sdrplay_api_NotInitialised",
+        "sdrplay_api_NotEnabled", "sdrplay_api_HwVerError", "sdrplay_api_OutOfMemError", "sdrplay_api_ServiceNotResponding",
+        "sdrplay_api_StartPending", "sdrplay_api_StopPending", "sdrplay_api_InvalidMode", "sdrplay_api_FailedVerification1",
+        "sdrplay_api_FailedVerification2", "sdrplay_api_FailedVerification3", "sdrplay_api_FailedVerification4",
+        "sdrplay_api_FailedVerification5", "sdrplay_api_FailedVerification6", "sdrplay_api_InvalidServiceVersion"};
+
+    if((err < 0) || (err >= (int)(sizeof(Strings) / sizeof(Strings[0])))) return "unknown error";
+    return Strings[err];
+}
+
+
+sdrplay_api_ErrorInfoT sdrplay_api_GetLastError(sdrplay_api_DeviceT *device)
+{
+    (void)device;
+    return LastError;
+}
+
+
+sdrplay_api_ErrT sdrplay_api_DebugEnable(HANDLE dev, unsigned int enable)
+{
+    (void)dev; (void)enable;
+    return sdrplay_api_Success;
+}
+
+
+sdrplay_api_ErrT sdrplay_api_GetDeviceParams(HANDLE dev, sdrplay_api_DeviceParamsT **deviceParams)
+{
+    if((dev != (HANDLE)&Device) || (deviceParams == nullptr)) return sdrplay_api_InvalidParam;
+    if(!Device.Selected) return sdrplay_api_NotInitialised;
+    *deviceParams = &Device.Params;
+    return sdrplay_api_Success;
+}
+
+
+sdrplay_api_ErrT sdrplay_api_Init(HANDLE dev, sdrplay_api_CallbackFnsT *callbackFns, void *cbContext)
+{
+    if((dev != (HANDLE)&Device) || (callbackFns == nullptr)) return sdrplay_api_InvalidParam;
+    if(!Device.Selected) return sdrplay_api_NotInitialised;
+    if(Device.Initialised) return sdrplay_api_AlreadyInitialised;
+    if(Device.DevParams.fsFreq.fsHz / Device.ChannelA.ctrlParams.decimation.decimationFactor != SignalGenerator::SampleRate ||
+       Device.ChannelA.tunerParams.ifType != sdrplay_api_IF_0_450)
+    {
+        snprintf(LastError.message, sizeof(LastError.message), "emulator only supports 450KHz IF at 2MHz output rate");
+        return sdrplay_api_InvalidParam;
+    }
+
+    Device.Callbacks = *callbackFns;
+    Device.Context = cbContext;
+    Device.GainA = Device.ChannelA.tunerParams.gain.gRdB;
+    Device.GainB = Device.ChannelA.tunerParams.gain.gRdB;
+    Device.GainChanged = 0;
+    Device.OverloadAcked = true;
+    Device.Packets = Device.Dropped = 0;
+    Device.MaxLate = Device.TotalLate = 0;
+
+    Device.Initialised = true;
+    Device.Running = true;
+    Device.Streamer = std::thread(Stream);
+    return sdrplay_api_Success;
+}
+
+
+sdrplay_api_ErrT sdrplay_api_Uninit(HANDLE dev)
+{
+    if(dev != (HANDLE)&Device) return sdrplay_api_InvalidParam;
+    if(!Device.Initialised) return sdrplay_api_NotInitialised;
+
+    Device.Running = false;
+    Device.Streamer.join();
+    Device.Initialised = false;
+
+    fprintf(stderr, "sdrplay_api emulator: %llu packets of %d samples, %llu dropped, lateness mean %.2fmS max %.2fmS\n",
+            Device.Packets, Settings.Packet, Device.Dropped,
+            Device.Packets ? 1000.0 * Device.TotalLate / Device.Packets : 0.0, 1000.0 * Device.MaxLate);
+    return sdrplay_api_Success;
+}
+
+
+sdrplay_api_ErrT sdrplay_api_Update(HANDLE dev, sdrplay_api_TunerSelectT tuner, sdrplay_api_ReasonForUpdateT reasonForUpdate,
+                                    sdrplay_api_ReasonForUpdateExtension1T reasonForUpdateExt1)
+{
+    (void)reasonForUpdateExt1;
+
+    if(dev != (HANDLE)&Device) return sdrplay_api_InvalidParam;
+    if(!Device.Initialised) return sdrplay_api_NotInitialised;
+
+    if(reasonForUpdate & sdrplay_api_Update_Tuner_Gr)
+    {
+        // as on the RSPduo, an update of both tuners applies the channel A parameters to both
+        int GainA = Device.ChannelA.tunerParams.gain.gRdB;
+        int GainB = (tuner == sdrplay_api_Tuner_B) ? Device.ChannelB.tunerParams.gain.gRdB : GainA;
+        if((GainA < 20) || (GainA > 59) || (GainB < 20) || (GainB > 59)) return sdrplay_api_OutOfRange;
+        if(tuner & sdrplay_api_Tuner_A) Device.GainA = GainA;
+        if(tuner & sdrplay_api_Tuner_B) Device.GainB = GainB;
+        Device.GainChanged |= tuner & sdrplay_api_Tuner_Both;
+    }
+
+    if(reasonForUpdate & sdrplay_api_Update_Tuner_Frf) Device.RfChanged = true;
+    if(reasonForUpdate & sdrplay_api_Update_Ctrl_OverloadMsgAck) Device.OverloadAcked = true;
+
+    return sdrplay_api_Success;
+}
+
+
+sdrplay_api_ErrT sdrplay_api_SwapRspDuoActiveTuner(HANDLE dev, sdrplay_api_TunerSelectT *currentTuner,
+                                                   sdrplay_api_RspDuo_AmPortSelectT tuner1AmPortSel)
+{
+    (void)dev; (void)currentTuner; (void)tuner1AmPortSel;
+    return sdrplay_api_InvalidMode;                     // only valid in single tuner mode
+}
+
+
+sdrplay_api_ErrT sdrplay_api_SwapRspDuoDualTunerModeSampleRate(HANDLE dev, double *currentSampleRate)
+{
+    (void)dev; (void)currentSampleRate;
+    return sdrplay_api_InvalidMode;                     // emulator runs at a fixed rate
+}
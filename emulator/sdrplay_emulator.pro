@@ -0,0 +1,27 @@
+#-------------------------------------------------
+#
+# sdrplay_api emulator: a stand in for the SDRplay API library so RSPduoEME can be run
+# end to end with no RSPduo attached. Builds a library with the same name and exports
+# as the real API (sdrplay_api.dll / libsdrplay_api.so), drop it in place of the real one.
+#
+#-------------------------------------------------
+
+QT       -= core gui
+CONFIG   -= qt
+CONFIG   += shared c++11
+
+TARGET = sdrplay_api
+TEMPLATE = lib
+
+INCLUDEPATH += ..
+
+win32: DEF_FILE = ../sdrplay_api.def
+unix: LIBS += -lpthread
+
+SOURCES += \
+        sdrplay_emulator.cpp \
+        ../signalgenerator.cpp
+
+HEADERS += \
+        ../sdrplay_api.h \
+        ../signalgenerator.h
@@ -0,0 +1,108 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#include <atomic>
+
+
+// Compact binary record of an SDR API event, queued by the event callback and formatted by the consumer.
+
+struct SourceEvent
+{
+    enum Kind : unsigned char { GainChange, Overload, ModeChange, DeviceRemoved, Unknown };
+
+    Kind Type;
+    unsigned char Tuner;                        // 'A' or 'B'
+    int Code;                                   // overload or mode change type, or the raw id of an unknown event
+    int gRdB;                                   // GainChange only
+    int lnaGRdB;
+    double SystemGain;
+};
+
+
+// Bounded lock-free queue of SourceEvents from the SDR API callback threads to the GUI thread.
+//
+// Each slot carries a sequence number saying whose turn it is: a producer claims a slot by advancing Tail with a
+// compare and swap, writes the record and then releases the slot to the consumer by bumping its sequence. Nothing
+// is allocated or locked on the producer side, so it is safe to call from the API callbacks. When the queue is full
+// the new event is counted in Dropped instead of waiting for the consumer.
+
+class EventQueue
+{
+public:
+    EventQueue()
+    {
+        for(unsigned int index = 0; index < Size; index++) Slots[index].Sequence.store(index, std::memory_order_relaxed);
+    }
+
+    // ---- Producer side (any thread) ---- //
+
+    bool Push(const SourceEvent &Event)
+    {
+        unsigned int Position = Tail.load(std::memory_order_relaxed);
+        for(;;)
+        {
+            Slot &Cell = Slots[Position % Size];
+            int Turn = (int)(Cell.Sequence.load(std::memory_order_acquire) - Position);
+            if(Turn == 0)
+            {
+                // slot is free for this position, try to claim it
+                if(Tail.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed)) break;
+            }
+            else if(Turn < 0)
+            {
+                // consumer has not emptied this slot yet, the queue is full
+                Dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else Position = Tail.load(std::memory_order_relaxed);   // another producer got there first
+        }
+
+        Slot &Cell = Slots[Position % Size];
+        Cell.Event = Event;
+        Cell.Sequence.store(Position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // ---- Consumer side (one thread) ---- //
+
+    bool Pop(SourceEvent &Event)
+    {
+        Slot &Cell = Slots[Head % Size];
+        if(Cell.Sequence.load(std::memory_order_acquire) != Head + 1) return false;  // nothing published here yet
+        Event = Cell.Event;
+        Cell.Sequence.store(Head + Size, std::memory_order_release);              // hand the slot back to producers
+        Head++;
+        return true;
+    }
+
+    // events lost because the queue was full
+    unsigned int DroppedCount(void) const { return Dropped.load(std::memory_order_relaxed); }
+
+private:
+
+    static const unsigned int Size = 64;        // power of 2, so positions can wrap
+
+    struct Slot
+    {
+        std::atomic<unsigned int> Sequence;
+        SourceEvent Event;
+    };
+
+    Slot Slots[Size];
+    alignas(64) std::atomic<unsigned int> Tail {0};    // next position to claim (producers)
+    alignas(64) unsigned int Head = 0;                 // next position to read (consumer only)
+    std::atomic<unsigned int> Dropped {0};
+};
+
+#endif // EVENTQUEUE_H
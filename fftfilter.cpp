@@ -0,0 +1,395 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+#include "fftfilter.h"
+#include "firkernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+int FFTFilters = FFTFiltersAuto;
+
+
+// *****************************  Complex FFT  ****************************** //
+
+
+FFT::FFT(int Size)
+{
+    N = Size;
+    TwiddleRe = new float[N];
+    TwiddleIm = new float[N];
+
+    // twiddles of each butterfly span h in a run of their own, so the inner loop reads them with unit stride
+    for(int h = 1; h < N; h *= 2)
+        for(int k = 0; k < h; k++)
+        {
+            TwiddleRe[h + k] = float(std::cos(M_PI * k / h));
+            TwiddleIm[h + k] = float(-std::sin(M_PI * k / h));
+        }
+}
+
+FFT::~FFT()
+{
+    delete[] TwiddleRe;
+    delete[] TwiddleIm;
+}
+
+void FFT::Forward(float *Re, float *Im) const
+{
+    // radix 2 decimation in frequency, spans from N/2 down, the last two need no multiplies
+    for(int h = N / 2; h >= 4; h /= 2)
+        for(int j = 0; j < N; j += 2 * h) FIR->ButterflyDIF(&Re[j], &Im[j], &Re[j + h], &Im[j + h], &TwiddleRe[h], &TwiddleIm[h], h);
+
+    if(N >= 4) for(int j = 0; j < N; j += 4)
+    {
+        float tr = Re[j] - Re[j + 2], ti = Im[j] - Im[j + 2];
+        Re[j] += Re[j + 2]; Im[j] += Im[j + 2];
+        Re[j + 2] = tr; Im[j + 2] = ti;
+        tr = Re[j + 1] - Re[j + 3]; ti = Im[j + 1] - Im[j + 3];
+        Re[j + 1] += Re[j + 3]; Im[j + 1] += Im[j + 3];
+        Re[j + 3] = ti; Im[j + 3] = -tr;          // times -j
+    }
+    for(int j = 0; j < N; j += 2)
+    {
+        float tr = Re[j] - Re[j + 1], ti = Im[j] - Im[j + 1];
+        Re[j] += Re[j + 1]; Im[j] += Im[j + 1];
+        Re[j + 1] = tr; Im[j + 1] = ti;
+    }
+}
+
+void FFT::Reversed(float *Re, float *Im) const
+{
+    // radix 2 decimation in time, spans from 1 up, the first two need no multiplies
+    for(int j = 0; j < N; j += 2)
+    {
+        float tr = Re[j + 1], ti = Im[j + 1];
+        Re[j + 1] = Re[j] - tr; Im[j + 1] = Im[j] - ti;
+        Re[j] += tr; Im[j] += ti;
+    }
+    if(N >= 4) for(int j = 0; j < N; j += 4)
+    {
+        float tr = Re[j + 2], ti = Im[j + 2];
+        Re[j + 2] = Re[j] - tr; Im[j + 2] = Im[j] - ti;
+        Re[j] += tr; Im[j] += ti;
+        tr = Im[j + 3]; ti = -Re[j + 3];          // times -j
+        Re[j + 3] = Re[j + 1] - tr; Im[j + 3] = Im[j + 1] - ti;
+        Re[j + 1] += tr; Im[j + 1] += ti;
+    }
+
+    for(int h = 4; h < N; h *= 2)
+        for(int j = 0; j < N; j += 2 * h) FIR->ButterflyDIT(&Re[j], &Im[j], &Re[j + h], &Im[j + h], &TwiddleRe[h], &TwiddleIm[h], h);
+}
+
+
+// spectra of the subfilter rows of Coef, zero padded to the transform size and scaled for the inverse transform
+static void SubfilterSpectra(const FFT &Transform, const float *Coef, int Rows, int Length, float *Re, float *Im)
+{
+    int N = Transform.Size();
+    for(int Row = 0; Row < Rows; Row++)
+    {
+        float *r = &Re[Row * N], *i = &Im[Row * N];
+        memset(r, 0, N * sizeof(float));
+        memset(i, 0, N * sizeof(float));
+        for(int k = 0; k < Length; k++) r[k] = Coef[(Row * Length) + k] / N;
+        Transform.Forward(r, i);
+    }
+}
+
+
+// *****************************  Decimate by M  ****************************** //
+
+
+FFTDecimator::FFTDecimator(const float *Coef, int Phases, int Taps, int Size) : Transform(Size)
+{
+    M = Phases;
+    Length = Taps;
+    N = Size;
+    Block = N - Length + 1;
+    SpectrumRe = new float[M * N];
+    SpectrumIm = new float[M * N];
+    HistoryI = new float[M * Length];
+    HistoryQ = new float[M * Length];
+    PendingI = new float[M];
+    PendingQ = new float[M];
+    WorkRe = new float[N];
+    WorkIm = new float[N];
+    SumRe = new float[N];
+    SumIm = new float[N];
+    SubfilterSpectra(Transform, Coef, M, Length, SpectrumRe, SpectrumIm);
+    Reset();
+}
+
+FFTDecimator::~FFTDecimator()
+{
+    delete[] SpectrumRe; delete[] SpectrumIm;
+    delete[] HistoryI; delete[] HistoryQ;
+    delete[] PendingI; delete[] PendingQ;
+    delete[] WorkRe; delete[] WorkIm;
+    delete[] SumRe; delete[] SumIm;
+}
+
+void FFTDecimator::Reset(void)
+{
+    memset(HistoryI, 0, M * Length * sizeof(float));
+    memset(HistoryQ, 0, M * Length * sizeof(float));
+    Pending = 0;
+}
+
+int FFTDecimator::Process(const float *I, const float *Q, int Count, float *OutI, float *OutQ)
+{
+    // input sample n follows the part group left over from the last call
+    auto SampleI = [&](int n) { return (n < Pending) ? PendingI[n] : I[n - Pending]; };
+    auto SampleQ = [&](int n) { return (n < Pending) ? PendingQ[n] : Q[n - Pending]; };
+
+    int Groups = (Pending + Count) / M;
+    int OP = 0;
+    while(OP < Groups)
+    {
+        int Chunk = std::min(Block, Groups - OP);
+        memset(SumRe, 0, N * sizeof(float));
+        memset(SumIm, 0, N * sizeof(float));
+        for(int s = 0; s < M; s++)
+        {
+            // history then this chunk of subfilter stream s, which is the history for the next chunk
+            float *HI = &HistoryI[s * Length], *HQ = &HistoryQ[s * Length];
+            memcpy(WorkRe, HI, (Length - 1) * sizeof(float));
+            memcpy(WorkIm, HQ, (Length - 1) * sizeof(float));
+            for(int t = 0; t < Chunk; t++)
+            {
+                WorkRe[Length - 1 + t] = SampleI(((OP + t) * M) + s);
+                WorkIm[Length - 1 + t] = SampleQ(((OP + t) * M) + s);
+            }
+            memcpy(HI, &WorkRe[Chunk], (Length - 1) * sizeof(float));
+            memcpy(HQ, &WorkIm[Chunk], (Length - 1) * sizeof(float));
+            memset(&WorkRe[Length - 1 + Chunk], 0, (Block - Chunk) * sizeof(float));
+            memset(&WorkIm[Length - 1 + Chunk], 0, (Block - Chunk) * sizeof(float));
+
+            Transform.Forward(WorkRe, WorkIm);
+            FIR->SpectrumMAC(WorkRe, WorkIm, &SpectrumRe[s * N], &SpectrumIm[s * N], SumRe, SumIm, N);
+        }
+        Transform.Inverse(SumRe, SumIm);
+        memcpy(&OutI[OP], &SumRe[Length - 1], Chunk * sizeof(float));
+        memcpy(&OutQ[OP], &SumIm[Length - 1], Chunk * sizeof(float));
+        OP += Chunk;
+    }
+
+    // keep a part group for the next call, in order so nothing is overwritten before it is read
+    int Left = Pending + Count - (Groups * M);
+    for(int n = 0; n < Left; n++)
+    {
+        PendingI[n] = SampleI((Groups * M) + n);
+        PendingQ[n] = SampleQ((Groups * M) + n);
+    }
+    Pending = Left;
+    return OP;
+}
+
+
+// *****************************  Upsample by L  ****************************** //
+
+
+FFTInterpolator::FFTInterpolator(const float *Coef, int Phases, int Kept, int Taps, int Size) : Transform(Size)
+{
+    L = Phases;
+    Keep = Kept;
+    Length = Taps;
+    N = Size;
+    Block = N - Length + 1;
+    SpectrumRe = new float[L * N];
+    SpectrumIm = new float[L * N];
+    HistoryI = new float[Length];
+    HistoryQ = new float[Length];
+    WorkRe = new float[N];
+    WorkIm = new float[N];
+    PhaseRe = new float[L * N];
+    PhaseIm = new float[L * N];
+    SubfilterSpectra(Transform, Coef, L, Length, SpectrumRe, SpectrumIm);
+    Reset();
+}
+
+FFTInterpolator::~FFTInterpolator()
+{
+    delete[] SpectrumRe; delete[] SpectrumIm;
+    delete[] HistoryI; delete[] HistoryQ;
+    delete[] WorkRe; delete[] WorkIm;
+    delete[] PhaseRe; delete[] PhaseIm;
+}
+
+void FFTInterpolator::Reset(void)
+{
+    memset(HistoryI, 0, Length * sizeof(float));
+    memset(HistoryQ, 0, Length * sizeof(float));
+    Skip = 0;
+}
+
+int FFTInterpolator::Process(const float *I, const float *Q, int Count, float *OutI, float *OutQ)
+{
+    int OP = 0;
+    for(int First = 0; First < Count; First += Block)
+    {
+        int Chunk = std::min(Block, Count - First);
+        memcpy(WorkRe, HistoryI, (Length - 1) * sizeof(float));
+        memcpy(WorkIm, HistoryQ, (Length - 1) * sizeof(float));
+        memcpy(&WorkRe[Length - 1], &I[First], Chunk * sizeof(float));
+        memcpy(&WorkIm[Length - 1], &Q[First], Chunk * sizeof(float));
+        memcpy(HistoryI, &WorkRe[Chunk], (Length - 1) * sizeof(float));
+        memcpy(HistoryQ, &WorkIm[Chunk], (Length - 1) * sizeof(float));
+        memset(&WorkRe[Length - 1 + Chunk], 0, (Block - Chunk) * sizeof(float));
+        memset(&WorkIm[Length - 1 + Chunk], 0, (Block - Chunk) * sizeof(float));
+        Transform.Forward(WorkRe, WorkIm);
+
+        for(int p = 0; p < L; p++)
+        {
+            float *Yr = &PhaseRe[p * N], *Yi = &PhaseIm[p * N];
+            memset(Yr, 0, N * sizeof(float));
+            memset(Yi, 0, N * sizeof(float));
+            FIR->SpectrumMAC(WorkRe, WorkIm, &SpectrumRe[p * N], &SpectrumIm[p * N], Yr, Yi, N);
+            Transform.Inverse(Yr, Yi);
+        }
+
+        // outputs in the same order as the direct form, L per input sample of which every Keep th is kept
+        for(int t = 0; t < Chunk; t++)
+            for(int p = 0; p < L; p++)
+            {
+                if(Skip > 0) { Skip--; continue; }
+                Skip = Keep - 1;
+                OutI[OP] = PhaseRe[(p * N) + Length - 1 + t];
+                OutQ[OP] = PhaseIm[(p * N) + Length - 1 + t];
+                OP++;
+            }
+    }
+    return OP;
+}
+
+
+// *****************************  Planner  ****************************** //
+
+// Estimated costs per input sample, in multiply-adds of the direct form kernels. A radix 2 butterfly costs about as
+// much as ButterflyCost of them and a complex spectrum product ProductCost (both measured against the SSE2/AVX2
+// kernels, which run their multiply-adds several to a vector). An FFT is only chosen if it is clearly cheaper.
+
+static const double ButterflyCost = 3.5;
+static const double ProductCost = 4.0;
+static const double FFTMargin = 0.8;        // FFT cost must be under this fraction of the direct form
+
+static double TransformCost(int N)
+{
+    int Bits = 0;
+    while((1 << Bits) < N) Bits++;
+    return ButterflyCost * (N / 2) * Bits;
+}
+
+static int SmallestFFT(int Length)
+{
+    int N = 16;
+    while(N < 2 * Length) N *= 2;       // at least half of each block new samples
+    return N;
+}
+
+int PlanFFTDecimator(int M, int Length, bool Folded, int Block)
+{
+    if(FFTFilters == FFTFiltersOff) return 0;
+
+    double Direct = 2.0 * Length * (Folded ? 0.5 : 1.0);   // I and Q, M subfilters per output, one output per M inputs
+    double Best = 0;
+    int BestSize = 0;
+    for(int N = SmallestFFT(Length); N <= 16384; N *= 2)
+    {
+        int Chunk = std::max(1, std::min(N - Length + 1, Block / M));
+        double Cost = ((M * (TransformCost(N) + (ProductCost * N))) + TransformCost(N)) / (double(Chunk) * M);
+        if((BestSize == 0) || (Cost < Best)) { Best = Cost; BestSize = N; }
+        if(Chunk < N - Length + 1) break;   // larger blocks than the input cannot help
+    }
+    if((FFTFilters == FFTFiltersAuto) && (Best >= FFTMargin * Direct)) return 0;
+    return BestSize;
+}
+
+int PlanFFTInterpolator(int L, int Length, int Keep, int Block)
+{
+    if(FFTFilters == FFTFiltersOff) return 0;
+
+    double Direct = 2.0 * Length * L / Keep;               // I and Q, one subfilter per kept output
+    double Best = 0;
+    int BestSize = 0;
+    for(int N = SmallestFFT(Length); N <= 16384; N *= 2)
+    {
+        int Chunk = std::max(1, std::min(N - Length + 1, Block));
+        double Cost = (TransformCost(N) + (L * (TransformCost(N) + (ProductCost * N)))) / Chunk;
+        if((BestSize == 0) || (Cost < Best)) { Best = Cost; BestSize = N; }
+        if(Chunk < N - Length + 1) break;
+    }
+    if((FFTFilters == FFTFiltersAuto) && (Best >= FFTMargin * Direct)) return 0;
+    return BestSize;
+}
+
+
+// *****************************  Validation  ****************************** //
+
+
+float ValidateFFTFilters(void)
+{
+    // both engines against the direct form sums, in double, on pseudo random data fed in awkwardly sized calls
+    const int M = 5, L = 6, Keep = 5, Length = 44, Total = 3000;
+    const int Calls[] = { 7, 333, 1, 1200, 64, 1395 };
+    static float Coef[L * Length], I[Total], Q[Total], OutI[2 * Total], OutQ[2 * Total];
+    unsigned int Seed = 12345;
+    for(int k = 0; k < L * Length; k++) { Seed = Seed * 1103515245 + 12345; Coef[k] = ((int)(Seed >> 16) % 32768 - 16384) / 163840.0f; }
+    for(int n = 0; n < Total; n++)
+    {
+        Seed = Seed * 1103515245 + 12345; I[n] = (int)(Seed >> 16) % 32768 - 16384;
+        Seed = Seed * 1103515245 + 12345; Q[n] = (int)(Seed >> 16) % 32768 - 16384;
+    }
+
+    float MaxError = 0;
+
+    FFTDecimator Decimate(Coef, M, Length, SmallestFFT(Length));
+    int OP = 0, Start = 0;
+    for(int Count : Calls) { OP += Decimate.Process(&I[Start], &Q[Start], Count, &OutI[OP], &OutQ[OP]); Start += Count; }
+    for(int m = 0; m < OP; m++)
+    {
+        double RefI = 0, RefQ = 0, Scale = 1;
+        for(int s = 0; s < M; s++)
+            for(int i = 0; i < Length; i++)
+            {
+                int n = ((m - i) * M) + s;
+                if(n < 0) continue;
+                RefI += Coef[(s * Length) + i] * I[n];
+                RefQ += Coef[(s * Length) + i] * Q[n];
+                Scale += std::fabs(Coef[(s * Length) + i] * I[n]) + std::fabs(Coef[(s * Length) + i] * Q[n]);
+            }
+        MaxError = std::fmax(MaxError, float(std::fmax(std::fabs(OutI[m] - RefI), std::fabs(OutQ[m] - RefQ)) / Scale));
+    }
+    if(OP != Total / M) MaxError = 1;
+
+    for(int Kept : { Keep, L + 1 })   // more and fewer outputs than inputs (as US6 and US4)
+    {
+        FFTInterpolator Interpolate(Coef, L, Kept, Length, SmallestFFT(Length));
+        OP = 0; Start = 0;
+        for(int Count : Calls) { OP += Interpolate.Process(&I[Start], &Q[Start], Count, &OutI[OP], &OutQ[OP]); Start += Count; }
+        int Out = 0;
+        for(int j = 0; j < Total * L; j += Kept, Out++)
+        {
+            int n = j / L, p = j % L;
+            double RefI = 0, RefQ = 0, Scale = 1;
+            for(int i = 0; (i < Length) && (i <= n); i++)
+            {
+                RefI += Coef[(p * Length) + i] * I[n - i];
+                RefQ += Coef[(p * Length) + i] * Q[n - i];
+                Scale += std::fabs(Coef[(p * Length) + i] * I[n - i]) + std::fabs(Coef[(p * Length) + i] * Q[n - i]);
+            }
+            if(Out < OP) MaxError = std::fmax(MaxError, float(std::fmax(std::fabs(OutI[Out] - RefI), std::fabs(OutQ[Out] - RefQ)) / Scale));
+        }
+        if(OP != Out) MaxError = 1;
+    }
+    return MaxError;
+}
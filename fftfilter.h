@@ -0,0 +1,113 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+#ifndef FFTFILTER_H
+#define FFTFILTER_H
+
+
+// Overlap-save FFT convolution for the polyphase filter stages, as an alternative to their direct form FIR.
+//
+// A filter stage of Phases subfilters of Length taps (the rows of a PolyphaseTable, newest first) is run as a fast
+// convolution of each subfilter with its input stream. Blocks of Size complex samples are made up of the last
+// Length-1 samples of the stream followed by up to Size-Length+1 new ones, transformed, multiplied by the cached
+// spectrum of the subfilter and transformed back. The first Length-1 results are the wrapped around part of the
+// circular convolution and are discarded, the rest are exactly the direct form outputs (to float rounding). I and Q
+// go through as the real and imaginary parts of one complex transform, since the coefficients are real.
+//
+// Decimate by M: the M subfilter streams (every Mth input) are each transformed and their products summed before a
+// single inverse transform. Upsample by L, keeping every Keep th output: the input is transformed once and each
+// of the L subfilter products transformed back. A Process() call takes any number of samples and gives the same
+// outputs, in the same order, as the direct form stage from the same state.
+
+class FFT
+{
+public:
+    FFT(int Size);                              // Size a power of 2
+    ~FFT();
+    FFT(const FFT &) = delete;
+    FFT &operator=(const FFT &) = delete;
+
+    // In place complex transforms of Size samples, real and imaginary parts in separate arrays, unscaled. The
+    // spectrum is left in bit reversed bin order by Forward (decimation in frequency) and taken in that order by
+    // Inverse (decimation in time), so neither has to reorder it, the filters only multiply spectra bin by bin.
+    void Forward(float *Re, float *Im) const;
+    void Inverse(float *Re, float *Im) const { Reversed(Im, Re); }   // conjugate by swapping the parts
+
+    int Size(void) const { return N; }
+
+private:
+    void Reversed(float *Re, float *Im) const;  // forward transform from bit reversed order
+
+    int N;
+    float *TwiddleRe;                           // exp(-j pi k / h) at [h + k], for each butterfly span h
+    float *TwiddleIm;
+};
+
+
+class FFTDecimator
+{
+public:
+    FFTDecimator(const float *Coef, int M, int Length, int Size);   // Coef: M rows of Length taps, as DecimatorTable
+    ~FFTDecimator();
+    FFTDecimator(const FFTDecimator &) = delete;
+    FFTDecimator &operator=(const FFTDecimator &) = delete;
+
+    // Count input samples to Count/M outputs (with any part group left from the last call), Out may be In
+    int Process(const float *I, const float *Q, int Count, float *OutI, float *OutQ);
+    void Reset(void);
+
+private:
+    FFT Transform;
+    int M, Length, N, Block;                    // Block: outputs per transform
+    float *SpectrumRe, *SpectrumIm;             // M subfilter spectra of N bins, scaled by 1/N
+    float *HistoryI, *HistoryQ;                 // last Length-1 samples of each subfilter stream, oldest first
+    float *PendingI, *PendingQ;                 // input samples of a part group, fewer than M
+    int Pending = 0;
+    float *WorkRe, *WorkIm, *SumRe, *SumIm;     // N each
+};
+
+
+class FFTInterpolator
+{
+public:
+    FFTInterpolator(const float *Coef, int L, int Keep, int Length, int Size);   // Coef: L rows of Length taps, as InterpolatorTable
+    ~FFTInterpolator();
+    FFTInterpolator(const FFTInterpolator &) = delete;
+    FFTInterpolator &operator=(const FFTInterpolator &) = delete;
+
+    // Count input samples to the kept outputs of Count * L, Out may be In if L <= Keep
+    int Process(const float *I, const float *Q, int Count, float *OutI, float *OutQ);
+    void Reset(void);
+
+private:
+    FFT Transform;
+    int L, Keep, Length, N, Block;              // Block: input samples per transform
+    float *SpectrumRe, *SpectrumIm;             // L subfilter spectra of N bins, scaled by 1/N
+    float *HistoryI, *HistoryQ;                 // last Length-1 input samples, oldest first
+    float *WorkRe, *WorkIm;                     // N
+    float *PhaseRe, *PhaseIm;                   // L subfilter outputs of N
+    int Skip = 0;                               // outputs to skip before the next one kept
+};
+
+
+// How the polyphase stages filter, set before the filter chains are allocated
+enum FFTFilterPolicy { FFTFiltersOff, FFTFiltersAuto, FFTFiltersOn };
+extern int FFTFilters;                          // FFTFiltersAuto unless overridden
+
+// Planner: the FFT size to filter blocks of up to Block input samples with, or 0 for direct form, from the
+// estimated cost per input sample of each (FFTFiltersAuto), always direct (Off) or the best FFT size (On)
+int PlanFFTDecimator(int M, int Length, bool Folded, int Block);
+int PlanFFTInterpolator(int L, int Length, int Keep, int Block);
+
+float ValidateFFTFilters(void);                 // largest error relative to the direct form, on pseudo random data
+
+#endif // FFTFILTER_H
@@ -0,0 +1,132 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+#include "filesource.h"
+
+#define REPLAY_CHUNK 2000                   // sample pairs per write, 1mS at 2MHz
+
+
+FileSource::FileSource(QString FileName, bool Paced, QObject *parent) : SampleSource(parent), File(FileName)
+{
+    this->Paced = Paced;
+}
+
+
+FileSource::~FileSource()
+{
+    Stop();
+}
+
+
+void FileSource::Start(int LOfrequency, int gRdB_Gain_A, int gRdB_Gain_B, int LNAstate)
+{
+    (void)LOfrequency; (void)gRdB_Gain_A; (void)gRdB_Gain_B; (void)LNAstate;   // no tuner to set
+
+    QString MessageString;
+
+    if(Running) return;
+
+    if(!File.open(QIODevice::ReadOnly))
+    {
+        MessageString = QString::asprintf("Replay: cannot open %s", qPrintable(File.fileName()));
+        emit Status(MessageString);
+        return;
+    }
+
+    Frames = File.size() / (2 * (long long)sizeof(short));
+    if(Frames < REPLAY_CHUNK)
+    {
+        MessageString = QString::asprintf("Replay: %s is too short", qPrintable(File.fileName()));
+        emit Status(MessageString);
+        File.close();
+        return;
+    }
+
+    Samples = (const short *)File.map(0, Frames * 2 * sizeof(short));
+    if(Samples == nullptr)
+    {
+        MessageString = QString::asprintf("Replay: cannot map %s", qPrintable(File.fileName()));
+        emit Status(MessageString);
+        File.close();
+        return;
+    }
+
+    MessageString = QString::asprintf("Replay: %s, %.1f Seconds, %s", qPrintable(File.fileName()),
+                                      (double)Frames / INPUT_SAMPLE_RATE, Paced ? "real time" : "fast");
+    emit Status(MessageString);
+
+    Replayed = 0;
+    Started = std::chrono::steady_clock::now();
+    Running = true;
+    Feeder = std::thread(&FileSource::Feed, this);
+}
+
+
+void FileSource::Stop(void)
+{
+    if(!Running) return;
+
+    Running = false;
+    Feeder.join();
+
+    File.unmap((uchar *)Samples);
+    File.close();
+    Samples = nullptr;
+
+    // report how fast the input was taken compared with the real RSPduo rate
+    double Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - Started).count();
+    double Seconds = (double)Replayed / INPUT_SAMPLE_RATE;
+    emit Status(QString::asprintf("Replay stopped: %.1f Seconds replayed at %.2f x real time", Seconds,
+                                  (Elapsed > 0) ? Seconds / Elapsed : 0.0));
+}
+
+
+void FileSource::Feed(void)
+{
+    short ChunkA[REPLAY_CHUNK];
+    short ChunkB[REPLAY_CHUNK];
+    long long Position = 0;
+
+    while(Running)
+    {
+        if(Paced)
+        {
+            // wait until this chunk would have arrived from the hardware
+            std::this_thread::sleep_until(Started + std::chrono::microseconds(Replayed * 1000000 / INPUT_SAMPLE_RATE));
+        }
+        else
+        {
+            // never write into a block the DSP thread has not finished with yet
+            while(Running && (A_InputRing.Backlog() >= (unsigned int)A_InputRing.BlockCount() - 1))
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            if(!Running) break;
+        }
+
+        int Count = REPLAY_CHUNK;
+        if(Position + Count > Frames) Count = (int)(Frames - Position);
+
+        // split the interleaved pairs into the two channels
+        const short *Pair = &Samples[Position * 2];
+        for(int loop = 0; loop < Count; loop++)
+        {
+            ChunkA[loop] = Pair[loop * 2];
+            ChunkB[loop] = Pair[loop * 2 + 1];
+        }
+
+        WriteInput(ChunkA, ChunkB, Count, SampleNum);
+        SampleNum += Count;
+        Replayed += Count;
+
+        Position += Count;
+        if(Position >= Frames) Position = 0;    // loop the recording
+    }
+}
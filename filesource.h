@@ -0,0 +1,55 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef FILESOURCE_H
+#define FILESOURCE_H
+
+#include "samplesource.h"
+
+#include <QFile>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+
+// Replays a recorded dual channel IF capture into the input rings in place of the RSPduo.
+//
+// The file is raw little endian 16 bit samples at 2MHz, channel A and B interleaved (A0 B0 A1 B1 ...), exactly as
+// delivered by the two stream callbacks. It is memory mapped and fed from its own thread in 1mS chunks, either paced
+// to real time or as fast as the DSP thread hands blocks back, looping at the end of the file.
+
+class FileSource : public SampleSource
+{
+    Q_OBJECT
+public:
+    explicit FileSource(QString FileName, bool Paced, QObject *parent = nullptr);
+    ~FileSource();
+
+    void Start(int LOfrequency, int gRdb_Gain_A, int gRdb_Gain_B, int LNAstate) override;
+    void Stop(void) override;
+
+private:
+
+    void Feed(void);                        // feeder thread body
+
+    QFile File;                             // the replay file
+    const short *Samples = nullptr;         // mapped file contents, interleaved A/B
+    long long Frames = 0;                   // number of A/B sample pairs in the file
+    bool Paced;                             // true = real time replay, false = as fast as the DSP can take it
+
+    std::thread Feeder;                     // feeder thread
+    std::atomic<bool> Running {false};      // cleared to stop the feeder thread
+    std::atomic<long long> Replayed {0};    // sample pairs written to the input rings since Start
+    unsigned int SampleNum = 0;             // sample number stamped on the next chunk
+    std::chrono::steady_clock::time_point Started;   // time replay started, for pacing and rate report
+};
+
+#endif // FILESOURCE_H
@@ -0,0 +1,487 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+#include "filterdesign.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+
+#define REMEZ_GRID_DENSITY 16     // grid points per extremal, as remez()
+#define REMEZ_ITERATIONS 40       // exchanges before giving up on convergence
+#define DESIGN_VERSION 2          // part of the cache key, a change to the designers makes the old designs stale
+#define DESIGN_MAX_TAPS 4096      // longest design searched for a spec, a Remez design this long takes seconds
+#define DESIGN_RETRIES 8          // lengths tried, a ratio of taps apart, past one whose design did not converge
+
+
+// *****************************  Parks-McClellan  ****************************** //
+
+
+// The approximation is a sum of r cosines on a dense grid of frequencies (cycles per sample, 0 to 0.5) over the bands.
+// For an even number of taps the response is cos(pi f) times such a sum, so the desired response is divided by it and
+// the weight multiplied by it, and the grid stops short of 0.5 where it is zero.
+
+struct RemezGrid
+{
+    std::vector<double> Frequency;
+    std::vector<double> Desired;
+    std::vector<double> Weight;
+};
+
+static RemezGrid DenseGrid(int r, int Taps, const double *Edges, const double *Desired, const double *Weights, int Bands)
+{
+    RemezGrid Grid;
+    double Step = 0.5 / (REMEZ_GRID_DENSITY * r);
+    for(int band = 0; band < Bands; band++)
+    {
+        double Low = Edges[2 * band] / 2, High = Edges[2 * band + 1] / 2;
+        int Points = std::max(1, int((High - Low) / Step + 0.5));
+        for(int i = 0; i < Points; i++)
+        {
+            double f = (i == Points - 1) ? High : Low + i * Step;
+            double Fraction = (High > Low) ? (f - Low) / (High - Low) : 0;   // desired gain straight between the band edges
+            Grid.Frequency.push_back(f);
+            Grid.Desired.push_back(Desired[2 * band] + Fraction * (Desired[2 * band + 1] - Desired[2 * band]));
+            Grid.Weight.push_back(Weights[band]);
+        }
+    }
+    if(Taps % 2 == 0)
+    {
+        if(Grid.Frequency.back() > 0.5 - Step) Grid.Frequency.back() = 0.5 - Step;
+        for(size_t i = 0; i < Grid.Frequency.size(); i++)
+        {
+            double c = std::cos(M_PI * Grid.Frequency[i]);
+            Grid.Desired[i] /= c;
+            Grid.Weight[i] *= c;
+        }
+    }
+    return Grid;
+}
+
+// the equiripple fit through the r+1 extremals: barycentric weights, the ripple delta and the values there
+struct RemezFit
+{
+    std::vector<double> x, Barycentric, y;
+    double Delta;
+
+    double operator()(double f) const      // the fitted sum of cosines at f, Lagrange interpolation in cos(2 pi f)
+    {
+        double xf = std::cos(2 * M_PI * f), Numerator = 0, Denominator = 0;
+        for(size_t i = 0; i < x.size(); i++)
+        {
+            double d = xf - x[i];
+            if(std::fabs(d) < 1e-7) return y[i];
+            d = Barycentric[i] / d;
+            Denominator += d;
+            Numerator += d * y[i];
+        }
+        return Numerator / Denominator;
+    }
+};
+
+static RemezFit Fit(const std::vector<int> &Extremals, const RemezGrid &Grid)
+{
+    int n = int(Extremals.size());
+    RemezFit Result;
+    Result.x.resize(n);
+    Result.Barycentric.resize(n);
+    Result.y.resize(n);
+    for(int i = 0; i < n; i++) Result.x[i] = std::cos(2 * M_PI * Grid.Frequency[Extremals[i]]);
+
+    int Interleave = (n - 2) / 15 + 1;   // products taken in interleaved order so they stay in range
+    for(int i = 0; i < n; i++)
+    {
+        double Product = 1;
+        for(int j = 0; j < Interleave; j++)
+            for(int k = j; k < n; k += Interleave) if(k != i) Product *= 2 * (Result.x[i] - Result.x[k]);
+        if(std::fabs(Product) < 1e-5) Product = 1e-5;
+        Result.Barycentric[i] = 1 / Product;
+    }
+
+    double Numerator = 0, Denominator = 0, Sign = 1;
+    for(int i = 0; i < n; i++)
+    {
+        Numerator += Result.Barycentric[i] * Grid.Desired[Extremals[i]];
+        Denominator += Sign * Result.Barycentric[i] / Grid.Weight[Extremals[i]];
+        Sign = -Sign;
+    }
+    Result.Delta = Numerator / Denominator;
+    Sign = 1;
+    for(int i = 0; i < n; i++)
+    {
+        Result.y[i] = Grid.Desired[Extremals[i]] - Sign * Result.Delta / Grid.Weight[Extremals[i]];
+        Sign = -Sign;
+    }
+    return Result;
+}
+
+// the local extrema of the weighted error, thinned to Count alternating ones
+static std::vector<int> Extrema(const std::vector<double> &E, int Count)
+{
+    int Last = int(E.size()) - 1;
+    std::vector<int> Found;
+    if((E[0] > 0 && E[0] > E[1]) || (E[0] < 0 && E[0] < E[1])) Found.push_back(0);
+    for(int i = 1; i < Last; i++)
+        if((E[i] >= E[i - 1] && E[i] > E[i + 1] && E[i] > 0) || (E[i] <= E[i - 1] && E[i] < E[i + 1] && E[i] < 0)) Found.push_back(i);
+    if((E[Last] > 0 && E[Last] > E[Last - 1]) || (E[Last] < 0 && E[Last] < E[Last - 1])) Found.push_back(Last);
+
+    while(int(Found.size()) > Count)
+    {
+        // two in a row of the same sign lose the smaller, if they all alternate the smaller of the first and last goes
+        int Remove = -1;
+        for(size_t j = 1; j < Found.size() && Remove < 0; j++)
+            if((E[Found[j]] > 0) == (E[Found[j - 1]] > 0)) Remove = (std::fabs(E[Found[j]]) < std::fabs(E[Found[j - 1]])) ? int(j) : int(j - 1);
+        if(Remove < 0) Remove = (std::fabs(E[Found.back()]) < std::fabs(E[Found.front()])) ? int(Found.size()) - 1 : 0;
+        Found.erase(Found.begin() + Remove);
+    }
+    return Found;
+}
+
+std::vector<double> RemezFilter(int Taps, const double *Edges, const double *Desired, const double *Weights, int Bands)
+{
+    int r = Taps / 2 + (Taps % 2);   // cosines in the approximation
+    RemezGrid Grid = DenseGrid(r, Taps, Edges, Desired, Weights, Bands);
+    int Size = int(Grid.Frequency.size());
+    if(Size < r + 1) return std::vector<double>();
+
+    std::vector<int> Extremals(r + 1);
+    for(int i = 0; i <= r; i++) Extremals[i] = int((long long)i * (Size - 1) / r);
+
+    RemezFit Approximation;
+    std::vector<double> Error(Size);
+    bool Converged = false;
+    for(int iteration = 0; (iteration < REMEZ_ITERATIONS) && !Converged; iteration++)
+    {
+        Approximation = Fit(Extremals, Grid);
+        for(int i = 0; i < Size; i++) Error[i] = Grid.Weight[i] * (Grid.Desired[i] - Approximation(Grid.Frequency[i]));
+        std::vector<int> Found = Extrema(Error, r + 1);
+        if(int(Found.size()) < r + 1) break;   // lost the alternation
+        Extremals = Found;
+
+        double Largest = 0, Smallest = 1e300;
+        for(int i : Extremals)
+        {
+            Largest = std::max(Largest, std::fabs(Error[i]));
+            Smallest = std::min(Smallest, std::fabs(Error[i]));
+        }
+        Converged = ((Largest - Smallest) / Largest < 0.0001);
+    }
+    if(!Converged) return std::vector<double>();
+    Approximation = Fit(Extremals, Grid);
+
+    // the impulse response by sampling the response at k/Taps and an inverse DFT of it
+    std::vector<double> A(Taps / 2 + 1);
+    for(int k = 0; k <= Taps / 2; k++)
+    {
+        double c = (Taps % 2) ? 1 : std::cos(M_PI * k / Taps);
+        A[k] = Approximation(double(k) / Taps) * c;
+    }
+    std::vector<double> h(Taps);
+    double M = (Taps - 1) / 2.0;
+    int Terms = (Taps % 2) ? int(M) : Taps / 2 - 1;
+    for(int n = 0; n < Taps; n++)
+    {
+        double Sum = A[0], x = 2 * M_PI * (n - M) / Taps;
+        for(int k = 1; k <= Terms; k++) Sum += 2 * A[k] * std::cos(x * k);
+        h[n] = Sum / Taps;
+    }
+    return h;
+}
+
+
+// *****************************  Kaiser window  ****************************** //
+
+
+static double BesselI0(double x)
+{
+    double Sum = 1, Term = 1;
+    for(int k = 1; k < 100 && Term > 1e-16 * Sum; k++)
+    {
+        Term *= (x / (2 * k)) * (x / (2 * k));
+        Sum += Term;
+    }
+    return Sum;
+}
+
+std::vector<double> KaiserFilter(int Taps, double Cutoff, double Beta)
+{
+    std::vector<double> h(Taps);
+    double M = (Taps - 1) / 2.0, Sum = 0;
+    for(int n = 0; n < Taps; n++)
+    {
+        double t = n - M;
+        double Sinc = (t == 0) ? Cutoff : std::sin(M_PI * Cutoff * t) / (M_PI * t);
+        double Position = (Taps > 1) ? t / M : 0;
+        h[n] = Sinc * BesselI0(Beta * std::sqrt(std::max(0.0, 1 - Position * Position))) / BesselI0(Beta);
+        Sum += h[n];
+    }
+    for(double &Coef : h) Coef /= Sum;   // unity gain at DC
+    return h;
+}
+
+
+// *****************************  Design from a spec  ****************************** //
+
+
+static double PassDeviation(double Ripple)   // passband ripple in dB to the largest deviation from unity
+{
+    double g = std::pow(10, Ripple / 20);
+    return (g - 1) / (g + 1);
+}
+
+std::string FilterSpec::Key(void) const
+{
+    char Text[256];
+    snprintf(Text, sizeof(Text), "v%d %s %s %d %.10g %.10g %.10g %.10g %.10g %d", DESIGN_VERSION,
+             (Design == Remez) ? "remez" : "kaiser", (Stage == Decimate) ? "decimate" : "interpolate",
+             Ratio, SampleRate, Passband, Stopband, Ripple, Attenuation, Taps);
+    return Text;
+}
+
+bool FilterSpec::Parse(const std::string &Text)
+{
+    std::vector<std::string> Fields;
+    std::stringstream Stream(Text);
+    std::string Field;
+    while(std::getline(Stream, Field, ',')) Fields.push_back(Field);
+    if(Fields.size() < 8 || Fields.size() > 9) return false;
+
+    if(Fields[0] == "remez") Design = Remez;
+    else if(Fields[0] == "kaiser") Design = Kaiser;
+    else return false;
+    if(Fields[1] == "decimate") Stage = Decimate;
+    else if(Fields[1] == "interpolate") Stage = Interpolate;
+    else return false;
+    Ratio = std::atoi(Fields[2].c_str());
+    SampleRate = std::atof(Fields[3].c_str());
+    Passband = std::atof(Fields[4].c_str());
+    Stopband = std::atof(Fields[5].c_str());
+    Ripple = std::atof(Fields[6].c_str());
+    Attenuation = std::atof(Fields[7].c_str());
+    Taps = (Fields.size() == 9) ? std::atoi(Fields[8].c_str()) : 0;
+    return Valid();
+}
+
+bool FilterSpec::Valid(void) const
+{
+    return (Ratio >= 1) && (Passband > 0) && (Stopband > Passband) && (Stopband < SampleRate / 2) &&
+           (Ripple > 0) && (Attenuation > 0) && (Taps >= 0) && (Taps <= 8192) && (Taps % Ratio == 0);
+}
+
+FilterResponse MeasureFilter(const std::vector<double> &Coef, const FilterSpec &Spec)
+{
+    auto Gain = [&Coef](double f)   // |H| at f cycles per sample
+    {
+        double Re = 0, Im = 0;
+        for(size_t n = 0; n < Coef.size(); n++)
+        {
+            Re += Coef[n] * std::cos(2 * M_PI * f * n);
+            Im -= Coef[n] * std::sin(2 * M_PI * f * n);
+        }
+        return std::sqrt(Re * Re + Im * Im);
+    };
+
+    const int Points = 1024;
+    double Pass = Spec.Passband / Spec.SampleRate, Stop = Spec.Stopband / Spec.SampleRate;
+    double Deviation = 0, Leak = 0;
+    for(int i = 0; i <= Points; i++)
+    {
+        Deviation = std::max(Deviation, std::fabs(20 * std::log10(Gain(Pass * i / Points))));
+        Leak = std::max(Leak, Gain(Stop + (0.5 - Stop) * i / Points));
+    }
+    return { Deviation, -20 * std::log10(std::max(Leak, 1e-15)) };
+}
+
+static std::vector<double> Design(const FilterSpec &Spec, int Taps)
+{
+    double PassEdge = 2 * Spec.Passband / Spec.SampleRate, StopEdge = 2 * Spec.Stopband / Spec.SampleRate;
+    double dp = PassDeviation(Spec.Ripple), ds = std::pow(10, -Spec.Attenuation / 20);
+    if(Spec.Design == FilterSpec::Remez)
+    {
+        const double Edges[4] = { 0, PassEdge, StopEdge, 1 };
+        const double Desired[4] = { 1, 1, 0, 0 };
+        const double Weights[2] = { 1, dp / ds };   // ripple in each band in proportion to its spec
+        return RemezFilter(Taps, Edges, Desired, Weights, 2);
+    }
+    double A = std::max(Spec.Attenuation, -20 * std::log10(dp));
+    double Beta = (A > 50) ? 0.1102 * (A - 8.7) : (A >= 21) ? 0.5842 * std::pow(A - 21, 0.4) + 0.07886 * (A - 21) : 0;
+    return KaiserFilter(Taps, (PassEdge + StopEdge) / 2, Beta);
+}
+
+static bool Meets(const std::vector<double> &Coef, const FilterSpec &Spec)
+{
+    if(Coef.empty()) return false;
+    FilterResponse Response = MeasureFilter(Coef, Spec);
+    return (Response.Ripple <= Spec.Ripple) && (Response.Attenuation >= Spec.Attenuation);
+}
+
+std::vector<double> DesignFilter(const FilterSpec &Spec)
+{
+    if(!Spec.Valid()) return std::vector<double>();
+    if(Spec.Taps) return Design(Spec, Spec.Taps);
+
+    // length estimate for the spec (Kaiser's for the window, Kaiser's for an equiripple design), in units of Ratio taps
+    double Transition = (Spec.Stopband - Spec.Passband) / Spec.SampleRate;
+    double dp = PassDeviation(Spec.Ripple), ds = std::pow(10, -Spec.Attenuation / 20);
+    double Estimate = (Spec.Design == FilterSpec::Remez) ? (-20 * std::log10(std::sqrt(dp * ds)) - 13) / (14.6 * Transition) + 1
+                                                         : (std::max(Spec.Attenuation, -20 * std::log10(dp)) - 7.95) / (14.36 * Transition) + 1;
+    const int Limit = std::min(DESIGN_MAX_TAPS, 8192) / Spec.Ratio;
+    int Units = std::min(Limit, std::max(2, int(std::ceil(Estimate / Spec.Ratio))));
+
+    // design Count units, or the next length that converges (a Remez design does not at some) up to DESIGN_RETRIES
+    // later and no further than Last: 1 if it meets the spec (then in Best), 0 if it does not, with Count moved to
+    // the length designed, or -1 if none converged, with Count one past the last length tried
+    std::vector<double> Best;
+    auto Try = [&](int &Count, int Last)
+    {
+        for(int Retry = 0; (Retry <= DESIGN_RETRIES) && (Count <= Last); Retry++, Count++)
+        {
+            std::vector<double> Coef = Design(Spec, Count * Spec.Ratio);
+            if(Coef.empty()) continue;
+            if(!Meets(Coef, Spec)) return 0;
+            Best = Coef;
+            return 1;
+        }
+        return -1;
+    };
+
+    // bracket the fewest taps that meet the spec, Fail..Pass, from the estimate: up to twice it in quarters, the
+    // estimate is good to a few percent when the spec can be met at all, or down by halves. A length that did not
+    // converge counts as too short.
+    int Fail = 0, Pass = 0, Count = Units, Result = Try(Count, Limit);
+    if(Result == 1)
+    {
+        Pass = Count;
+        while(Pass > 1)
+        {
+            Count = Pass / 2;
+            Result = Try(Count, Pass - 1);
+            if(Result != 1) break;
+            Pass = Count;
+        }
+        if(Pass > 1) Fail = (Result == 0) ? Count : Count - 1;
+    }
+    else
+    {
+        Fail = (Result == 0) ? Count : Count - 1;
+        int Last = std::min(Limit, 2 * Units);
+        for(int Step = 1; !Pass && (Fail < Last); Step++)
+        {
+            Count = std::max(Fail + 1, std::min(Last, Units + ((Units * Step) + 3) / 4));
+            Result = Try(Count, Last);
+            if(Result == 1) Pass = Count;
+            else Fail = (Result == 0) ? Count : Count - 1;
+        }
+        if(!Pass) return std::vector<double>();   // not reachable: too long, or past what the design method can do
+    }
+
+    // then the fewest by bisection, Best always the design for Pass
+    while(Pass - Fail > 1)
+    {
+        Count = (Fail + Pass) / 2;
+        Result = Try(Count, Pass - 1);
+        if(Result == 1) Pass = Count;
+        else Fail = (Result == 0) ? Count : Count - 1;
+    }
+    return Best;
+}
+
+
+// *****************************  Cache  ****************************** //
+
+
+static std::string CacheDirectory;   // no cache if empty
+
+void SetFilterCache(const std::string &Directory)
+{
+    CacheDirectory = Directory;
+}
+
+static std::string CacheFile(const std::string &Key)
+{
+    unsigned long long Hash = 14695981039346656037ULL;   // FNV-1a
+    for(unsigned char c : Key) Hash = (Hash ^ c) * 1099511628211ULL;
+    char Name[32];
+    snprintf(Name, sizeof(Name), "/%016llx.fir", Hash);
+    return CacheDirectory + Name;
+}
+
+// file: the spec key, the number of taps, then the coefficients one per line to full precision
+static bool ReadCache(const std::string &Key, std::vector<double> &Coef)
+{
+    std::ifstream File(CacheFile(Key));
+    std::string Line;
+    int Taps = 0;
+    if(!std::getline(File, Line) || Line != Key || !(File >> Taps) || Taps <= 0 || Taps > 8192) return false;
+    Coef.resize(Taps);
+    for(double &Value : Coef) if(!(File >> Value)) return false;
+    return true;
+}
+
+static void WriteCache(const std::string &Key, const std::vector<double> &Coef)
+{
+    std::string Name = CacheFile(Key), Temporary = Name + ".tmp";
+    {
+        std::ofstream File(Temporary);
+        File << Key << "\n" << Coef.size() << "\n";
+        char Value[32];
+        for(double c : Coef)
+        {
+            snprintf(Value, sizeof(Value), "%.17g\n", c);
+            File << Value;
+        }
+        if(!File) return;
+    }
+    std::rename(Temporary.c_str(), Name.c_str());   // complete files only, a reader never sees half of one
+}
+
+std::vector<double> CachedFilter(const FilterSpec &Spec, bool *Designed)
+{
+    std::vector<double> Coef;
+    std::string Key = Spec.Key();
+    bool Found = !CacheDirectory.empty() && ReadCache(Key, Coef);
+    if(!Found)
+    {
+        Coef = DesignFilter(Spec);
+        if(!CacheDirectory.empty() && !Coef.empty()) WriteCache(Key, Coef);
+    }
+    if(Designed) *Designed = !Found;
+    return Coef;
+}
+
+std::string FilterTable(const std::vector<double> &Coef, const FilterSpec &Spec, const std::string &Name)
+{
+    FilterResponse Response = MeasureFilter(Coef, Spec);
+    std::string Text;
+    char Line[256];
+    snprintf(Line, sizeof(Line), "// %s, %s by %d at %.0fHz, passband 0-%.0fHz ripple %.3fdB, stopband %.0fHz -%.1fdB\n"
+             "// designed by: --design-filter %s,%s,%d,%.10g,%.10g,%.10g,%.10g,%.10g,%d\n\n\n",
+             Name.c_str(), (Spec.Stage == FilterSpec::Decimate) ? "decimate" : "upsample", Spec.Ratio, Spec.SampleRate,
+             Spec.Passband, Response.Ripple, Spec.Stopband, Response.Attenuation,
+             (Spec.Design == FilterSpec::Remez) ? "remez" : "kaiser", (Spec.Stage == FilterSpec::Decimate) ? "decimate" : "interpolate",
+             Spec.Ratio, Spec.SampleRate, Spec.Passband, Spec.Stopband, Spec.Ripple, Spec.Attenuation, int(Coef.size()));
+    Text += Line;
+    snprintf(Line, sizeof(Line), "#define %s_Order %d             // for polyphase filter must be a multiple of %d\n\n\n"
+             "inline constexpr double %sCoef[%d] {\n\n", Name.c_str(), int(Coef.size()), Spec.Ratio, Name.c_str(), int(Coef.size()));
+    Text += Line;
+    for(size_t n = 0; n < Coef.size(); n++)
+    {
+        snprintf(Line, sizeof(Line), "    /* %sCoef[%d] */       %1.10f ,\n", Name.c_str(), int(n), Coef[n]);
+        Text += Line;
+    }
+    Text += "\n};\n";
+    return Text;
+}
@@ -0,0 +1,107 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+#ifndef FILTERDESIGN_H
+#define FILTERDESIGN_H
+
+#include "filters.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+
+// Low pass filter design in process, in place of the Octave scripts quoted in filters.h. Symmetric (linear phase)
+// FIRs for a polyphase decimator or interpolator, from a spec of passband and stopband edges, passband ripple and
+// stopband attenuation, by either of:
+//   Remez   Parks-McClellan, the remez exchange as in the Octave remez() the tables in filters.h came from (grid
+//           density 16, band edges and weights the same), equiripple, the fewest taps for a spec
+//   Kaiser  windowed sinc, cutoff midway between the edges, beta and length from Kaiser's formulas, more taps for
+//           the same spec but the stopband falls away from the edge instead of staying at the ripple
+// Either way the taps are a multiple of the ratio, the fewest that meet the spec unless the spec fixes the count:
+// bracketed from the estimate for the spec (up to twice it) and found by bisection, each length measured on its
+// design, and a length whose Remez exchange does not converge passed over for the next multiple of the ratio. A
+// spec not met by then, or beyond 4096 taps, is not reachable and gives no design. The
+// coefficients have unity gain at DC, for an interpolator the polyphase table multiplies them up (InterpolatorTable).
+//
+// Designs are cached on disk, one small text file per spec in the directory set by SetFilterCache, named by a hash
+// of the spec and holding the spec itself to check against, so a design is only computed the first time it is
+// asked for. A design runs in a stage of the receive chain at its own length (LoadDesign, DSPthread --stage-filter),
+// the stage ratios stay fixed at compile time; FilterTable formats a design as one of the filters.h arrays to
+// make it the default.
+
+struct FilterSpec
+{
+    enum Method { Remez, Kaiser };
+    enum Use { Decimate, Interpolate };
+
+    Method Design = Remez;
+    Use Stage = Decimate;
+    int Ratio = 1;               // decimation or upsampling ratio, the taps are a multiple of it
+    double SampleRate = 0;       // Hz, the high rate: decimator input, interpolator output
+    double Passband = 0;         // Hz, passband edge
+    double Stopband = 0;         // Hz, stopband edge
+    double Ripple = 0.1;         // dB, largest passband deviation from unity gain
+    double Attenuation = 45;     // dB, least stopband attenuation
+    int Taps = 0;                // the number of taps, or 0 for the fewest that meet Ripple and Attenuation
+
+    std::string Key(void) const;                // canonical text of the spec, the cache key
+    bool Parse(const std::string &Text);        // "remez|kaiser,decimate|interpolate,Ratio,SampleRate,Passband,Stopband,Ripple,Attenuation[,Taps]"
+    bool Valid(void) const;                     // edges in order below SampleRate/2, ripple and attenuation above 0
+};
+
+struct FilterResponse
+{
+    double Ripple;               // dB, largest passband deviation from unity gain
+    double Attenuation;          // dB, least stopband attenuation
+};
+
+// Parks-McClellan: Taps coefficients, Bands bands of Edges[2*Bands] (0 to 1 = half the sample rate, as remez()),
+// Desired[2*Bands] gains at the edges (constant over each band) and Weights[Bands], empty if the exchange does not
+// converge
+std::vector<double> RemezFilter(int Taps, const double *Edges, const double *Desired, const double *Weights, int Bands);
+
+// Kaiser windowed sinc: Taps coefficients, Cutoff 0 to 1 = half the sample rate, window Beta
+std::vector<double> KaiserFilter(int Taps, double Cutoff, double Beta);
+
+FilterResponse MeasureFilter(const std::vector<double> &Coef, const FilterSpec &Spec);
+std::vector<double> DesignFilter(const FilterSpec &Spec);       // empty if the spec is not Valid or not reachable
+
+void SetFilterCache(const std::string &Directory);              // where designs are kept, none kept if not set
+std::vector<double> CachedFilter(const FilterSpec &Spec, bool *Designed = nullptr);   // from the cache, or designed and cached
+
+std::string FilterTable(const std::vector<double> &Coef, const FilterSpec &Spec, const std::string &Name);   // as a filters.h array
+
+// A design as the polyphase table of a decimator or interpolator stage (laid out as DecimatorTable or
+// InterpolatorTable) at its own length, rounded up to a multiple of Phases with zeros either side if it is not one.
+// False, and the table left as it was, for an empty design.
+template<typename T, int Phases>
+bool LoadDesign(const std::vector<double> &Coef, FilterSpec::Use Stage, PolyphaseVector<T, Phases> &Table)
+{
+    int Size = int(Coef.size());
+    if(Size == 0) return false;
+
+    int Taps = (Size + Phases - 1) / Phases;
+    std::vector<double> Padded(Phases * Taps, 0.0);
+    std::copy(Coef.begin(), Coef.end(), Padded.begin() + (Phases * Taps - Size) / 2);
+    PolyphaseVector<T, Phases> Loaded;
+    Loaded.Taps = Taps;
+    Loaded.Coef.resize(Phases * Taps);
+    for(int Phase = 0; Phase < Phases; Phase++)
+        for(int index = 0; index < Taps; index++)
+            Loaded.Coef[Phase*Taps+index] = (Stage == FilterSpec::Decimate) ? Coefficient<T>(Padded[(Phases-1-Phase)+(index*Phases)])
+                                                                          : Coefficient<T>(Padded[Phase+(index*Phases)] * Phases);
+    Table = std::move(Loaded);
+    return true;
+}
+
+#endif // FILTERDESIGN_H
@@ -13,6 +13,10 @@
 #ifndef FILTERS_H
 #define FILTERS_H
 
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
 // Decimate by 2 filter (D2A) Passband 200KHz, Stopband 500-1000KHz -56dB
 
 // Matlab / Octave code below:
@@ -46,12 +50,8 @@
 
 #define D2A_Order 18             // for polyphase filter must be a multiple of 2
 
-double (*I_D2AA)[D2A_Order/2];    // pointer to polyphase filter arrays channel A
-double (*Q_D2AA)[D2A_Order/2];
-double (*I_D2AB)[D2A_Order/2];    // pointer to polyphase filter arrays channel B
-double (*Q_D2AB)[D2A_Order/2];
 
-double D2ACoef[18] {
+inline constexpr double D2ACoef[18] {
 
     /* D2ACoef[0] */       0.0035056984 ,
     /* D2ACoef[1] */       0.0110740018 ,
@@ -108,12 +108,8 @@ double D2ACoef[18] {
 
 #define D2B_Order 18             // for polyphase filter must be a multiple of 2
 
-double (*I_D2BA)[D2B_Order/2];    // pointer to polyphase filter arrays Ch A
-double (*Q_D2BA)[D2B_Order/2];
-double (*I_D2BB)[D2B_Order/2];    // pointer to polyphase filter arrays Ch B
-double (*Q_D2BB)[D2B_Order/2];
 
-double D2BCoef[18] {
+inline constexpr double D2BCoef[18] {
 
     /* D2BCoef[0] */       0.0035056984 ,
     /* D2BCoef[1] */       0.0110740018 ,
@@ -138,6 +134,55 @@ double D2BCoef[18] {
 
 
 
+// CIC droop compensation filters (CIC4Comp, CIC2Comp) for the 4 stage CIC front end (see cicfilter.h)
+// Flat to 0.005dB over the D5 passband, 0-46.25KHz at 500KHz (decimate by 4) or 0-92.5KHz at 1MHz (decimate by 2)
+
+// Matlab / Octave code below:
+
+
+// % CIC compensation filter for RSPduoEME
+//
+// % Least squares fit to the inverse of the CIC response over the passband, unity gain at DC
+//
+// R=4;      % CIC decimation, 2 for CIC2Comp
+// N=4;      % CIC stages
+// Fp=0.0925; % passband edge (cycles per output sample)
+// Order=2;  % Output is Order+1 taps (odd, symmetric)
+//
+// K=Order/2;
+// f=linspace(0,Fp,401)';
+// C=abs(sin(pi*f)./(R*sin(pi*f/R))).^N; C(1)=1;
+// A=[ones(size(f)),2*cos(2*pi*f*(1:K))];
+// a=A\(1./C);
+// a=a/(a(1)+2*sum(a(2:end)));
+// B=[flipud(a(2:end));a];
+//
+// i=linspace(0,Order,Order+1);
+//
+// fprintf('/* CIC4Comp[%i] */       %1.10f ,\n',[i;B']);
+
+
+#define CICComp_Order 3          // odd, symmetric
+
+
+inline constexpr double CIC4Comp[3] {
+
+    /* CIC4Comp[0] */       -0.1642242285 ,
+    /* CIC4Comp[1] */       1.3284484569 ,
+    /* CIC4Comp[2] */       -0.1642242285 ,
+
+};
+
+inline constexpr double CIC2Comp[3] {
+
+    /* CIC2Comp[0] */       -0.1308324126 ,
+    /* CIC2Comp[1] */       1.2616648252 ,
+    /* CIC2Comp[2] */       -0.1308324126 ,
+
+};
+
+
+
 // Decimate by 5 filter (DF5) Bandwith 1/5, stopband -45dB
 
 // Matlab / Octave code below:
@@ -171,12 +216,8 @@ double D2BCoef[18] {
 
 #define D5_Order 220           // for polyphase filter must be a multiple of 5
 
-double (*I_D5A)[D5_Order/5];    // pointer to polyphase filter arrays Ch A
-double (*Q_D5A)[D5_Order/5];
-double (*I_D5B)[D5_Order/5];    // pointer to polyphase filter arrays Ch B
-double (*Q_D5B)[D5_Order/5];
 
-double D5Coef[220] {
+inline constexpr double D5Coef[220] {
 
     /* D5Coef[0] */       -0.0016951303 ,
     /* D5Coef[1] */       0.0013122481 ,
@@ -435,12 +476,8 @@ double D5Coef[220] {
 
 #define US6_Order 216       // for polyphase filter must be a multiple of 6
 
-double *I_US6A;              // pointer to Filter arrays Ch A
-double *Q_US6A;
-double *I_US6B;              // pointer to Filter arrays Ch B
-double *Q_US6B;
 
-double US6Coef[216] {
+inline constexpr double US6Coef[216] {
 
     /* UF6Coef[0] */       -0.0028282031 ,
     /* UF6Coef[1] */       -0.0007784151 ,
@@ -695,12 +732,8 @@ double US6Coef[216] {
 
 #define US4_Order 220       // for polyphase filter must be a multiple of 4
 
-double *I_US4A;              // pointer to Filter arrays Ch A
-double *Q_US4A;
-double *I_US4B;              // pointer to Filter arrays Ch B
-double *Q_US4B;
 
-double US4Coef[220] {
+inline constexpr double US4Coef[220] {
 
     /* UF4Coef[0] */       -0.0016951303 ,
     /* UF4Coef[1] */       0.0013122481 ,
@@ -925,4 +958,112 @@ double US4Coef[220] {
 
 };
 
+// *****************************  Polyphase coefficient tables  ****************************** //
+
+// The coefficients above rearranged at compile time into one contiguous, cache line aligned array per subfilter,
+// in the same newest first order as the delay lines, so the FIR kernels read both with unit stride.
+// Decimators:    Table[stage][index] = Coef[(Phases-1-stage)+(index*Phases)]
+// Interpolators: Table[loop][index]  = Coef[loop+(index*Phases)] * Phases   (upsampling gain folded in)
+// Integer tables hold them as Q15, rounded to the nearest 1/32768: int32 for the stages of the fixed point chain,
+// int16 for its mixer (saturated, the D2A coefficients times the oscillator are well inside).
+
+template<typename T>
+constexpr T Coefficient(double Value)   // Value as stored in a table of T
+{
+    if constexpr(std::is_integral<T>::value)
+    {
+        double Scaled = Value * 32768;
+        if(std::is_same<T, short>::value && (Scaled >= 32767)) return 32767;
+        if(std::is_same<T, short>::value && (Scaled <= -32768)) return -32768;
+        return T((Scaled >= 0) ? (Scaled + 0.5) : (Scaled - 0.5));
+    }
+    else return T(Value);
+}
+
+template<typename T, int Phases, int Taps>
+struct PolyphaseTable
+{
+    alignas(64) T Coef[Phases][Taps];
+
+    constexpr const T *operator[](int Phase) const { return Coef[Phase]; }
+};
+
+// the same layout with the taps per subfilter chosen at run time, for a designed filter (see LoadDesign)
+template<typename T, int Phases>
+struct PolyphaseVector
+{
+    int Taps = 0;                // per subfilter, 0 for none
+    std::vector<T> Coef;         // Phases subfilters of Taps, one after another
+
+    const T *operator[](int Phase) const { return Coef.data() + (Phase * Taps); }
+};
+
+template<typename T, int Phases, int Order>
+constexpr PolyphaseTable<T, Phases, Order/Phases> DecimatorTable(const double (&Coef)[Order])
+{
+    static_assert(Order % Phases == 0, "polyphase filter order must be a multiple of the decimation factor");
+    PolyphaseTable<T, Phases, Order/Phases> Table {};
+    for(int stage = 0; stage < Phases; stage++)
+        for(int index = 0; index < Order/Phases; index++) Table.Coef[stage][index] = Coefficient<T>(Coef[(Phases-1-stage)+(index*Phases)]);
+    return Table;
+}
+
+template<typename T, int Phases, int Order>
+constexpr PolyphaseTable<T, Phases, Order/Phases> InterpolatorTable(const double (&Coef)[Order])
+{
+    static_assert(Order % Phases == 0, "polyphase filter order must be a multiple of the upsampling factor");
+    PolyphaseTable<T, Phases, Order/Phases> Table {};
+    for(int loop = 0; loop < Phases; loop++)
+        for(int index = 0; index < Order/Phases; index++) Table.Coef[loop][index] = Coefficient<T>(Coef[loop+(index*Phases)] * Phases);
+    return Table;
+}
+
+inline constexpr auto D2APhase = DecimatorTable<float, 2>(D2ACoef);          // float tables for the FIR kernels
+inline constexpr auto D2BPhase = DecimatorTable<float, 2>(D2BCoef);
+inline constexpr auto D5Phase = DecimatorTable<float, 5>(D5Coef);
+inline constexpr auto US6Phase = InterpolatorTable<float, 6>(US6Coef);
+inline constexpr auto US4Phase = InterpolatorTable<float, 4>(US4Coef);
+
+inline constexpr auto D2APhaseDouble = DecimatorTable<double, 2>(D2ACoef);   // double tables, same layout
+inline constexpr auto D2BPhaseDouble = DecimatorTable<double, 2>(D2BCoef);
+inline constexpr auto D5PhaseDouble = DecimatorTable<double, 5>(D5Coef);
+inline constexpr auto US6PhaseDouble = InterpolatorTable<double, 6>(US6Coef);
+inline constexpr auto US4PhaseDouble = InterpolatorTable<double, 4>(US4Coef);
+
+inline constexpr auto D2BPhaseQ15 = DecimatorTable<int, 2>(D2BCoef);         // Q15 tables for the fixed point chain
+inline constexpr auto D5PhaseQ15 = DecimatorTable<int, 5>(D5Coef);
+inline constexpr auto US6PhaseQ15 = InterpolatorTable<int, 6>(US6Coef);
+inline constexpr auto US4PhaseQ15 = InterpolatorTable<int, 4>(US4Coef);
+
+// The Q15 kernels (firkernels.h) sum products of full scale samples into 32 bit lanes, which cannot overflow while
+// the Q15 coefficient magnitudes summed into one lane add up to less than 2 (65536). A lane takes at most every other
+// tap or every other pair of taps of a subfilter, and of a folded (symmetric decimator) subfilter all of it, or every
+// other pair of it twice over (both halves of the fold). They run the fixed point mixer, whose tables are the D2A
+// filter, as one subfilter, times the oscillator, no larger.
+template<typename T>
+constexpr long Q15LaneSum(const T *Subfilter, int Taps, bool Folded)
+{
+    long Row = 0, Pair[2] = { 0, 0 }, Tap[2] = { 0, 0 }, Largest = 0;
+    for(int index = 0; index < Taps; index++)
+    {
+        long Magnitude = (Subfilter[index] < 0) ? -Subfilter[index] : Subfilter[index];
+        Row += Magnitude;
+        Pair[(index / 2) % 2] += Magnitude;
+        Tap[index % 2] += Magnitude;
+    }
+    long Lane[7] = { Pair[0], Pair[1], Tap[0], Tap[1], Folded ? Row : 0, Folded ? 2 * Pair[0] : 0, Folded ? 2 * Pair[1] : 0 };
+    for(long Each : Lane) if(Each > Largest) Largest = Each;
+    return Largest;
+}
+
+template<typename T, int Phases, int Taps>
+constexpr long Q15LaneSum(const PolyphaseTable<T, Phases, Taps> &Table, bool Folded)
+{
+    long Largest = 0;
+    for(int Phase = 0; Phase < Phases; Phase++) Largest = std::max(Largest, Q15LaneSum(Table.Coef[Phase], Taps, Folded));
+    return Largest;
+}
+
+static_assert(Q15LaneSum(DecimatorTable<short, 1>(D2ACoef), false) < 65536, "Q15 kernel lanes could overflow with the D2A mixer tables");
+
 #endif // FILTERS_H
@@ -0,0 +1,1388 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+#include "firkernels.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FIR_X86
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define FIR_TARGET(Features) __attribute__((target(Features)))
+#else
+#define FIR_TARGET(Features)
+#endif
+#elif defined(__ARM_NEON)
+#define FIR_NEON
+#include <arm_neon.h>
+#endif
+
+
+// *****************************  Scalar reference  ****************************** //
+
+
+static float DotScalar(const float *x, const float *h, int Length)
+{
+    float Acc = 0;
+    for(int k = 0; k < Length; k++) Acc += x[k] * h[k];
+    return Acc;
+}
+
+
+static void DotIQScalar(const float *I, const float *Q, const float *h, int Length, float *OutI, float *OutQ)
+{
+    float AccI = 0, AccQ = 0;
+    for(int k = 0; k < Length; k++)
+    {
+        AccI += I[k] * h[k];
+        AccQ += Q[k] * h[k];
+    }
+    *OutI = AccI;
+    *OutQ = AccQ;
+}
+
+static void FoldIQScalar(const float *I1, const float *Q1, const float *I2, const float *Q2, const float *h, int Length, float *OutI, float *OutQ)
+{
+    float AccI = 0, AccQ = 0;
+    for(int k = 0; k < Length; k++)
+    {
+        AccI += (I1[k] + I2[k]) * h[k];
+        AccQ += (Q1[k] + Q2[k]) * h[k];
+    }
+    *OutI = AccI;
+    *OutQ = AccQ;
+}
+
+static void Dot4Scalar(const float *x, const float *h, int Length, float *Out)
+{
+    float Acc[4] = {0, 0, 0, 0};
+    for(int k = 0; k < Length; k++)
+        for(int Lane = 0; Lane < 4; Lane++) Acc[Lane] += x[(4 * k) + Lane] * h[k];
+    for(int Lane = 0; Lane < 4; Lane++) Out[Lane] = Acc[Lane];
+}
+
+static void Fold4Scalar(const float *x1, const float *x2, const float *h, int Length, float *Out)
+{
+    float Acc[4] = {0, 0, 0, 0};
+    for(int k = 0; k < Length; k++)
+        for(int Lane = 0; Lane < 4; Lane++) Acc[Lane] += (x1[(4 * k) + Lane] + x2[(4 * k) + Lane]) * h[k];
+    for(int Lane = 0; Lane < 4; Lane++) Out[Lane] = Acc[Lane];
+}
+
+static void Dot4LanesScalar(const float *x, const float *h, int Length, float *Out)
+{
+    float Acc[4] = {0, 0, 0, 0};
+    for(int k = 0; k < 4 * Length; k += 4)
+        for(int Lane = 0; Lane < 4; Lane++) Acc[Lane] += x[k + Lane] * h[k + Lane];
+    for(int Lane = 0; Lane < 4; Lane++) Out[Lane] = Acc[Lane];
+}
+
+static void ButterflyDITScalar(float *ar, float *ai, float *br, float *bi, const float *wr, const float *wi, int Length)
+{
+    for(int k = 0; k < Length; k++)
+    {
+        float tr = (br[k] * wr[k]) - (bi[k] * wi[k]);
+        float ti = (br[k] * wi[k]) + (bi[k] * wr[k]);
+        br[k] = ar[k] - tr; bi[k] = ai[k] - ti;
+        ar[k] += tr; ai[k] += ti;
+    }
+}
+
+static void ButterflyDIFScalar(float *ar, float *ai, float *br, float *bi, const float *wr, const float *wi, int Length)
+{
+    for(int k = 0; k < Length; k++)
+    {
+        float tr = ar[k] - br[k], ti = ai[k] - bi[k];
+        ar[k] += br[k]; ai[k] += bi[k];
+        br[k] = (tr * wr[k]) - (ti * wi[k]);
+        bi[k] = (tr * wi[k]) + (ti * wr[k]);
+    }
+}
+
+static void SpectrumMACScalar(const float *xr, const float *xi, const float *hr, const float *hi, float *yr, float *yi, int Length)
+{
+    for(int k = 0; k < Length; k++)
+    {
+        yr[k] += (xr[k] * hr[k]) - (xi[k] * hi[k]);
+        yi[k] += (xr[k] * hi[k]) + (xi[k] * hr[k]);
+    }
+}
+
+// Q15 kernels, int16 samples and coefficients summed exactly in 64 bits
+
+static long long DotQ15Scalar(const short *x, const short *h, int Length)
+{
+    long long Acc = 0;
+    for(int k = 0; k < Length; k++) Acc += x[k] * h[k];
+    return Acc;
+}
+
+static void DotIQQ15Scalar(const short *I, const short *Q, const short *h, int Length, long long *OutI, long long *OutQ)
+{
+    long long AccI = 0, AccQ = 0;
+    for(int k = 0; k < Length; k++)
+    {
+        AccI += I[k] * h[k];
+        AccQ += Q[k] * h[k];
+    }
+    *OutI = AccI;
+    *OutQ = AccQ;
+}
+
+static void FoldIQQ15Scalar(const short *I1, const short *Q1, const short *I2, const short *Q2, const short *h, int Length, long long *OutI, long long *OutQ)
+{
+    long long AccI = 0, AccQ = 0;
+    for(int k = 0; k < Length; k++)
+    {
+        AccI += (I1[k] + I2[k]) * h[k];
+        AccQ += (Q1[k] + Q2[k]) * h[k];
+    }
+    *OutI = AccI;
+    *OutQ = AccQ;
+}
+
+static void Dot4Q15Scalar(const short *x, const short *h, int Length, long long *Out)
+{
+    long long Acc[4] = {0, 0, 0, 0};
+    for(int k = 0; k < Length; k++)
+        for(int Lane = 0; Lane < 4; Lane++) Acc[Lane] += x[(4 * k) + Lane] * h[k];
+    for(int Lane = 0; Lane < 4; Lane++) Out[Lane] = Acc[Lane];
+}
+
+static void Fold4Q15Scalar(const short *x1, const short *x2, const short *h, int Length, long long *Out)
+{
+    long long Acc[4] = {0, 0, 0, 0};
+    for(int k = 0; k < Length; k++)
+        for(int Lane = 0; Lane < 4; Lane++) Acc[Lane] += (x1[(4 * k) + Lane] + x2[(4 * k) + Lane]) * h[k];
+    for(int Lane = 0; Lane < 4; Lane++) Out[Lane] = Acc[Lane];
+}
+
+static void Dot4LanesQ15Scalar(const short *x, const short *h, int Length, long long *Out)
+{
+    long long Acc[4] = {0, 0, 0, 0};
+    for(int k = 0; k < 4 * Length; k += 4)
+        for(int Lane = 0; Lane < 4; Lane++) Acc[Lane] += x[k + Lane] * h[k + Lane];
+    for(int Lane = 0; Lane < 4; Lane++) Out[Lane] = Acc[Lane];
+}
+
+static const FIRKernels Scalar = { "scalar", DotScalar, DotIQScalar, FoldIQScalar, Dot4Scalar, Fold4Scalar, Dot4LanesScalar,
+                                   ButterflyDITScalar, ButterflyDIFScalar, SpectrumMACScalar,
+                                   DotQ15Scalar, DotIQQ15Scalar, FoldIQQ15Scalar, Dot4Q15Scalar, Fold4Q15Scalar, Dot4LanesQ15Scalar };
+
+
+#if defined(FIR_X86)
+
+// *****************************  SSE2 (x86-64 baseline)  ****************************** //
+
+
+static inline float Sum128(__m128 v)
+{
+    __m128 Pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(_mm_add_ss(Pairs, _mm_shuffle_ps(Pairs, Pairs, 1)));
+}
+
+
+static float DotSSE2(const float *x, const float *h, int Length)
+{
+    __m128 Acc0 = _mm_setzero_ps(), Acc1 = _mm_setzero_ps();
+    int k = 0;
+    for(; k + 8 <= Length; k += 8)
+    {
+        Acc0 = _mm_add_ps(Acc0, _mm_mul_ps(_mm_loadu_ps(&x[k]), _mm_loadu_ps(&h[k])));
+        Acc1 = _mm_add_ps(Acc1, _mm_mul_ps(_mm_loadu_ps(&x[k + 4]), _mm_loadu_ps(&h[k + 4])));
+    }
+    if(k + 4 <= Length)
+    {
+        Acc0 = _mm_add_ps(Acc0, _mm_mul_ps(_mm_loadu_ps(&x[k]), _mm_loadu_ps(&h[k])));
+        k += 4;
+    }
+    float Acc = Sum128(_mm_add_ps(Acc0, Acc1));
+    for(; k < Length; k++) Acc += x[k] * h[k];
+    return Acc;
+}
+
+
+static void DotIQSSE2(const float *I, const float *Q, const float *h, int Length, float *OutI, float *OutQ)
+{
+    __m128 AccI = _mm_setzero_ps(), AccQ = _mm_setzero_ps();
+    int k = 0;
+    for(; k + 4 <= Length; k += 4)
+    {
+        __m128 Coef = _mm_loadu_ps(&h[k]);
+        AccI = _mm_add_ps(AccI, _mm_mul_ps(_mm_loadu_ps(&I[k]), Coef));
+        AccQ = _mm_add_ps(AccQ, _mm_mul_ps(_mm_loadu_ps(&Q[k]), Coef));
+    }
+    float SumI = Sum128(AccI), SumQ = Sum128(AccQ);
+    for(; k < Length; k++)
+    {
+        SumI += I[k] * h[k];
+        SumQ += Q[k] * h[k];
+    }
+    *OutI = SumI;
+    *OutQ = SumQ;
+}
+
+static void FoldIQSSE2(const float *I1, const float *Q1, const float *I2, const float *Q2, const float *h, int Length, float *OutI, float *OutQ)
+{
+    __m128 AccI = _mm_setzero_ps(), AccQ = _mm_setzero_ps();
+    int k = 0;
+    for(; k + 4 <= Length; k += 4)
+    {
+        __m128 Coef = _mm_loadu_ps(&h[k]);
+        AccI = _mm_add_ps(AccI, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&I1[k]), _mm_loadu_ps(&I2[k])), Coef));
+        AccQ = _mm_add_ps(AccQ, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&Q1[k]), _mm_loadu_ps(&Q2[k])), Coef));
+    }
+    float SumI = Sum128(AccI), SumQ = Sum128(AccQ);
+    for(; k < Length; k++)
+    {
+        SumI += (I1[k] + I2[k]) * h[k];
+        SumQ += (Q1[k] + Q2[k]) * h[k];
+    }
+    *OutI = SumI;
+    *OutQ = SumQ;
+}
+
+// four lane kernels, one tap of all four lanes per vector with its coefficient broadcast
+
+static void Dot4SSE2(const float *x, const float *h, int Length, float *Out)
+{
+    __m128 Acc0 = _mm_setzero_ps(), Acc1 = _mm_setzero_ps();
+    int k = 0;
+    for(; k + 2 <= Length; k += 2)
+    {
+        Acc0 = _mm_add_ps(Acc0, _mm_mul_ps(_mm_loadu_ps(&x[4 * k]), _mm_set1_ps(h[k])));
+        Acc1 = _mm_add_ps(Acc1, _mm_mul_ps(_mm_loadu_ps(&x[4 * k + 4]), _mm_set1_ps(h[k + 1])));
+    }
+    if(k < Length) Acc0 = _mm_add_ps(Acc0, _mm_mul_ps(_mm_loadu_ps(&x[4 * k]), _mm_set1_ps(h[k])));
+    _mm_storeu_ps(Out, _mm_add_ps(Acc0, Acc1));
+}
+
+static void Fold4SSE2(const float *x1, const float *x2, const float *h, int Length, float *Out)
+{
+    __m128 Acc0 = _mm_setzero_ps(), Acc1 = _mm_setzero_ps();
+    int k = 0;
+    for(; k + 2 <= Length; k += 2)
+    {
+        Acc0 = _mm_add_ps(Acc0, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&x1[4 * k]), _mm_loadu_ps(&x2[4 * k])), _mm_set1_ps(h[k])));
+        Acc1 = _mm_add_ps(Acc1, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&x1[4 * k + 4]), _mm_loadu_ps(&x2[4 * k + 4])), _mm_set1_ps(h[k + 1])));
+    }
+    if(k < Length) Acc0 = _mm_add_ps(Acc0, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&x1[4 * k]), _mm_loadu_ps(&x2[4 * k])), _mm_set1_ps(h[k])));
+    _mm_storeu_ps(Out, _mm_add_ps(Acc0, Acc1));
+}
+
+static void Dot4LanesSSE2(const float *x, const float *h, int Length, float *Out)
+{
+    __m128 Acc0 = _mm_setzero_ps(), Acc1 = _mm_setzero_ps();
+    int k = 0;
+    for(; k + 2 <= Length; k += 2)
+    {
+        Acc0 = _mm_add_ps(Acc0, _mm_mul_ps(_mm_loadu_ps(&x[4 * k]), _mm_loadu_ps(&h[4 * k])));
+        Acc1 = _mm_add_ps(Acc1, _mm_mul_ps(_mm_loadu_ps(&x[4 * k + 4]), _mm_loadu_ps(&h[4 * k + 4])));
+    }
+    if(k < Length) Acc0 = _mm_add_ps(Acc0, _mm_mul_ps(_mm_loadu_ps(&x[4 * k]), _mm_loadu_ps(&h[4 * k])));
+    _mm_storeu_ps(Out, _mm_add_ps(Acc0, Acc1));
+}
+
+static void ButterflyDITSSE2(float *ar, float *ai, float *br, float *bi, const float *wr, const float *wi, int Length)
+{
+    int k = 0;
+    for(; k + 4 <= Length; k += 4)
+    {
+        __m128 Br = _mm_loadu_ps(&br[k]), Bi = _mm_loadu_ps(&bi[k]), Wr = _mm_loadu_ps(&wr[k]), Wi = _mm_loadu_ps(&wi[k]);
+        __m128 Ar = _mm_loadu_ps(&ar[k]), Ai = _mm_loadu_ps(&ai[k]);
+        __m128 tr = _mm_sub_ps(_mm_mul_ps(Br, Wr), _mm_mul_ps(Bi, Wi));
+        __m128 ti = _mm_add_ps(_mm_mul_ps(Br, Wi), _mm_mul_ps(Bi, Wr));
+        _mm_storeu_ps(&br[k], _mm_sub_ps(Ar, tr)); _mm_storeu_ps(&bi[k], _mm_sub_ps(Ai, ti));
+        _mm_storeu_ps(&ar[k], _mm_add_ps(Ar, tr)); _mm_storeu_ps(&ai[k], _mm_add_ps(Ai, ti));
+    }
+    ButterflyDITScalar(&ar[k], &ai[k], &br[k], &bi[k], &wr[k], &wi[k], Length - k);
+}
+
+static void ButterflyDIFSSE2(float *ar, float *ai, float *br, float *bi, const float *wr, const float *wi, int Length)
+{
+    int k = 0;
+    for(; k + 4 <= Length; k += 4)
+    {
+        __m128 Ar = _mm_loadu_ps(&ar[k]), Ai = _mm_loadu_ps(&ai[k]), Br = _mm_loadu_ps(&br[k]), Bi = _mm_loadu_ps(&bi[k]);
+        __m128 Wr = _mm_loadu_ps(&wr[k]), Wi = _mm_loadu_ps(&wi[k]);
+        __m128 tr = _mm_sub_ps(Ar, Br), ti = _mm_sub_ps(Ai, Bi);
+        _mm_storeu_ps(&ar[k], _mm_add_ps(Ar, Br)); _mm_storeu_ps(&ai[k], _mm_add_ps(Ai, Bi));
+        _mm_storeu_ps(&br[k], _mm_sub_ps(_mm_mul_ps(tr, Wr), _mm_mul_ps(ti, Wi)));
+        _mm_storeu_ps(&bi[k], _mm_add_ps(_mm_mul_ps(tr, Wi), _mm_mul_ps(ti, Wr)));
+    }
+    ButterflyDIFScalar(&ar[k], &ai[k], &br[k], &bi[k], &wr[k], &wi[k], Length - k);
+}
+
+static void SpectrumMACSSE2(const float *xr, const float *xi, const float *hr, const float *hi, float *yr, float *yi, int Length)
+{
+    int k = 0;
+    for(; k + 4 <= Length; k += 4)
+    {
+        __m128 Xr = _mm_loadu_ps(&xr[k]), Xi = _mm_loadu_ps(&xi[k]), Hr = _mm_loadu_ps(&hr[k]), Hi = _mm_loadu_ps(&hi[k]);
+        _mm_storeu_ps(&yr[k], _mm_add_ps(_mm_loadu_ps(&yr[k]), _mm_sub_ps(_mm_mul_ps(Xr, Hr), _mm_mul_ps(Xi, Hi))));
+        _mm_storeu_ps(&yi[k], _mm_add_ps(_mm_loadu_ps(&yi[k]), _mm_add_ps(_mm_mul_ps(Xr, Hi), _mm_mul_ps(Xi, Hr))));
+    }
+    SpectrumMACScalar(&xr[k], &xi[k], &hr[k], &hi[k], &yr[k], &yi[k], Length - k);
+}
+
+// Q15 kernels, pmaddwd multiplies eight int16 pairs and adds each two neighbours into four 32 bit lanes
+
+static inline long long Sum128Q15(__m128i v)
+{
+    alignas(16) int Lane[4];
+    _mm_store_si128((__m128i *)Lane, v);
+    return (long long)Lane[0] + Lane[1] + Lane[2] + Lane[3];
+}
+
+// taps k and k+1 of four lanes (eight int16) rearranged to neighbours, lane by lane, for pmaddwd
+static inline __m128i PairTaps(__m128i v)
+{
+    return _mm_unpacklo_epi16(v, _mm_srli_si128(v, 8));
+}
+
+// coefficients h[0] and h[1] as a neighbour pair in every lane
+static inline __m128i PairCoef(const short *h)
+{
+    return _mm_set1_epi32((int)((unsigned short)h[0] | ((unsigned int)(unsigned short)h[1] << 16)));
+}
+
+static long long DotQ15SSE2(const short *x, const short *h, int Length)
+{
+    __m128i Acc0 = _mm_setzero_si128(), Acc1 = _mm_setzero_si128();
+    int k = 0;
+    for(; k + 16 <= Length; k += 16)
+    {
+        Acc0 = _mm_add_epi32(Acc0, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)&x[k]), _mm_loadu_si128((const __m128i *)&h[k])));
+        Acc1 = _mm_add_epi32(Acc1, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)&x[k + 8]), _mm_loadu_si128((const __m128i *)&h[k + 8])));
+    }
+    if(k + 8 <= Length)
+    {
+        Acc0 = _mm_add_epi32(Acc0, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)&x[k]), _mm_loadu_si128((const __m128i *)&h[k])));
+        k += 8;
+    }
+    long long Acc = Sum128Q15(Acc0) + Sum128Q15(Acc1);
+    for(; k < Length; k++) Acc += x[k] * h[k];
+    return Acc;
+}
+
+static void DotIQQ15SSE2(const short *I, const short *Q, const short *h, int Length, long long *OutI, long long *OutQ)
+{
+    __m128i AccI = _mm_setzero_si128(), AccQ = _mm_setzero_si128();
+    int k = 0;
+    for(; k + 8 <= Length; k += 8)
+    {
+        __m128i Coef = _mm_loadu_si128((const __m128i *)&h[k]);
+        AccI = _mm_add_epi32(AccI, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)&I[k]), Coef));
+        AccQ = _mm_add_epi32(AccQ, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)&Q[k]), Coef));
+    }
+    long long SumI = Sum128Q15(AccI), SumQ = Sum128Q15(AccQ);
+    for(; k < Length; k++)
+    {
+        SumI += I[k] * h[k];
+        SumQ += Q[k] * h[k];
+    }
+    *OutI = SumI;
+    *OutQ = SumQ;
+}
+
+// the two halves are not pre-added, the int16 sum could overflow, each goes through pmaddwd
+static void FoldIQQ15SSE2(const short *I1, const short *Q1, const short *I2, const short *Q2, const short *h, int Length, long long *OutI, long long *OutQ)
+{
+    __m128i AccI = _mm_setzero_si128(), AccQ = _mm_setzero_si128();
+    int k = 0;
+    for(; k + 8 <= Length; k += 8)
+    {
+        __m128i Coef = _mm_loadu_si128((const __m128i *)&h[k]);
+        AccI = _mm_add_epi32(AccI, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)&I1[k]), Coef));
+        AccQ = _mm_add_epi32(AccQ, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)&Q1[k]), Coef));
+        AccI = _mm_add_epi32(AccI, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)&I2[k]), Coef));
+        AccQ = _mm_add_epi32(AccQ, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)&Q2[k]), Coef));
+    }
+    long long SumI = Sum128Q15(AccI), SumQ = Sum128Q15(AccQ);
+    for(; k < Length; k++)
+    {
+        SumI += (I1[k] + I2[k]) * h[k];
+        SumQ += (Q1[k] + Q2[k]) * h[k];
+    }
+    *OutI = SumI;
+    *OutQ = SumQ;
+}
+
+// four lane kernels, two taps of all four lanes per vector against a broadcast coefficient pair, alternate pairs
+// of taps in two accumulators
+
+static inline void Lanes128Q15(__m128i Acc0, __m128i Acc1, long long *Out)
+{
+    alignas(16) int Lane0[4], Lane1[4];
+    _mm_store_si128((__m128i *)Lane0, Acc0);
+    _mm_store_si128((__m128i *)Lane1, Acc1);
+    for(int Lane = 0; Lane < 4; Lane++) Out[Lane] = (long long)Lane0[Lane] + Lane1[Lane];
+}
+
+static void Dot4Q15SSE2(const short *x, const short *h, int Length, long long *Out)
+{
+    __m128i Acc0 = _mm_setzero_si128(), Acc1 = _mm_setzero_si128();
+    int k = 0;
+    for(; k + 4 <= Length; k += 4)
+    {
+        Acc0 = _mm_add_epi32(Acc0, _mm_madd_epi16(PairTaps(_mm_loadu_si128((const __m128i *)&x[4 * k])), PairCoef(&h[k])));
+        Acc1 = _mm_add_epi32(Acc1, _mm_madd_epi16(PairTaps(_mm_loadu_si128((const __m128i *)&x[4 * k + 8])), PairCoef(&h[k + 2])));
+    }
+    if(k + 2 <= Length)
+    {
+        Acc0 = _mm_add_epi32(Acc0, _mm_madd_epi16(PairTaps(_mm_loadu_si128((const __m128i *)&x[4 * k])), PairCoef(&h[k])));
+        k += 2;
+    }
+    Lanes128Q15(Acc0, Acc1, Out);
+    if(k < Length) for(int Lane = 0; Lane < 4; Lane++) Out[Lane] += x[(4 * k) + Lane] * h[k];
+}
+
+static void Fold4Q15SSE2(const short *x1, const short *x2, const short *h, int Length, long long *Out)
+{
+    __m128i Acc0 = _mm_setzero_si128(), Acc1 = _mm_setzero_si128();
+    int k = 0;
+    for(; k + 2 <= Length; k += 2)
+    {
+        __m128i Coef = PairCoef(&h[k]);
+        Acc0 = _mm_add_epi32(Acc0, _mm_madd_epi16(PairTaps(_mm_loadu_si128((const __m128i *)&x1[4 * k])), Coef));
+        Acc1 = _mm_add_epi32(Acc1, _mm_madd_epi16(PairTaps(_mm_loadu_si128((const __m128i *)&x2[4 * k])), Coef));
+    }
+    Lanes128Q15(Acc0, Acc1, Out);
+    if(k < Length) for(int Lane = 0; Lane < 4; Lane++) Out[Lane] += (x1[(4 * k) + Lane] + x2[(4 * k) + Lane]) * h[k];
+}
+
+static void Dot4LanesQ15SSE2(const short *x, const short *h, int Length, long long *Out)
+{
+    __m128i Acc0 = _mm_setzero_si128(), Acc1 = _mm_setzero_si128();
+    int k = 0;
+    for(; k + 4 <= Length; k += 4)
+    {
+        Acc0 = _mm_add_epi32(Acc0, _mm_madd_epi16(PairTaps(_mm_loadu_si128((const __m128i *)&x[4 * k])), PairTaps(_mm_loadu_si128((const __m128i *)&h[4 * k]))));
+        Acc1 = _mm_add_epi32(Acc1, _mm_madd_epi16(PairTaps(_mm_loadu_si128((const __m128i *)&x[4 * k + 8])), PairTaps(_mm_loadu_si128((const __m128i *)&h[4 * k + 8]))));
+    }
+    if(k + 2 <= Length)
+    {
+        Acc0 = _mm_add_epi32(Acc0, _mm_madd_epi16(PairTaps(_mm_loadu_si128((const __m128i *)&x[4 * k])), PairTaps(_mm_loadu_si128((const __m128i *)&h[4 * k]))));
+        k += 2;
+    }
+    Lanes128Q15(Acc0, Acc1, Out);
+    if(k < Length) for(int Lane = 0; Lane < 4; Lane++) Out[Lane] += x[(4 * k) + Lane] * h[(4 * k) + Lane];
+}
+
+static const FIRKernels SSE2 = { "sse2", DotSSE2, DotIQSSE2, FoldIQSSE2, Dot4SSE2, Fold4SSE2, Dot4LanesSSE2,
+                                 ButterflyDITSSE2, ButterflyDIFSSE2, SpectrumMACSSE2,
+                                 DotQ15SSE2, DotIQQ15SSE2, FoldIQQ15SSE2, Dot4Q15SSE2, Fold4Q15SSE2, Dot4LanesQ15SSE2 };
+
+
+// *****************************  AVX2 + FMA  ****************************** //
+
+
+FIR_TARGET("avx2,fma") static inline float Sum256(__m256 v)
+{
+    return Sum128(_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+}
+
+
+FIR_TARGET("avx2,fma") static float DotAVX2(const float *x, const float *h, int Length)
+{
+    __m256 Acc0 = _mm256_setzero_ps(), Acc1 = _mm256_setzero_ps();
+    int k = 0;
+    for(; k + 16 <= Length; k += 16)
+    {
+        Acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(&x[k]), _mm256_loadu_ps(&h[k]), Acc0);
+        Acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(&x[k + 8]), _mm256_loadu_ps(&h[k + 8]), Acc1);
+    }
+    if(k + 8 <= Length)
+    {
+        Acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(&x[k]), _mm256_loadu_ps(&h[k]), Acc0);
+        k += 8;
+    }
+    float Acc = Sum256(_mm256_add_ps(Acc0, Acc1));
+    for(; k < Length; k++) Acc += x[k] * h[k];
+    return Acc;
+}
+
+
+FIR_TARGET("avx2,fma") static void DotIQAVX2(const float *I, const float *Q, const float *h, int Length, float *OutI, float *OutQ)
+{
+    __m256 AccI = _mm256_setzero_ps(), AccQ = _mm256_setzero_ps();
+    int k = 0;
+    for(; k + 8 <= Length; k += 8)
+    {
+        __m256 Coef = _mm256_loadu_ps(&h[k]);
+        AccI = _mm256_fmadd_ps(_mm256_loadu_ps(&I[k]), Coef, AccI);
+        AccQ = _mm256_fmadd_ps(_mm256_loadu_ps(&Q[k]), Coef, AccQ);
+    }
+    float SumI = Sum256(AccI), SumQ = Sum256(AccQ);
+    for(; k < Length; k++)
+    {
+        SumI += I[k] * h[k];
+        SumQ += Q[k] * h[k];
+    }
+    *OutI = SumI;
+    *OutQ = SumQ;
+}
+
+FIR_TARGET("avx2,fma") static void FoldIQAVX2(const float *I1, const float *Q1, const float *I2, const float *Q2, const float *h, int Length, float *OutI, float *OutQ)
+{
+    __m256 AccI = _mm256_setzero_ps(), AccQ = _mm256_setzero_ps();
+    int k = 0;
+    for(; k + 8 <= Length; k += 8)
+    {
+        __m256 Coef = _mm256_loadu_ps(&h[k]);
+        AccI = _mm256_fmadd_ps(_mm256_add_ps(_mm256_loadu_ps(&I1[k]), _mm256_loadu_ps(&I2[k])), Coef, AccI);
+        AccQ = _mm256_fmadd_ps(_mm256_add_ps(_mm256_loadu_ps(&Q1[k]), _mm256_loadu_ps(&Q2[k])), Coef, AccQ);
+    }
+    float SumI = Sum256(AccI), SumQ = Sum256(AccQ);
+    for(; k < Length; k++)
+    {
+        SumI += (I1[k] + I2[k]) * h[k];
+        SumQ += (Q1[k] + Q2[k]) * h[k];
+    }
+    *OutI = SumI;
+    *OutQ = SumQ;
+}
+
+// four lane kernels, two taps of all four lanes per vector, four coefficients loaded at once and spread two taps to
+// a vector
+
+FIR_TARGET("avx2,fma") static inline __m128 Lanes256(__m256 v)
+{
+    return _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+}
+
+FIR_TARGET("avx2,fma") static void Dot4AVX2(const float *x, const float *h, int Length, float *Out)
+{
+    const __m256i Spread01 = _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1);
+    const __m256i Spread23 = _mm256_setr_epi32(2, 2, 2, 2, 3, 3, 3, 3);
+    __m256 Acc0 = _mm256_setzero_ps(), Acc1 = _mm256_setzero_ps();
+    int k = 0;
+    for(; k + 4 <= Length; k += 4)
+    {
+        __m256 Coef = _mm256_castps128_ps256(_mm_loadu_ps(&h[k]));
+        Acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(&x[4 * k]), _mm256_permutevar8x32_ps(Coef, Spread01), Acc0);
+        Acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(&x[4 * k + 8]), _mm256_permutevar8x32_ps(Coef, Spread23), Acc1);
+    }
+    __m128 Acc = Lanes256(_mm256_add_ps(Acc0, Acc1));
+    for(; k < Length; k++) Acc = _mm_fmadd_ps(_mm_loadu_ps(&x[4 * k]), _mm_set1_ps(h[k]), Acc);
+    _mm_storeu_ps(Out, Acc);
+}
+
+FIR_TARGET("avx2,fma") static void Fold4AVX2(const float *x1, const float *x2, const float *h, int Length, float *Out)
+{
+    const __m256i Spread01 = _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1);
+    const __m256i Spread23 = _mm256_setr_epi32(2, 2, 2, 2, 3, 3, 3, 3);
+    __m256 Acc0 = _mm256_setzero_ps(), Acc1 = _mm256_setzero_ps();
+    int k = 0;
+    for(; k + 4 <= Length; k += 4)
+    {
+        __m256 Coef = _mm256_castps128_ps256(_mm_loadu_ps(&h[k]));
+        Acc0 = _mm256_fmadd_ps(_mm256_add_ps(_mm256_loadu_ps(&x1[4 * k]), _mm256_loadu_ps(&x2[4 * k])), _mm256_permutevar8x32_ps(Coef, Spread01), Acc0);
+        Acc1 = _mm256_fmadd_ps(_mm256_add_ps(_mm256_loadu_ps(&x1[4 * k + 8]), _mm256_loadu_ps(&x2[4 * k + 8])), _mm256_permutevar8x32_ps(Coef, Spread23), Acc1);
+    }
+    __m128 Acc = Lanes256(_mm256_add_ps(Acc0, Acc1));
+    for(; k < Length; k++) Acc = _mm_fmadd_ps(_mm_add_ps(_mm_loadu_ps(&x1[4 * k]), _mm_loadu_ps(&x2[4 * k])), _mm_set1_ps(h[k]), Acc);
+    _mm_storeu_ps(Out, Acc);
+}
+
+FIR_TARGET("avx2,fma") static void Dot4LanesAVX2(const float *x, const float *h, int Length, float *Out)
+{
+    __m256 Acc0 = _mm256_setzero_ps(), Acc1 = _mm256_setzero_ps();
+    int k = 0;
+    for(; k + 4 <= Length; k += 4)
+    {
+        Acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(&x[4 * k]), _mm256_loadu_ps(&h[4 * k]), Acc0);
+        Acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(&x[4 * k + 8]), _mm256_loadu_ps(&h[4 * k + 8]), Acc1);
+    }
+    __m128 Acc = Lanes256(_mm256_add_ps(Acc0, Acc1));
+    for(; k < Length; k++) Acc = _mm_fmadd_ps(_mm_loadu_ps(&x[4 * k]), _mm_loadu_ps(&h[4 * k]), Acc);
+    _mm_storeu_ps(Out, Acc);
+}
+
+FIR_TARGET("avx2,fma") static void ButterflyDITAVX2(float *ar, float *ai, float *br, float *bi, const float *wr, const float *wi, int Length)
+{
+    int k = 0;
+    for(; k + 8 <= Length; k += 8)
+    {
+        __m256 Br = _mm256_loadu_ps(&br[k]), Bi = _mm256_loadu_ps(&bi[k]), Wr = _mm256_loadu_ps(&wr[k]), Wi = _mm256_loadu_ps(&wi[k]);
+        __m256 Ar = _mm256_loadu_ps(&ar[k]), Ai = _mm256_loadu_ps(&ai[k]);
+        __m256 tr = _mm256_fmsub_ps(Br, Wr, _mm256_mul_ps(Bi, Wi));
+        __m256 ti = _mm256_fmadd_ps(Br, Wi, _mm256_mul_ps(Bi, Wr));
+        _mm256_storeu_ps(&br[k], _mm256_sub_ps(Ar, tr)); _mm256_storeu_ps(&bi[k], _mm256_sub_ps(Ai, ti));
+        _mm256_storeu_ps(&ar[k], _mm256_add_ps(Ar, tr)); _mm256_storeu_ps(&ai[k], _mm256_add_ps(Ai, ti));
+    }
+    ButterflyDITSSE2(&ar[k], &ai[k], &br[k], &bi[k], &wr[k], &wi[k], Length - k);
+}
+
+FIR_TARGET("avx2,fma") static void ButterflyDIFAVX2(float *ar, float *ai, float *br, float *bi, const float *wr, const float *wi, int Length)
+{
+    int k = 0;
+    for(; k + 8 <= Length; k += 8)
+    {
+        __m256 Ar = _mm256_loadu_ps(&ar[k]), Ai = _mm256_loadu_ps(&ai[k]), Br = _mm256_loadu_ps(&br[k]), Bi = _mm256_loadu_ps(&bi[k]);
+        __m256 Wr = _mm256_loadu_ps(&wr[k]), Wi = _mm256_loadu_ps(&wi[k]);
+        __m256 tr = _mm256_sub_ps(Ar, Br), ti = _mm256_sub_ps(Ai, Bi);
+        _mm256_storeu_ps(&ar[k], _mm256_add_ps(Ar, Br)); _mm256_storeu_ps(&ai[k], _mm256_add_ps(Ai, Bi));
+        _mm256_storeu_ps(&br[k], _mm256_fmsub_ps(tr, Wr, _mm256_mul_ps(ti, Wi)));
+        _mm256_storeu_ps(&bi[k], _mm256_fmadd_ps(tr, Wi, _mm256_mul_ps(ti, Wr)));
+    }
+    ButterflyDIFSSE2(&ar[k], &ai[k], &br[k], &bi[k], &wr[k], &wi[k], Length - k);
+}
+
+FIR_TARGET("avx2,fma") static void SpectrumMACAVX2(const float *xr, const float *xi, const float *hr, const float *hi, float *yr, float *yi, int Length)
+{
+    int k = 0;
+    for(; k + 8 <= Length; k += 8)
+    {
+        __m256 Xr = _mm256_loadu_ps(&xr[k]), Xi = _mm256_loadu_ps(&xi[k]), Hr = _mm256_loadu_ps(&hr[k]), Hi = _mm256_loadu_ps(&hi[k]);
+        _mm256_storeu_ps(&yr[k], _mm256_fmadd_ps(Xr, Hr, _mm256_fnmadd_ps(Xi, Hi, _mm256_loadu_ps(&yr[k]))));
+        _mm256_storeu_ps(&yi[k], _mm256_fmadd_ps(Xr, Hi, _mm256_fmadd_ps(Xi, Hr, _mm256_loadu_ps(&yi[k]))));
+    }
+    SpectrumMACSSE2(&xr[k], &xi[k], &hr[k], &hi[k], &yr[k], &yi[k], Length - k);
+}
+
+// Q15 kernels, sixteen int16 pairs per vpmaddwd, tails through the SSE2 kernels after the vector accumulators are
+// summed and the upper halves cleared (legacy SSE with them in use runs many times slower)
+
+FIR_TARGET("avx2,fma") static inline long long Sum256Q15(__m256i v)
+{
+    alignas(32) int Lane[8];
+    _mm256_store_si256((__m256i *)Lane, v);
+    long long Sum = 0;
+    for(int index = 0; index < 8; index++) Sum += Lane[index];
+    return Sum;
+}
+
+FIR_TARGET("avx2,fma") static long long DotQ15AVX2(const short *x, const short *h, int Length)
+{
+    __m256i Acc0 = _mm256_setzero_si256(), Acc1 = _mm256_setzero_si256();
+    int k = 0;
+    for(; k + 32 <= Length; k += 32)
+    {
+        Acc0 = _mm256_add_epi32(Acc0, _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *)&x[k]), _mm256_loadu_si256((const __m256i *)&h[k])));
+        Acc1 = _mm256_add_epi32(Acc1, _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *)&x[k + 16]), _mm256_loadu_si256((const __m256i *)&h[k + 16])));
+    }
+    if(k + 16 <= Length)
+    {
+        Acc0 = _mm256_add_epi32(Acc0, _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *)&x[k]), _mm256_loadu_si256((const __m256i *)&h[k])));
+        k += 16;
+    }
+    long long Acc = Sum256Q15(Acc0) + Sum256Q15(Acc1);
+    _mm256_zeroupper();
+    return Acc + DotQ15SSE2(&x[k], &h[k], Length - k);
+}
+
+FIR_TARGET("avx2,fma") static void DotIQQ15AVX2(const short *I, const short *Q, const short *h, int Length, long long *OutI, long long *OutQ)
+{
+    __m256i AccI = _mm256_setzero_si256(), AccQ = _mm256_setzero_si256();
+    int k = 0;
+    for(; k + 16 <= Length; k += 16)
+    {
+        __m256i Coef = _mm256_loadu_si256((const __m256i *)&h[k]);
+        AccI = _mm256_add_epi32(AccI, _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *)&I[k]), Coef));
+        AccQ = _mm256_add_epi32(AccQ, _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *)&Q[k]), Coef));
+    }
+    long long SumI = Sum256Q15(AccI), SumQ = Sum256Q15(AccQ);
+    _mm256_zeroupper();
+    DotIQQ15SSE2(&I[k], &Q[k], &h[k], Length - k, OutI, OutQ);
+    *OutI += SumI;
+    *OutQ += SumQ;
+}
+
+FIR_TARGET("avx2,fma") static void FoldIQQ15AVX2(const short *I1, const short *Q1, const short *I2, const short *Q2, const short *h, int Length, long long *OutI, long long *OutQ)
+{
+    __m256i AccI = _mm256_setzero_si256(), AccQ = _mm256_setzero_si256();
+    int k = 0;
+    for(; k + 16 <= Length; k += 16)
+    {
+        __m256i Coef = _mm256_loadu_si256((const __m256i *)&h[k]);
+        AccI = _mm256_add_epi32(AccI, _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *)&I1[k]), Coef));
+        AccQ = _mm256_add_epi32(AccQ, _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *)&Q1[k]), Coef));
+        AccI = _mm256_add_epi32(AccI, _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *)&I2[k]), Coef));
+        AccQ = _mm256_add_epi32(AccQ, _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *)&Q2[k]), Coef));
+    }
+    long long SumI = Sum256Q15(AccI), SumQ = Sum256Q15(AccQ);
+    _mm256_zeroupper();
+    FoldIQQ15SSE2(&I1[k], &Q1[k], &I2[k], &Q2[k], &h[k], Length - k, OutI, OutQ);
+    *OutI += SumI;
+    *OutQ += SumQ;
+}
+
+// four lane kernels, four taps of all four lanes per vector, taps k, k+1 in the low half and k+2, k+3 in the high
+// half rearranged to neighbours as PairTaps does, against the coefficient pairs of each half
+
+FIR_TARGET("avx2,fma") static inline __m256i PairTaps256(__m256i v)
+{
+    return _mm256_unpacklo_epi16(v, _mm256_srli_si256(v, 8));
+}
+
+FIR_TARGET("avx2,fma") static inline __m256i PairCoef256(const short *h)
+{
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(PairCoef(&h[0])), PairCoef(&h[2]), 1);
+}
+
+FIR_TARGET("avx2,fma") static inline void Lanes256Q15(__m256i Acc, long long *Sum)
+{
+    alignas(32) int Lane[8];
+    _mm256_store_si256((__m256i *)Lane, Acc);
+    for(int index = 0; index < 4; index++) Sum[index] = (long long)Lane[index] + Lane[index + 4];
+}
+
+FIR_TARGET("avx2,fma") static void Dot4Q15AVX2(const short *x, const short *h, int Length, long long *Out)
+{
+    __m256i Acc = _mm256_setzero_si256();
+    int k = 0;
+    for(; k + 4 <= Length; k += 4) Acc = _mm256_add_epi32(Acc, _mm256_madd_epi16(PairTaps256(_mm256_loadu_si256((const __m256i *)&x[4 * k])), PairCoef256(&h[k])));
+    long long Sum[4];
+    Lanes256Q15(Acc, Sum);
+    _mm256_zeroupper();
+    Dot4Q15SSE2(&x[4 * k], &h[k], Length - k, Out);
+    for(int Lane = 0; Lane < 4; Lane++) Out[Lane] += Sum[Lane];
+}
+
+FIR_TARGET("avx2,fma") static void Fold4Q15AVX2(const short *x1, const short *x2, const short *h, int Length, long long *Out)
+{
+    __m256i Acc = _mm256_setzero_si256();
+    int k = 0;
+    for(; k + 4 <= Length; k += 4)
+    {
+        __m256i Coef = PairCoef256(&h[k]);
+        Acc = _mm256_add_epi32(Acc, _mm256_madd_epi16(PairTaps256(_mm256_loadu_si256((const __m256i *)&x1[4 * k])), Coef));
+        Acc = _mm256_add_epi32(Acc, _mm256_madd_epi16(PairTaps256(_mm256_loadu_si256((const __m256i *)&x2[4 * k])), Coef));
+    }
+    long long Sum[4];
+    Lanes256Q15(Acc, Sum);
+    _mm256_zeroupper();
+    Fold4Q15SSE2(&x1[4 * k], &x2[4 * k], &h[k], Length - k, Out);
+    for(int Lane = 0; Lane < 4; Lane++) Out[Lane] += Sum[Lane];
+}
+
+FIR_TARGET("avx2,fma") static void Dot4LanesQ15AVX2(const short *x, const short *h, int Length, long long *Out)
+{
+    __m256i Acc = _mm256_setzero_si256();
+    int k = 0;
+    for(; k + 4 <= Length; k += 4)
+        Acc = _mm256_add_epi32(Acc, _mm256_madd_epi16(PairTaps256(_mm256_loadu_si256((const __m256i *)&x[4 * k])), PairTaps256(_mm256_loadu_si256((const __m256i *)&h[4 * k]))));
+    long long Sum[4];
+    Lanes256Q15(Acc, Sum);
+    _mm256_zeroupper();
+    Dot4LanesQ15SSE2(&x[4 * k], &h[4 * k], Length - k, Out);
+    for(int Lane = 0; Lane < 4; Lane++) Out[Lane] += Sum[Lane];
+}
+
+static const FIRKernels AVX2 = { "avx2", DotAVX2, DotIQAVX2, FoldIQAVX2, Dot4AVX2, Fold4AVX2, Dot4LanesAVX2,
+                                 ButterflyDITAVX2, ButterflyDIFAVX2, SpectrumMACAVX2,
+                                 DotQ15AVX2, DotIQQ15AVX2, FoldIQQ15AVX2, Dot4Q15AVX2, Fold4Q15AVX2, Dot4LanesQ15AVX2 };
+
+
+// *****************************  AVX-512F  ****************************** //
+
+
+FIR_TARGET("avx512f") static float DotAVX512(const float *x, const float *h, int Length)
+{
+    __m512 Acc = _mm512_setzero_ps();
+    int k = 0;
+    for(; k + 16 <= Length; k += 16)
+        Acc = _mm512_fmadd_ps(_mm512_loadu_ps(&x[k]), _mm512_loadu_ps(&h[k]), Acc);
+    if(k < Length)
+    {
+        __mmask16 Tail = (__mmask16)((1u << (Length - k)) - 1);   // masked loads, nothing read past the end
+        Acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(Tail, &x[k]), _mm512_maskz_loadu_ps(Tail, &h[k]), Acc);
+    }
+    return _mm512_reduce_add_ps(Acc);
+}
+
+
+FIR_TARGET("avx512f") static void DotIQAVX512(const float *I, const float *Q, const float *h, int Length, float *OutI, float *OutQ)
+{
+    __m512 AccI = _mm512_setzero_ps(), AccQ = _mm512_setzero_ps();
+    int k = 0;
+    for(; k + 16 <= Length; k += 16)
+    {
+        __m512 Coef = _mm512_loadu_ps(&h[k]);
+        AccI = _mm512_fmadd_ps(_mm512_loadu_ps(&I[k]), Coef, AccI);
+        AccQ = _mm512_fmadd_ps(_mm512_loadu_ps(&Q[k]), Coef, AccQ);
+    }
+    if(k < Length)
+    {
+        __mmask16 Tail = (__mmask16)((1u << (Length - k)) - 1);
+        __m512 Coef = _mm512_maskz_loadu_ps(Tail, &h[k]);
+        AccI = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(Tail, &I[k]), Coef, AccI);
+        AccQ = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(Tail, &Q[k]), Coef, AccQ);
+    }
+    *OutI = _mm512_reduce_add_ps(AccI);
+    *OutQ = _mm512_reduce_add_ps(AccQ);
+}
+
+FIR_TARGET("avx512f") static void FoldIQAVX512(const float *I1, const float *Q1, const float *I2, const float *Q2, const float *h, int Length, float *OutI, float *OutQ)
+{
+    __m512 AccI = _mm512_setzero_ps(), AccQ = _mm512_setzero_ps();
+    int k = 0;
+    for(; k + 16 <= Length; k += 16)
+    {
+        __m512 Coef = _mm512_loadu_ps(&h[k]);
+        AccI = _mm512_fmadd_ps(_mm512_add_ps(_mm512_loadu_ps(&I1[k]), _mm512_loadu_ps(&I2[k])), Coef, AccI);
+        AccQ = _mm512_fmadd_ps(_mm512_add_ps(_mm512_loadu_ps(&Q1[k]), _mm512_loadu_ps(&Q2[k])), Coef, AccQ);
+    }
+    if(k < Length)
+    {
+        __mmask16 Tail = (__mmask16)((1u << (Length - k)) - 1);
+        __m512 Coef = _mm512_maskz_loadu_ps(Tail, &h[k]);
+        AccI = _mm512_fmadd_ps(_mm512_add_ps(_mm512_maskz_loadu_ps(Tail, &I1[k]), _mm512_maskz_loadu_ps(Tail, &I2[k])), Coef, AccI);
+        AccQ = _mm512_fmadd_ps(_mm512_add_ps(_mm512_maskz_loadu_ps(Tail, &Q1[k]), _mm512_maskz_loadu_ps(Tail, &Q2[k])), Coef, AccQ);
+    }
+    *OutI = _mm512_reduce_add_ps(AccI);
+    *OutQ = _mm512_reduce_add_ps(AccQ);
+}
+
+// four lane kernels, four taps of all four lanes per vector with the coefficients spread one tap to each quarter
+
+FIR_TARGET("avx512f") static inline __m128 Lanes512(__m512 v)
+{
+    __m256 Half = _mm256_add_ps(_mm512_castps512_ps256(v), _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1)));
+    return _mm_add_ps(_mm256_castps256_ps128(Half), _mm256_extractf128_ps(Half, 1));
+}
+
+FIR_TARGET("avx512f") static void Dot4AVX512(const float *x, const float *h, int Length, float *Out)
+{
+    const __m512i Spread = _mm512_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+    __m512 Acc = _mm512_setzero_ps(), Acc1 = _mm512_setzero_ps();
+    int k = 0;
+    for(; k + 8 <= Length; k += 8)
+    {
+        Acc = _mm512_fmadd_ps(_mm512_loadu_ps(&x[4 * k]), _mm512_permutexvar_ps(Spread, _mm512_castps128_ps512(_mm_loadu_ps(&h[k]))), Acc);
+        Acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(&x[4 * k + 16]), _mm512_permutexvar_ps(Spread, _mm512_castps128_ps512(_mm_loadu_ps(&h[k + 4]))), Acc1);
+    }
+    Acc = _mm512_add_ps(Acc, Acc1);
+    for(; k + 4 <= Length; k += 4)
+        Acc = _mm512_fmadd_ps(_mm512_loadu_ps(&x[4 * k]), _mm512_permutexvar_ps(Spread, _mm512_castps128_ps512(_mm_loadu_ps(&h[k]))), Acc);
+    if(k < Length)
+    {
+        int Taps = Length - k;   // masked loads, nothing read past the end
+        __m512 Coef = _mm512_permutexvar_ps(Spread, _mm512_maskz_loadu_ps((__mmask16)((1u << Taps) - 1), &h[k]));
+        Acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps((__mmask16)((1u << (4 * Taps)) - 1), &x[4 * k]), Coef, Acc);
+    }
+    _mm_storeu_ps(Out, Lanes512(Acc));
+}
+
+FIR_TARGET("avx512f") static void Fold4AVX512(const float *x1, const float *x2, const float *h, int Length, float *Out)
+{
+    const __m512i Spread = _mm512_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+    __m512 Acc = _mm512_setzero_ps();
+    int k = 0;
+    for(; k + 4 <= Length; k += 4)
+        Acc = _mm512_fmadd_ps(_mm512_add_ps(_mm512_loadu_ps(&x1[4 * k]), _mm512_loadu_ps(&x2[4 * k])),
+                              _mm512_permutexvar_ps(Spread, _mm512_castps128_ps512(_mm_loadu_ps(&h[k]))), Acc);
+    if(k < Length)
+    {
+        int Taps = Length - k;
+        __mmask16 Tail = (__mmask16)((1u << (4 * Taps)) - 1);
+        __m512 Coef = _mm512_permutexvar_ps(Spread, _mm512_maskz_loadu_ps((__mmask16)((1u << Taps) - 1), &h[k]));
+        Acc = _mm512_fmadd_ps(_mm512_add_ps(_mm512_maskz_loadu_ps(Tail, &x1[4 * k]), _mm512_maskz_loadu_ps(Tail, &x2[4 * k])), Coef, Acc);
+    }
+    _mm_storeu_ps(Out, Lanes512(Acc));
+}
+
+FIR_TARGET("avx512f") static void Dot4LanesAVX512(const float *x, const float *h, int Length, float *Out)
+{
+    __m512 Acc = _mm512_setzero_ps();
+    int k = 0;
+    for(; k + 4 <= Length; k += 4)
+        Acc = _mm512_fmadd_ps(_mm512_loadu_ps(&x[4 * k]), _mm512_loadu_ps(&h[4 * k]), Acc);
+    if(k < Length)
+    {
+        __mmask16 Tail = (__mmask16)((1u << (4 * (Length - k))) - 1);
+        Acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(Tail, &x[4 * k]), _mm512_maskz_loadu_ps(Tail, &h[4 * k]), Acc);
+    }
+    _mm_storeu_ps(Out, Lanes512(Acc));
+}
+
+FIR_TARGET("avx512f") static void ButterflyDITAVX512(float *ar, float *ai, float *br, float *bi, const float *wr, const float *wi, int Length)
+{
+    for(int k = 0; k < Length; k += 16)
+    {
+        __mmask16 Tail = (Length - k >= 16) ? (__mmask16)0xFFFF : (__mmask16)((1u << (Length - k)) - 1);
+        __m512 Br = _mm512_maskz_loadu_ps(Tail, &br[k]), Bi = _mm512_maskz_loadu_ps(Tail, &bi[k]);
+        __m512 Wr = _mm512_maskz_loadu_ps(Tail, &wr[k]), Wi = _mm512_maskz_loadu_ps(Tail, &wi[k]);
+        __m512 Ar = _mm512_maskz_loadu_ps(Tail, &ar[k]), Ai = _mm512_maskz_loadu_ps(Tail, &ai[k]);
+        __m512 tr = _mm512_fmsub_ps(Br, Wr, _mm512_mul_ps(Bi, Wi));
+        __m512 ti = _mm512_fmadd_ps(Br, Wi, _mm512_mul_ps(Bi, Wr));
+        _mm512_mask_storeu_ps(&br[k], Tail, _mm512_sub_ps(Ar, tr)); _mm512_mask_storeu_ps(&bi[k], Tail, _mm512_sub_ps(Ai, ti));
+        _mm512_mask_storeu_ps(&ar[k], Tail, _mm512_add_ps(Ar, tr)); _mm512_mask_storeu_ps(&ai[k], Tail, _mm512_add_ps(Ai, ti));
+    }
+}
+
+FIR_TARGET("avx512f") static void ButterflyDIFAVX512(float *ar, float *ai, float *br, float *bi, const float *wr, const float *wi, int Length)
+{
+    for(int k = 0; k < Length; k += 16)
+    {
+        __mmask16 Tail = (Length - k >= 16) ? (__mmask16)0xFFFF : (__mmask16)((1u << (Length - k)) - 1);
+        __m512 Ar = _mm512_maskz_loadu_ps(Tail, &ar[k]), Ai = _mm512_maskz_loadu_ps(Tail, &ai[k]);
+        __m512 Br = _mm512_maskz_loadu_ps(Tail, &br[k]), Bi = _mm512_maskz_loadu_ps(Tail, &bi[k]);
+        __m512 Wr = _mm512_maskz_loadu_ps(Tail, &wr[k]), Wi = _mm512_maskz_loadu_ps(Tail, &wi[k]);
+        __m512 tr = _mm512_sub_ps(Ar, Br), ti = _mm512_sub_ps(Ai, Bi);
+        _mm512_mask_storeu_ps(&ar[k], Tail, _mm512_add_ps(Ar, Br)); _mm512_mask_storeu_ps(&ai[k], Tail, _mm512_add_ps(Ai, Bi));
+        _mm512_mask_storeu_ps(&br[k], Tail, _mm512_fmsub_ps(tr, Wr, _mm512_mul_ps(ti, Wi)));
+        _mm512_mask_storeu_ps(&bi[k], Tail, _mm512_fmadd_ps(tr, Wi, _mm512_mul_ps(ti, Wr)));
+    }
+}
+
+FIR_TARGET("avx512f") static void SpectrumMACAVX512(const float *xr, const float *xi, const float *hr, const float *hi, float *yr, float *yi, int Length)
+{
+    for(int k = 0; k < Length; k += 16)
+    {
+        __mmask16 Tail = (Length - k >= 16) ? (__mmask16)0xFFFF : (__mmask16)((1u << (Length - k)) - 1);
+        __m512 Xr = _mm512_maskz_loadu_ps(Tail, &xr[k]), Xi = _mm512_maskz_loadu_ps(Tail, &xi[k]);
+        __m512 Hr = _mm512_maskz_loadu_ps(Tail, &hr[k]), Hi = _mm512_maskz_loadu_ps(Tail, &hi[k]);
+        _mm512_mask_storeu_ps(&yr[k], Tail, _mm512_fmadd_ps(Xr, Hr, _mm512_fnmadd_ps(Xi, Hi, _mm512_maskz_loadu_ps(Tail, &yr[k]))));
+        _mm512_mask_storeu_ps(&yi[k], Tail, _mm512_fmadd_ps(Xr, Hi, _mm512_fmadd_ps(Xi, Hr, _mm512_maskz_loadu_ps(Tail, &yi[k]))));
+    }
+}
+
+// the Q15 kernels are the AVX2 ones, int16 in 512 bit vectors needs AVX-512BW which is not checked for
+static const FIRKernels AVX512 = { "avx512", DotAVX512, DotIQAVX512, FoldIQAVX512, Dot4AVX512, Fold4AVX512, Dot4LanesAVX512,
+                                   ButterflyDITAVX512, ButterflyDIFAVX512, SpectrumMACAVX512,
+                                   DotQ15AVX2, DotIQQ15AVX2, FoldIQQ15AVX2, Dot4Q15AVX2, Fold4Q15AVX2, Dot4LanesQ15AVX2 };
+
+#endif // FIR_X86
+
+
+#if defined(FIR_NEON)
+
+// *****************************  NEON (ARMv7 with NEON, AArch64)  ****************************** //
+
+
+static inline float32x4_t MultiplyAdd(float32x4_t Acc, float32x4_t a, float32x4_t b)
+{
+#if defined(__ARM_FEATURE_FMA)
+    return vfmaq_f32(Acc, a, b);
+#else
+    return vmlaq_f32(Acc, a, b);
+#endif
+}
+
+
+static inline float SumNEON(float32x4_t v)
+{
+#if defined(__aarch64__)
+    return vaddvq_f32(v);
+#else
+    float32x2_t Pairs = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(Pairs, Pairs), 0);
+#endif
+}
+
+
+static float DotNEON(const float *x, const float *h, int Length)
+{
+    float32x4_t Acc0 = vdupq_n_f32(0), Acc1 = vdupq_n_f32(0);
+    int k = 0;
+    for(; k + 8 <= Length; k += 8)
+    {
+        Acc0 = MultiplyAdd(Acc0, vld1q_f32(&x[k]), vld1q_f32(&h[k]));
+        Acc1 = MultiplyAdd(Acc1, vld1q_f32(&x[k + 4]), vld1q_f32(&h[k + 4]));
+    }
+    if(k + 4 <= Length)
+    {
+        Acc0 = MultiplyAdd(Acc0, vld1q_f32(&x[k]), vld1q_f32(&h[k]));
+        k += 4;
+    }
+    float Acc = SumNEON(vaddq_f32(Acc0, Acc1));
+    for(; k < Length; k++) Acc += x[k] * h[k];
+    return Acc;
+}
+
+
+static void DotIQNEON(const float *I, const float *Q, const float *h, int Length, float *OutI, float *OutQ)
+{
+    float32x4_t AccI = vdupq_n_f32(0), AccQ = vdupq_n_f32(0);
+    int k = 0;
+    for(; k + 4 <= Length; k += 4)
+    {
+        float32x4_t Coef = vld1q_f32(&h[k]);
+        AccI = MultiplyAdd(AccI, vld1q_f32(&I[k]), Coef);
+        AccQ = MultiplyAdd(AccQ, vld1q_f32(&Q[k]), Coef);
+    }
+    float SumI = SumNEON(AccI), SumQ = SumNEON(AccQ);
+    for(; k < Length; k++)
+    {
+        SumI += I[k] * h[k];
+        SumQ += Q[k] * h[k];
+    }
+    *OutI = SumI;
+    *OutQ = SumQ;
+}
+
+static void FoldIQNEON(const float *I1, const float *Q1, const float *I2, const float *Q2, const float *h, int Length, float *OutI, float *OutQ)
+{
+    float32x4_t AccI = vdupq_n_f32(0), AccQ = vdupq_n_f32(0);
+    int k = 0;
+    for(; k + 4 <= Length; k += 4)
+    {
+        float32x4_t Coef = vld1q_f32(&h[k]);
+        AccI = MultiplyAdd(AccI, vaddq_f32(vld1q_f32(&I1[k]), vld1q_f32(&I2[k])), Coef);
+        AccQ = MultiplyAdd(AccQ, vaddq_f32(vld1q_f32(&Q1[k]), vld1q_f32(&Q2[k])), Coef);
+    }
+    float SumI = SumNEON(AccI), SumQ = SumNEON(AccQ);
+    for(; k < Length; k++)
+    {
+        SumI += (I1[k] + I2[k]) * h[k];
+        SumQ += (Q1[k] + Q2[k]) * h[k];
+    }
+    *OutI = SumI;
+    *OutQ = SumQ;
+}
+
+// four lane kernels, one tap of all four lanes per vector with its coefficient broadcast
+
+static void Dot4NEON(const float *x, const float *h, int Length, float *Out)
+{
+    float32x4_t Acc0 = vdupq_n_f32(0), Acc1 = vdupq_n_f32(0);
+    int k = 0;
+    for(; k + 2 <= Length; k += 2)
+    {
+        Acc0 = MultiplyAdd(Acc0, vld1q_f32(&x[4 * k]), vdupq_n_f32(h[k]));
+        Acc1 = MultiplyAdd(Acc1, vld1q_f32(&x[4 * k + 4]), vdupq_n_f32(h[k + 1]));
+    }
+    if(k < Length) Acc0 = MultiplyAdd(Acc0, vld1q_f32(&x[4 * k]), vdupq_n_f32(h[k]));
+    vst1q_f32(Out, vaddq_f32(Acc0, Acc1));
+}
+
+static void Fold4NEON(const float *x1, const float *x2, const float *h, int Length, float *Out)
+{
+    float32x4_t Acc0 = vdupq_n_f32(0), Acc1 = vdupq_n_f32(0);
+    int k = 0;
+    for(; k + 2 <= Length; k += 2)
+    {
+        Acc0 = MultiplyAdd(Acc0, vaddq_f32(vld1q_f32(&x1[4 * k]), vld1q_f32(&x2[4 * k])), vdupq_n_f32(h[k]));
+        Acc1 = MultiplyAdd(Acc1, vaddq_f32(vld1q_f32(&x1[4 * k + 4]), vld1q_f32(&x2[4 * k + 4])), vdupq_n_f32(h[k + 1]));
+    }
+    if(k < Length) Acc0 = MultiplyAdd(Acc0, vaddq_f32(vld1q_f32(&x1[4 * k]), vld1q_f32(&x2[4 * k])), vdupq_n_f32(h[k]));
+    vst1q_f32(Out, vaddq_f32(Acc0, Acc1));
+}
+
+static void Dot4LanesNEON(const float *x, const float *h, int Length, float *Out)
+{
+    float32x4_t Acc0 = vdupq_n_f32(0), Acc1 = vdupq_n_f32(0);
+    int k = 0;
+    for(; k + 2 <= Length; k += 2)
+    {
+        Acc0 = MultiplyAdd(Acc0, vld1q_f32(&x[4 * k]), vld1q_f32(&h[4 * k]));
+        Acc1 = MultiplyAdd(Acc1, vld1q_f32(&x[4 * k + 4]), vld1q_f32(&h[4 * k + 4]));
+    }
+    if(k < Length) Acc0 = MultiplyAdd(Acc0, vld1q_f32(&x[4 * k]), vld1q_f32(&h[4 * k]));
+    vst1q_f32(Out, vaddq_f32(Acc0, Acc1));
+}
+
+static void ButterflyDITNEON(float *ar, float *ai, float *br, float *bi, const float *wr, const float *wi, int Length)
+{
+    int k = 0;
+    for(; k + 4 <= Length; k += 4)
+    {
+        float32x4_t Br = vld1q_f32(&br[k]), Bi = vld1q_f32(&bi[k]), Wr = vld1q_f32(&wr[k]), Wi = vld1q_f32(&wi[k]);
+        float32x4_t Ar = vld1q_f32(&ar[k]), Ai = vld1q_f32(&ai[k]);
+        float32x4_t tr = vsubq_f32(vmulq_f32(Br, Wr), vmulq_f32(Bi, Wi));
+        float32x4_t ti = MultiplyAdd(vmulq_f32(Br, Wi), Bi, Wr);
+        vst1q_f32(&br[k], vsubq_f32(Ar, tr)); vst1q_f32(&bi[k], vsubq_f32(Ai, ti));
+        vst1q_f32(&ar[k], vaddq_f32(Ar, tr)); vst1q_f32(&ai[k], vaddq_f32(Ai, ti));
+    }
+    ButterflyDITScalar(&ar[k], &ai[k], &br[k], &bi[k], &wr[k], &wi[k], Length - k);
+}
+
+static void ButterflyDIFNEON(float *ar, float *ai, float *br, float *bi, const float *wr, const float *wi, int Length)
+{
+    int k = 0;
+    for(; k + 4 <= Length; k += 4)
+    {
+        float32x4_t Ar = vld1q_f32(&ar[k]), Ai = vld1q_f32(&ai[k]), Br = vld1q_f32(&br[k]), Bi = vld1q_f32(&bi[k]);
+        float32x4_t Wr = vld1q_f32(&wr[k]), Wi = vld1q_f32(&wi[k]);
+        float32x4_t tr = vsubq_f32(Ar, Br), ti = vsubq_f32(Ai, Bi);
+        vst1q_f32(&ar[k], vaddq_f32(Ar, Br)); vst1q_f32(&ai[k], vaddq_f32(Ai, Bi));
+        vst1q_f32(&br[k], vsubq_f32(vmulq_f32(tr, Wr), vmulq_f32(ti, Wi)));
+        vst1q_f32(&bi[k], MultiplyAdd(vmulq_f32(tr, Wi), ti, Wr));
+    }
+    ButterflyDIFScalar(&ar[k], &ai[k], &br[k], &bi[k], &wr[k], &wi[k], Length - k);
+}
+
+static void SpectrumMACNEON(const float *xr, const float *xi, const float *hr, const float *hi, float *yr, float *yi, int Length)
+{
+    int k = 0;
+    for(; k + 4 <= Length; k += 4)
+    {
+        float32x4_t Xr = vld1q_f32(&xr[k]), Xi = vld1q_f32(&xi[k]), Hr = vld1q_f32(&hr[k]), Hi = vld1q_f32(&hi[k]);
+        vst1q_f32(&yr[k], vsubq_f32(MultiplyAdd(vld1q_f32(&yr[k]), Xr, Hr), vmulq_f32(Xi, Hi)));
+        vst1q_f32(&yi[k], MultiplyAdd(MultiplyAdd(vld1q_f32(&yi[k]), Xr, Hi), Xi, Hr));
+    }
+    SpectrumMACScalar(&xr[k], &xi[k], &hr[k], &hi[k], &yr[k], &yi[k], Length - k);
+}
+
+// Q15 kernels, vmlal multiplies four int16 pairs into four 32 bit lanes
+
+static inline long long SumQ15NEON(int32x4_t v)
+{
+    int64x2_t Pairs = vpaddlq_s32(v);
+    return vgetq_lane_s64(Pairs, 0) + vgetq_lane_s64(Pairs, 1);
+}
+
+static long long DotQ15NEON(const short *x, const short *h, int Length)
+{
+    int32x4_t Acc0 = vdupq_n_s32(0), Acc1 = vdupq_n_s32(0);
+    int k = 0;
+    for(; k + 8 <= Length; k += 8)
+    {
+        int16x8_t Taps = vld1q_s16(&x[k]), Coef = vld1q_s16(&h[k]);
+        Acc0 = vmlal_s16(Acc0, vget_low_s16(Taps), vget_low_s16(Coef));
+        Acc1 = vmlal_s16(Acc1, vget_high_s16(Taps), vget_high_s16(Coef));
+    }
+    long long Acc = SumQ15NEON(Acc0) + SumQ15NEON(Acc1);
+    for(; k < Length; k++) Acc += x[k] * h[k];
+    return Acc;
+}
+
+static void DotIQQ15NEON(const short *I, const short *Q, const short *h, int Length, long long *OutI, long long *OutQ)
+{
+    int32x4_t AccI0 = vdupq_n_s32(0), AccI1 = vdupq_n_s32(0), AccQ0 = vdupq_n_s32(0), AccQ1 = vdupq_n_s32(0);
+    int k = 0;
+    for(; k + 8 <= Length; k += 8)
+    {
+        int16x8_t Coef = vld1q_s16(&h[k]), TapsI = vld1q_s16(&I[k]), TapsQ = vld1q_s16(&Q[k]);
+        AccI0 = vmlal_s16(AccI0, vget_low_s16(TapsI), vget_low_s16(Coef));
+        AccI1 = vmlal_s16(AccI1, vget_high_s16(TapsI), vget_high_s16(Coef));
+        AccQ0 = vmlal_s16(AccQ0, vget_low_s16(TapsQ), vget_low_s16(Coef));
+        AccQ1 = vmlal_s16(AccQ1, vget_high_s16(TapsQ), vget_high_s16(Coef));
+    }
+    long long SumI = SumQ15NEON(AccI0) + SumQ15NEON(AccI1), SumQ = SumQ15NEON(AccQ0) + SumQ15NEON(AccQ1);
+    for(; k < Length; k++)
+    {
+        SumI += I[k] * h[k];
+        SumQ += Q[k] * h[k];
+    }
+    *OutI = SumI;
+    *OutQ = SumQ;
+}
+
+// the two halves are not pre-added, the int16 sum could overflow, each has its own accumulators
+static void FoldIQQ15NEON(const short *I1, const short *Q1, const short *I2, const short *Q2, const short *h, int Length, long long *OutI, long long *OutQ)
+{
+    int32x4_t AccI0 = vdupq_n_s32(0), AccI1 = vdupq_n_s32(0), AccQ0 = vdupq_n_s32(0), AccQ1 = vdupq_n_s32(0);
+    int k = 0;
+    for(; k + 4 <= Length; k += 4)
+    {
+        int16x4_t Coef = vld1_s16(&h[k]);
+        AccI0 = vmlal_s16(AccI0, vld1_s16(&I1[k]), Coef);
+        AccI1 = vmlal_s16(AccI1, vld1_s16(&I2[k]), Coef);
+        AccQ0 = vmlal_s16(AccQ0, vld1_s16(&Q1[k]), Coef);
+        AccQ1 = vmlal_s16(AccQ1, vld1_s16(&Q2[k]), Coef);
+    }
+    long long SumI = SumQ15NEON(AccI0) + SumQ15NEON(AccI1), SumQ = SumQ15NEON(AccQ0) + SumQ15NEON(AccQ1);
+    for(; k < Length; k++)
+    {
+        SumI += (I1[k] + I2[k]) * h[k];
+        SumQ += (Q1[k] + Q2[k]) * h[k];
+    }
+    *OutI = SumI;
+    *OutQ = SumQ;
+}
+
+// four lane kernels, one tap of all four lanes per vmlal with its coefficient broadcast, alternate taps in two
+// accumulators
+
+static inline void LanesQ15NEON(int32x4_t Acc0, int32x4_t Acc1, long long *Out)
+{
+    int64x2_t Low = vaddl_s32(vget_low_s32(Acc0), vget_low_s32(Acc1));
+    int64x2_t High = vaddl_s32(vget_high_s32(Acc0), vget_high_s32(Acc1));
+    Out[0] = vgetq_lane_s64(Low, 0); Out[1] = vgetq_lane_s64(Low, 1);
+    Out[2] = vgetq_lane_s64(High, 0); Out[3] = vgetq_lane_s64(High, 1);
+}
+
+static void Dot4Q15NEON(const short *x, const short *h, int Length, long long *Out)
+{
+    int32x4_t Acc0 = vdupq_n_s32(0), Acc1 = vdupq_n_s32(0);
+    int k = 0;
+    for(; k + 2 <= Length; k += 2)
+    {
+        Acc0 = vmlal_n_s16(Acc0, vld1_s16(&x[4 * k]), h[k]);
+        Acc1 = vmlal_n_s16(Acc1, vld1_s16(&x[4 * k + 4]), h[k + 1]);
+    }
+    if(k < Length) Acc0 = vmlal_n_s16(Acc0, vld1_s16(&x[4 * k]), h[k]);
+    LanesQ15NEON(Acc0, Acc1, Out);
+}
+
+static void Fold4Q15NEON(const short *x1, const short *x2, const short *h, int Length, long long *Out)
+{
+    int32x4_t Acc0 = vdupq_n_s32(0), Acc1 = vdupq_n_s32(0);
+    for(int k = 0; k < Length; k++)
+    {
+        Acc0 = vmlal_n_s16(Acc0, vld1_s16(&x1[4 * k]), h[k]);
+        Acc1 = vmlal_n_s16(Acc1, vld1_s16(&x2[4 * k]), h[k]);
+    }
+    LanesQ15NEON(Acc0, Acc1, Out);
+}
+
+static void Dot4LanesQ15NEON(const short *x, const short *h, int Length, long long *Out)
+{
+    int32x4_t Acc0 = vdupq_n_s32(0), Acc1 = vdupq_n_s32(0);
+    int k = 0;
+    for(; k + 2 <= Length; k += 2)
+    {
+        Acc0 = vmlal_s16(Acc0, vld1_s16(&x[4 * k]), vld1_s16(&h[4 * k]));
+        Acc1 = vmlal_s16(Acc1, vld1_s16(&x[4 * k + 4]), vld1_s16(&h[4 * k + 4]));
+    }
+    if(k < Length) Acc0 = vmlal_s16(Acc0, vld1_s16(&x[4 * k]), vld1_s16(&h[4 * k]));
+    LanesQ15NEON(Acc0, Acc1, Out);
+}
+
+static const FIRKernels NEON = { "neon", DotNEON, DotIQNEON, FoldIQNEON, Dot4NEON, Fold4NEON, Dot4LanesNEON,
+                                 ButterflyDITNEON, ButterflyDIFNEON, SpectrumMACNEON,
+                                 DotQ15NEON, DotIQQ15NEON, FoldIQQ15NEON, Dot4Q15NEON, Fold4Q15NEON, Dot4LanesQ15NEON };
+
+#endif // FIR_NEON
+
+
+// *****************************  Selection  ****************************** //
+
+
+const FIRKernels *FIR = &Scalar;
+
+
+const FIRKernels *ScalarFIRKernels(void)
+{
+    return &Scalar;
+}
+
+
+const FIRKernels *SelectFIRKernels(const char *Name)
+{
+    // supported kernel tables, best first
+    const FIRKernels *Supported[4];
+    int Count = 0;
+
+#if defined(FIR_X86)
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f")) Supported[Count++] = &AVX512;
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) Supported[Count++] = &AVX2;
+#endif
+    Supported[Count++] = &SSE2;
+#elif defined(FIR_NEON)
+    Supported[Count++] = &NEON;
+#endif
+    Supported[Count++] = &Scalar;
+
+    FIR = Supported[0];
+    if(Name != nullptr)
+    {
+        for(int index = 0; index < Count; index++)
+            if(strcmp(Name, Supported[index]->Name) == 0) FIR = Supported[index];
+    }
+    return FIR;
+}
+
+
+float ValidateFIRKernels(const FIRKernels *Kernels)
+{
+    // compare against the scalar reference on pseudo random data for every length up to the longest sub filter
+    const int MaxLength = 64;
+    float x[MaxLength], y[MaxLength], h[MaxLength], x4[4 * MaxLength], y4[4 * MaxLength], h4[4 * MaxLength];
+    unsigned int Seed = 12345;
+    for(int k = 0; k < MaxLength; k++)
+    {
+        Seed = Seed * 1103515245 + 12345; x[k] = (int)(Seed >> 16) % 32768 - 16384;
+        Seed = Seed * 1103515245 + 12345; y[k] = (int)(Seed >> 16) % 32768 - 16384;
+        Seed = Seed * 1103515245 + 12345; h[k] = ((int)(Seed >> 16) % 32768 - 16384) / 16384.0f;
+    }
+    for(int k = 0; k < 4 * MaxLength; k++)   // four lanes: A and B I/Q from the same data, and per lane coefficients
+    {
+        x4[k] = ((k % 4) < 2) ? x[k / 4] : y[k / 4];
+        y4[k] = ((k % 2) == 0) ? y[k / 4] : x[k / 4];
+        h4[k] = h[(k / 4 + k % 4) % MaxLength];
+    }
+    // Q15 copies, coefficients scaled to 1/16 so the 32 bit lanes have the headroom of a real filter (see firkernels.h)
+    short xs[MaxLength], ys[MaxLength], hs[MaxLength], x4s[4 * MaxLength], y4s[4 * MaxLength], h4s[4 * MaxLength];
+    for(int k = 0; k < MaxLength; k++) { xs[k] = short(x[k]); ys[k] = short(y[k]); hs[k] = short(h[k] * 2048); }
+    for(int k = 0; k < 4 * MaxLength; k++) { x4s[k] = short(x4[k]); y4s[k] = short(y4[k]); h4s[k] = short(h4[k] * 2048); }
+
+    float MaxError = 0;
+    for(int Length = 0; Length <= MaxLength; Length++)
+    {
+        float Reference = Scalar.Dot(x, h, Length);
+        float RefI, RefQ, OutI, OutQ, FoldRefI, FoldRefQ, FoldI, FoldQ;
+        Scalar.DotIQ(x, y, h, Length, &RefI, &RefQ);
+        Kernels->DotIQ(x, y, h, Length, &OutI, &OutQ);
+        Scalar.FoldIQ(x, y, y, x, h, Length, &FoldRefI, &FoldRefQ);
+        Kernels->FoldIQ(x, y, y, x, h, Length, &FoldI, &FoldQ);
+        float Ref4[4], Out4[4], FoldRef4[4], Fold4[4], LanesRef4[4], Lanes4[4];
+        Scalar.Dot4(x4, h, Length, Ref4);
+        Kernels->Dot4(x4, h, Length, Out4);
+        Scalar.Fold4(x4, y4, h, Length, FoldRef4);
+        Kernels->Fold4(x4, y4, h, Length, Fold4);
+        Scalar.Dot4Lanes(x4, h4, Length, LanesRef4);
+        Kernels->Dot4Lanes(x4, h4, Length, Lanes4);
+
+        float Scale = 1;    // relative to the sum of magnitudes, the rounding error grows with it
+        for(int k = 0; k < Length; k++) Scale += std::fabs(x[k] * h[k]) + std::fabs(y[k] * h[k]);
+
+        float Error = std::fabs(Kernels->Dot(x, h, Length) - Reference);
+        Error = std::fmax(Error, std::fabs(OutI - RefI));
+        Error = std::fmax(Error, std::fabs(OutQ - RefQ));
+        Error = std::fmax(Error, std::fabs(FoldI - FoldRefI));
+        Error = std::fmax(Error, std::fabs(FoldQ - FoldRefQ));
+        for(int Lane = 0; Lane < 4; Lane++)
+        {
+            Error = std::fmax(Error, std::fabs(Out4[Lane] - Ref4[Lane]));
+            Error = std::fmax(Error, std::fabs(Fold4[Lane] - FoldRef4[Lane]));
+            Error = std::fmax(Error, std::fabs(Lanes4[Lane] - LanesRef4[Lane]));
+        }
+        MaxError = std::fmax(MaxError, Error / Scale);
+
+        // Q15 kernels, exact so any difference is a failure
+        long long Q15[2][17];
+        const FIRKernels *Pair[2] = { &Scalar, Kernels };
+        for(int Which = 0; Which < 2; Which++)
+        {
+            long long *Out = Q15[Which];
+            Out[0] = Pair[Which]->DotQ15(xs, hs, Length);
+            Pair[Which]->DotIQQ15(xs, ys, hs, Length, &Out[1], &Out[2]);
+            Pair[Which]->FoldIQQ15(xs, ys, ys, xs, hs, Length, &Out[3], &Out[4]);
+            Pair[Which]->Dot4Q15(x4s, hs, Length, &Out[5]);
+            Pair[Which]->Fold4Q15(x4s, y4s, hs, Length, &Out[9]);
+            Pair[Which]->Dot4LanesQ15(x4s, h4s, Length, &Out[13]);
+        }
+        if(memcmp(Q15[0], Q15[1], sizeof(Q15[0])) != 0) MaxError = 1;
+
+        // FFT kernels, on copies since they work in place
+        float ar[MaxLength], ai[MaxLength], br[MaxLength], bi[MaxLength], Ref[4][MaxLength];
+        memcpy(Ref[0], x, sizeof(x)); memcpy(Ref[1], y, sizeof(y)); memcpy(Ref[2], y, sizeof(y)); memcpy(Ref[3], x, sizeof(x));
+        memcpy(ar, x, sizeof(x)); memcpy(ai, y, sizeof(y)); memcpy(br, y, sizeof(y)); memcpy(bi, x, sizeof(x));
+        Scalar.ButterflyDIT(Ref[0], Ref[1], Ref[2], Ref[3], h, &h4[1], Length);
+        Kernels->ButterflyDIT(ar, ai, br, bi, h, &h4[1], Length);
+        Scalar.ButterflyDIF(Ref[0], Ref[1], Ref[2], Ref[3], &h4[1], h, Length);
+        Kernels->ButterflyDIF(ar, ai, br, bi, &h4[1], h, Length);
+        float Product[2][MaxLength], ProductRef[2][MaxLength];
+        memcpy(Product[0], y, sizeof(y)); memcpy(Product[1], x, sizeof(x));
+        memcpy(ProductRef[0], y, sizeof(y)); memcpy(ProductRef[1], x, sizeof(x));
+        Scalar.SpectrumMAC(x, y, h, &h4[1], ProductRef[0], ProductRef[1], Length);
+        Kernels->SpectrumMAC(x, y, h, &h4[1], Product[0], Product[1], Length);
+        Error = 0;
+        for(int k = 0; k < Length; k++)
+        {
+            Error = std::fmax(Error, std::fmax(std::fabs(ar[k] - Ref[0][k]), std::fabs(ai[k] - Ref[1][k])));
+            Error = std::fmax(Error, std::fmax(std::fabs(br[k] - Ref[2][k]), std::fabs(bi[k] - Ref[3][k])));
+            Error = std::fmax(Error, std::fmax(std::fabs(Product[0][k] - ProductRef[0][k]), std::fabs(Product[1][k] - ProductRef[1][k])));
+        }
+        MaxError = std::fmax(MaxError, Error / 65536);   // relative to the largest values, about 2 * 16384 * 2
+    }
+    return MaxError;
+}
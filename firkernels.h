@@ -0,0 +1,80 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef FIRKERNELS_H
+#define FIRKERNELS_H
+
+
+// float32 FIR multiply-accumulate kernels for the DSP filter stages, and int16 ones for the fixed point mixer.
+//
+// Each instruction set provides the same kernels and one table is selected at startup from what the CPU
+// supports (or by name, for testing). The scalar table is the reference the vector ones are validated against.
+// Arrays need no particular alignment and Length can be anything, the vector kernels finish any tail themselves.
+//
+// The Q15 kernels take int16 samples and Q15 coefficients and return the exact sum of the products (2^15 times the
+// result) as 64 bits; the caller rounds and saturates it back to int16. The vector kernels multiply taps or pairs of
+// taps into 32 bit lanes (pmaddwd, vmlal) spread over at least two accumulators, every lane summing at most every
+// other tap or pair of taps, except the fold kernels which may sum all of h, or every other pair twice over, in one
+// lane. A lane cannot overflow while the magnitudes of its coefficients add up to less than 2, which filters.h checks
+// at compile time for the fixed point mixer that uses them (Q15LaneSum): its most is 0.83, so full scale input is
+// safe.
+
+struct FIRKernels
+{
+    const char *Name;
+
+    // sum of x[k] * h[k] for k = 0 .. Length-1
+    float (*Dot)(const float *x, const float *h, int Length);
+
+    // I and Q histories through the same coefficients, results in *OutI and *OutQ
+    void (*DotIQ)(const float *I, const float *Q, const float *h, int Length, float *OutI, float *OutQ);
+
+    // as DotIQ on the pre-added histories I1 + I2 and Q1 + Q2, for the two mirrored halves of a symmetric filter
+    void (*FoldIQ)(const float *I1, const float *Q1, const float *I2, const float *Q2, const float *h, int Length, float *OutI, float *OutQ);
+
+    // four interleaved histories (tap k of lane l at x[4*k + l], e.g. I and Q of channels A and B) through the same
+    // coefficients, each coefficient broadcast across the lanes, results in Out[0..3]
+    void (*Dot4)(const float *x, const float *h, int Length, float *Out);
+
+    // as Dot4 on the pre-added histories x1 + x2
+    void (*Fold4)(const float *x1, const float *x2, const float *h, int Length, float *Out);
+
+    // as Dot4 with a separate coefficient for each lane, interleaved the same way (h[4*k + l])
+    void (*Dot4Lanes)(const float *x, const float *h, int Length, float *Out);
+
+    // FFT filters (see fftfilter.h), complex values with real and imaginary parts in separate arrays:
+
+    // Length radix 2 decimation in time butterflies, t = b * w, b = a - t, a = a + t
+    void (*ButterflyDIT)(float *ar, float *ai, float *br, float *bi, const float *wr, const float *wi, int Length);
+
+    // Length radix 2 decimation in frequency butterflies, t = a - b, a = a + b, b = t * w
+    void (*ButterflyDIF)(float *ar, float *ai, float *br, float *bi, const float *wr, const float *wi, int Length);
+
+    // Length bins of spectrum products, y += x * h
+    void (*SpectrumMAC)(const float *xr, const float *xi, const float *hr, const float *hi, float *yr, float *yi, int Length);
+
+    // the fixed point mixer, as the float kernels above on int16 samples and Q15 coefficients:
+
+    long long (*DotQ15)(const short *x, const short *h, int Length);
+    void (*DotIQQ15)(const short *I, const short *Q, const short *h, int Length, long long *OutI, long long *OutQ);
+    void (*FoldIQQ15)(const short *I1, const short *Q1, const short *I2, const short *Q2, const short *h, int Length, long long *OutI, long long *OutQ);
+    void (*Dot4Q15)(const short *x, const short *h, int Length, long long *Out);
+    void (*Fold4Q15)(const short *x1, const short *x2, const short *h, int Length, long long *Out);
+    void (*Dot4LanesQ15)(const short *x, const short *h, int Length, long long *Out);
+};
+
+extern const FIRKernels *FIR;                       // kernels in use, set by SelectFIRKernels
+
+const FIRKernels *SelectFIRKernels(const char *Name = nullptr);   // best supported, or by name if supported
+const FIRKernels *ScalarFIRKernels(void);           // plain C++ reference
+float ValidateFIRKernels(const FIRKernels *Kernels);   // largest error relative to the scalar reference (Q15 ones exact)
+
+#endif // FIRKERNELS_H
@@ -0,0 +1,105 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+
+#include "fixedpoint.h"
+#include "filters.h"
+#include "multirate.h"
+#include "samplesource.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+
+// the 96KHz receive chain (see ReceiveChain in dspthread.h) on one channel with samples of type T
+template<typename T>
+using ComparisonChain = Chain<Mixer<2, D2A_Order, T, 1>,
+                              Decimator<2, D2B_Order, T, 1>,
+                              Decimator<5, D5_Order, T, 1>,
+                              Interpolator<6, US6_Order, T, 1, 5>,
+                              Interpolator<4, US4_Order, T, 1, 5>>;
+
+template<typename T, typename Table2, typename Table5, typename Table6, typename Table4>
+static void Setup(ComparisonChain<T> &Receive, const double *Sin, const double *Cos, const Table2 &D2B, const Table5 &D5, const Table6 &US6, const Table4 &US4)
+{
+    Receive.template Stage<0>().Setup(D2ACoef, 40);
+    Receive.template Stage<0>().SetOscillator(0, Sin, Cos);
+    Receive.template Stage<1>().Setup(D2B);
+    Receive.template Stage<2>().Setup(D5);
+    Receive.template Stage<3>().Setup(US6);
+    Receive.template Stage<4>().Setup(US4);
+    Receive.Allocate(FILTER_BLOCK_SIZE);
+}
+
+template<typename T>
+static double Run(ComparisonChain<T> &Receive, const short *Input, int Total, typename ComparisonChain<T>::Buffer &Output)
+{
+    const short *In[1] = { Input };
+    auto Start = std::chrono::steady_clock::now();
+    Receive.Process(In, Total, Output);
+    return 1e9 * std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count() / Total;
+}
+
+
+FixedPointComparison CompareFixedPoint(double Level)
+{
+    const int Total = INPUT_SAMPLE_RATE, Settle = 1000;   // one second of input, the first outputs left out
+    short *Input = new short[Total];
+    std::mt19937 Random(12345);
+    std::normal_distribution<double> Noise(0, 0.5);
+    for(int n = 0; n < Total; n++)
+    {
+        double Value = std::round(Level * (std::sin(2 * M_PI * 462345.6 * n / INPUT_SAMPLE_RATE) + Noise(Random)));
+        Input[n] = short(std::min(32767.0, std::max(-32768.0, Value)));
+    }
+
+    double Sin[40], Cos[40];
+    for(int p = 0; p < 40; p++) { Sin[p] = std::sin(0.45 * M_PI * p); Cos[p] = -std::cos(0.45 * M_PI * p); }
+
+    ComparisonChain<double> Reference;
+    ComparisonChain<float> Float;
+    ComparisonChain<int> Fixed;
+    Setup(Reference, Sin, Cos, D2BPhaseDouble, D5PhaseDouble, US6PhaseDouble, US4PhaseDouble);
+    Setup(Float, Sin, Cos, D2BPhase, D5Phase, US6Phase, US4Phase);
+    Setup(Fixed, Sin, Cos, D2BPhaseQ15, D5PhaseQ15, US6PhaseQ15, US4PhaseQ15);
+    ComparisonChain<double>::Buffer ReferenceOut;
+    ComparisonChain<float>::Buffer FloatOut;
+    ComparisonChain<int>::Buffer FixedOut;
+    ReferenceOut.Allocate(Total / 10 + 1);
+    FloatOut.Allocate(Total / 10 + 1);
+    FixedOut.Allocate(Total / 10 + 1);
+
+    FixedPointComparison Result;
+    Run(Reference, Input, Total, ReferenceOut);
+    Result.FloatTime = Run(Float, Input, Total, FloatOut);
+    Result.FixedTime = Run(Fixed, Input, Total, FixedOut);
+
+    const double Scale = 1.0 / (1 << MAC<int>::Fraction);
+    double Signal = 0, FloatError = 0, FixedError = 0, OutputError = 0;
+    for(int n = Settle; n < ReferenceOut.Count; n++)
+    {
+        double I = ReferenceOut.I[0][n], Q = ReferenceOut.Q[0][n];
+        Signal += (I * I) + (Q * Q);
+        FloatError += std::pow(FloatOut.I[0][n] - I, 2) + std::pow(FloatOut.Q[0][n] - Q, 2);
+        FixedError += std::pow(FixedOut.I[0][n] * Scale - I, 2) + std::pow(FixedOut.Q[0][n] * Scale - Q, 2);
+        OutputError += std::pow(MAC<int>::ToInt16(FixedOut.I[0][n]) - I, 2) + std::pow(MAC<int>::ToInt16(FixedOut.Q[0][n]) - Q, 2);
+    }
+    Result.OutputLevel = std::sqrt(Signal / (ReferenceOut.Count - Settle));
+    Result.FloatSNR = 10 * std::log10(Signal / FloatError);
+    Result.FixedSNR = 10 * std::log10(Signal / FixedError);
+    Result.OutputSNR = 10 * std::log10(Signal / OutputError);
+
+    delete[] Input;
+    return Result;
+}
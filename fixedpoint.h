@@ -0,0 +1,45 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+
+#ifndef FIXEDPOINT_H
+#define FIXEDPOINT_H
+
+
+// Fixed point filter chain (FixedPointChain in dspthread.h) against the float one, both measured against the same
+// chain in double precision. The input is a tone in the 96KHz passband with white noise of half its amplitude,
+// Level the tone amplitude in input counts, through the 96KHz chain (D2A, D2B, D5, US6, US4) on one channel.
+//
+// Measured (x86-64, SNR over the whole output, signal as the double output; times with the AVX2 kernels):
+//     Level     output rms    float SNR    fixed SNR    int16 output SNR
+//     10        5.1           136dB        81dB         22dB
+//     100       51            136dB        81dB         42dB
+//     1000      514           136dB        81dB         62dB
+//     10000     5141          136dB        81dB         79dB
+//     30000     13483         136dB        81dB         81dB    (input clipped to int16, the reference's too)
+//     about 26nS per input sample float, 43nS fixed point
+// The fixed point error is that of the Q15 coefficients, at any level; below about 10000 counts the rounding of the
+// output to int16 is the larger one, as it would be for the float chain's output in the same buffers.
+
+struct FixedPointComparison
+{
+    double OutputLevel;         // rms of the double chain output
+    double FloatSNR;            // dB, double output over the float chain's difference from it
+    double FixedSNR;            // dB, double output over the fixed point chain's difference from it
+    double OutputSNR;           // dB, the same for the fixed point output rounded to int16, as in its output buffers
+    double FloatTime;           // nS per input sample
+    double FixedTime;
+};
+
+FixedPointComparison CompareFixedPoint(double Level);
+
+#endif // FIXEDPOINT_H
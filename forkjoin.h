@@ -0,0 +1,102 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+#ifndef FORKJOIN_H
+#define FORKJOIN_H
+
+#include "wakeup.h"
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+
+// A helper thread that runs one fixed job each time it is forked, alongside the thread that forked it.
+//
+// Fork() starts the job and returns at once, Join() waits until it has finished, so the job and whatever the
+// forking thread does in between run concurrently and meet again at the Join() barrier. Everything written
+// before Fork() is visible to the job, and everything the job wrote is visible after Join() (release/acquire
+// on the fork and finish counts). Both sides sleep on a WakeUp, nothing is locked or allocated per fork.
+
+class ForkJoin
+{
+public:
+    ~ForkJoin()
+    {
+        Stop();
+    }
+
+    bool Running(void) const { return Thread.joinable(); }
+
+    // start the helper thread, which then waits to be forked
+    void Start(std::function<void()> Work)
+    {
+        if(Running()) return;
+        Job = std::move(Work);
+        Quit.store(false);
+        Forked.store(0);
+        Finished.store(0);
+        Thread = std::thread([this] { Loop(); });
+    }
+
+    // stop the helper thread, only between a Join() and the next Fork()
+    void Stop(void)
+    {
+        if(!Running()) return;
+        Quit.store(true);
+        GoReady.Notify();
+        Thread.join();
+    }
+
+    // run the job once on the helper thread
+    void Fork(void)
+    {
+        Forked.store(Forked.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        GoReady.Notify();
+    }
+
+    // wait for the forked job to finish
+    void Join(void)
+    {
+        unsigned int Target = Forked.load(std::memory_order_relaxed);
+        unsigned int Seen = DoneReady.Count();
+        while(Finished.load(std::memory_order_acquire) != Target) Seen = DoneReady.Wait(Seen);
+    }
+
+private:
+    void Loop(void)
+    {
+        unsigned int Seen = GoReady.Count();
+        unsigned int Done = 0;
+        while(true)
+        {
+            while(Forked.load(std::memory_order_acquire) == Done)
+            {
+                if(Quit.load()) return;
+                Seen = GoReady.Wait(Seen);
+            }
+            Job();
+            Finished.store(++Done, std::memory_order_release);
+            DoneReady.Notify();
+        }
+    }
+
+    std::thread Thread;
+    std::function<void()> Job;                  // run once per Fork()
+    WakeUp GoReady;                             // rung by Fork() and Stop(), the helper sleeps on it
+    WakeUp DoneReady;                           // rung by the helper, Join() sleeps on it
+    std::atomic<bool> Quit {false};             // helper to exit
+    std::atomic<unsigned int> Forked {0};       // jobs forked (written by the forking thread)
+    std::atomic<unsigned int> Finished {0};     // jobs finished (written by the helper)
+};
+
+#endif // FORKJOIN_H
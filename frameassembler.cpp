@@ -0,0 +1,233 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+#include "frameassembler.h"
+
+#include <cstring>
+
+
+FrameAssembler::FrameAssembler(InputRing *RingA, InputRing *RingB)
+{
+    A = RingA;
+    B = RingB;
+    FrameSize = A->BlockLength();
+    FrameBufferB = new short[FrameSize];
+}
+
+
+FrameAssembler::~FrameAssembler()
+{
+    delete[] FrameBufferB;
+}
+
+
+void FrameAssembler::Reset(void)
+{
+    // follow any change in the input block size
+    if(FrameSize != A->BlockLength())
+    {
+        delete[] FrameBufferB;
+        FrameSize = A->BlockLength();
+        FrameBufferB = new short[FrameSize];
+    }
+
+    // drop anything already queued, the next frame is aligned from scratch
+    A->Skip();
+    B->Skip();
+    SeqA = A->ReadSequence();
+    SeqB = B->ReadSequence();
+    OffsetB = 0;
+    RebaseB = 0;
+}
+
+
+bool FrameAssembler::NextFrame(bool DualMode)
+{
+    unsigned int Queued = A->Available();
+    if(Queued == 0) return false;  // no complete channel A block yet
+
+    Backlog = Queued;
+    if(Backlog > MaxBacklog) MaxBacklog = Backlog;
+    Dual = DualMode;
+
+    // a ring is lapped once the block being written is the oldest one still queued
+    bool LappedA = Queued >= (unsigned int)A->BlockCount();
+    bool LappedB = Dual && ((B->WriteSequence() - SeqB) >= (unsigned int)B->BlockCount());
+    if(LappedA || LappedB)
+    {
+        Overruns++;
+        if(!Recover(LappedA, LappedB)) return false;
+    }
+
+    SeqA = A->ReadSequence();
+    FrameA = A->Block(SeqA);
+    FrameIndex = A->BlockIndex(SeqA);
+    StatsA = A->Stats(SeqA);
+    FrameB = nullptr;
+    StatsB.Clear();
+
+    if(!Dual) return true;
+
+    // wait for channel B to catch up, unless channel A is piling up in which case B has stalled
+    // and the frame goes ahead with B padded out
+    if(!ReadyB() && (A->Available() <= (unsigned int)(A->BlockCount() / 2))) return false;
+
+    AssembleB();
+    return true;
+}
+
+
+void FrameAssembler::ReleaseFrame(void)
+{
+    // the producer reached a block while it was being processed, so the frame was partly overwritten. Channel B
+    // is only at risk when its block was handed over directly, a copied frame was taken before processing began.
+    bool LappedA = (A->WriteSequence() - SeqA) >= (unsigned int)A->BlockCount();
+    bool LappedB = Dual && (FrameB != nullptr) && (FrameB != FrameBufferB) && ((B->WriteSequence() - FrameSeqB) >= (unsigned int)B->BlockCount());
+    if(LappedA || LappedB) Overruns++;
+    if(LappedA) LostA++;
+    if(LappedB) LostB++;
+
+    A->Release(SeqA);
+    if(Dual && (SeqB != B->ReadSequence())) B->Release(SeqB - 1);
+}
+
+
+bool FrameAssembler::Recover(bool LappedA, bool LappedB)
+{
+    unsigned int PublishedA = A->WriteSequence();
+    unsigned int PublishedB = B->WriteSequence();
+
+    if(Policy == ResyncBoth)
+    {
+        // drop everything queued on both channels and align from scratch on the next blocks
+        LostA += PublishedA - A->ReadSequence();
+        if(Dual) LostB += PublishedB - SeqB;
+        Reset();
+        return false;
+    }
+
+    // skip to newest: keep the newest complete A block, and the two newest B blocks so B can still be
+    // aligned to it by sample number (older B samples are dropped by AssembleB as usual)
+    if(LappedA)
+    {
+        LostA += PublishedA - 1 - A->ReadSequence();
+        A->Release(PublishedA - 2);
+    }
+    if(LappedB || (LappedA && Dual && ((PublishedB - SeqB) > 2)))
+    {
+        LostB += PublishedB - 2 - SeqB;
+        SeqB = PublishedB - 2;
+        OffsetB = 0;
+    }
+    return true;
+}
+
+
+bool FrameAssembler::ReadyB(void)
+{
+    unsigned int Published = B->WriteSequence();
+    if(Published == SeqB) return false;  // nothing at the B read position yet
+
+    long long BlockLen = B->BlockLength();
+    long long Newest = B->BlockIndex(Published - 1) + RebaseB;   // start of newest complete B block
+    long long Span = BlockLen * B->BlockCount();                // anything further out than the ring is a restart
+
+    if((Newest > FrameIndex + Span) || (Newest + BlockLen < FrameIndex - Span))
+    {
+        // sample numbering of the two channels is unrelated (one tuner restarted), re-base B onto A
+        DroppedB += (unsigned long long)((Published - 1 - SeqB) * BlockLen - OffsetB);
+        RebaseB = FrameIndex - B->BlockIndex(Published - 1);
+        SeqB = Published - 1;
+        OffsetB = 0;
+        Resyncs++;
+        return true;
+    }
+
+    return (Newest + BlockLen) >= (FrameIndex + FrameSize);
+}
+
+
+void FrameAssembler::AssembleB(void)
+{
+    int BlockLen = B->BlockLength();
+    long long Pos = FrameIndex;             // next absolute sample number needed for the frame
+    long long End = FrameIndex + FrameSize;
+
+    // measure where channel B stands relative to the frame before aligning it
+    Skew = 0;
+    if(B->WriteSequence() != SeqB) Skew = B->BlockIndex(SeqB) + RebaseB + OffsetB - FrameIndex;
+
+    // already aligned on a whole block: hand the B block over directly
+    if((Skew == 0) && (OffsetB == 0) && (BlockLen == FrameSize) && (B->WriteSequence() != SeqB))
+    {
+        FrameB = B->Block(SeqB);
+        StatsB = B->Stats(SeqB);
+        FrameSeqB = SeqB;
+        SeqB++;
+        return;
+    }
+
+    // otherwise build the aligned frame sample by sample number
+    FrameB = FrameBufferB;
+    int Fill = 0;
+    while(Pos < End)
+    {
+        if(B->WriteSequence() == SeqB)
+        {
+            // B has run out of data (stalled channel), pad the rest of the frame
+            memset(&FrameBufferB[Fill], 0, (End - Pos) * sizeof(short));
+            PaddedB += End - Pos;
+            break;
+        }
+
+        long long Cursor = B->BlockIndex(SeqB) + RebaseB + OffsetB;
+        int Remain = BlockLen - OffsetB;
+
+        if(Cursor < Pos)
+        {
+            // B samples older than the frame, drop them
+            long long Drop = Pos - Cursor;
+            if(Drop > Remain) Drop = Remain;
+            OffsetB += Drop;
+            DroppedB += Drop;
+        }
+        else if(Cursor > Pos)
+        {
+            // B samples missing before the read position, pad with zeros
+            long long Pad = Cursor - Pos;
+            if(Pad > End - Pos) Pad = End - Pos;
+            memset(&FrameBufferB[Fill], 0, Pad * sizeof(short));
+            Fill += Pad;
+            Pos += Pad;
+            PaddedB += Pad;
+        }
+        else
+        {
+            // aligned, copy as much of this B block as the frame needs
+            long long Copy = Remain;
+            if(Copy > End - Pos) Copy = End - Pos;
+            memcpy(&FrameBufferB[Fill], B->Block(SeqB) + OffsetB, Copy * sizeof(short));
+            Fill += Copy;
+            Pos += Copy;
+            OffsetB += Copy;
+        }
+
+        if(OffsetB >= BlockLen)
+        {
+            SeqB++;
+            OffsetB = 0;
+        }
+    }
+
+    // the block summaries do not line up with this frame, summarise it as built
+    StatsB.Add(FrameBufferB, FrameSize);
+}
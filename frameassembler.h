@@ -0,0 +1,79 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+#ifndef FRAMEASSEMBLER_H
+#define FRAMEASSEMBLER_H
+
+#include "inputring.h"
+
+
+// Builds sample aligned A/B frames from the two input rings for the DSP thread.
+//
+// Channel A blocks define the frame grid. For each A block the channel B samples carrying the same absolute sample
+// numbers are located in the B ring: B samples older than the frame are dropped, missing ones are replaced by zeros.
+// When B is already aligned the B block is handed over directly, otherwise it is copied into an internal frame buffer.
+//
+// The producers never wait for the DSP, so if processing falls a whole ring behind the oldest queued blocks are
+// overwritten. This is detected from the sequence numbers and recovered according to Policy: skip channel A to its
+// newest complete block (channel B is then realigned to it by sample number), or discard everything queued on both
+// channels and align again from the next blocks written.
+
+enum OverrunPolicy { SkipToNewest = 0, ResyncBoth = 1 };
+
+class FrameAssembler
+{
+public:
+    FrameAssembler(InputRing *RingA, InputRing *RingB);
+    ~FrameAssembler();
+
+    void Reset(void);                   // discard queued input and re-align on the next frame
+    bool NextFrame(bool Dual);          // true if a new frame is ready in FrameA (and FrameB if Dual)
+    void ReleaseFrame(void);            // hand the current frame back to the input rings
+
+    const short *FrameA = nullptr;      // current channel A frame
+    const short *FrameB = nullptr;      // current channel B frame, aligned sample for sample with FrameA
+    int FrameSize;                      // samples per frame
+    long long FrameIndex = 0;           // absolute sample number of the first sample in the current frame
+    BlockStats StatsA;                  // input statistics of the current channel A frame
+    BlockStats StatsB;                  // input statistics of the current channel B frame (as aligned)
+
+    long long Skew = 0;                 // measured B - A offset (samples) found when assembling the last frame
+    unsigned long long DroppedB = 0;    // channel B samples discarded to align with channel A
+    unsigned long long PaddedB = 0;     // zero samples inserted into channel B to align with channel A
+    unsigned long long Resyncs = 0;     // number of times the B sample numbering had to be re-based onto A
+
+    OverrunPolicy Policy = SkipToNewest;  // recovery when the producer laps the DSP
+    unsigned int Backlog = 0;           // channel A blocks queued (including the current one) at the last NextFrame
+    unsigned int MaxBacklog = 0;        // largest Backlog seen
+    unsigned long long Overruns = 0;    // number of times a producer lapped the DSP
+    unsigned long long LostA = 0;       // channel A blocks overwritten (even partly, while processed) or discarded
+    unsigned long long LostB = 0;       // channel B blocks overwritten or discarded before they were used
+
+private:
+
+    bool Recover(bool LappedA, bool LappedB);  // apply Policy after an overrun, true if a frame can still be read
+    bool ReadyB(void);                  // true if the B ring holds the samples needed for the current frame
+    void AssembleB(void);               // align channel B to the current frame
+
+    InputRing *A;                       // channel A input ring
+    InputRing *B;                       // channel B input ring
+    short *FrameBufferB;                // frame buffer used when B has to be copied to align it
+
+    unsigned int SeqA = 0;              // channel A block of the current frame
+    unsigned int SeqB = 0;              // channel B read position (block)
+    unsigned int FrameSeqB = 0;         // channel B block handed over as FrameB (zero copy), if FrameB is not FrameBufferB
+    int OffsetB = 0;                    // channel B read position (sample within block)
+    long long RebaseB = 0;              // correction added to B sample numbers after a resync
+    bool Dual = false;                  // current frame includes channel B
+};
+
+#endif // FRAMEASSEMBLER_H
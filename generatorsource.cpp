@@ -0,0 +1,93 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+#include "generatorsource.h"
+
+
+#define GENERATOR_CHUNK 2000                // sample pairs per write, 1mS at 2MHz
+
+
+GeneratorSource::GeneratorSource(const GeneratorSettings &Settings, bool Paced, QObject *parent) : SampleSource(parent)
+{
+    this->Settings = Settings;
+    this->Paced = Paced;
+}
+
+
+GeneratorSource::~GeneratorSource()
+{
+    Stop();
+}
+
+
+void GeneratorSource::Start(int LOfrequency, int gRdB_Gain_A, int gRdB_Gain_B, int LNAstate)
+{
+    (void)LOfrequency; (void)gRdB_Gain_A; (void)gRdB_Gain_B; (void)LNAstate;   // no tuner to set
+
+    if(Running) return;
+
+    Generator = new SignalGenerator(Settings);
+
+    emit Status(QString::asprintf("Generator: Doppler=%.0fHz %+.3fHz/S Faraday=%.0fdeg %+.2fdeg/S PhaseB=%.0fdeg, %s",
+                                  Settings.DopplerShift, Settings.DopplerRate, Settings.FaradayAngle, Settings.FaradayRate,
+                                  Settings.PhaseB, Paced ? "real time" : "fast"));
+
+    Generated = 0;
+    Started = std::chrono::steady_clock::now();
+    Running = true;
+    Feeder = std::thread(&GeneratorSource::Feed, this);
+}
+
+
+void GeneratorSource::Stop(void)
+{
+    if(!Running) return;
+
+    Running = false;
+    Feeder.join();
+
+    double Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - Started).count();
+    double Seconds = (double)Generated / INPUT_SAMPLE_RATE;
+    emit Status(QString::asprintf("Generator stopped: %.1f Seconds generated at %.2f x real time, %llu samples clipped",
+                                  Seconds, (Elapsed > 0) ? Seconds / Elapsed : 0.0, Generator->Clipped()));
+
+    delete Generator;
+    Generator = nullptr;
+}
+
+
+void GeneratorSource::Feed(void)
+{
+    short ChunkA[GENERATOR_CHUNK];
+    short ChunkB[GENERATOR_CHUNK];
+
+    while(Running)
+    {
+        if(Paced)
+        {
+            // wait until this chunk would have arrived from the hardware
+            std::this_thread::sleep_until(Started + std::chrono::microseconds(Generated * 1000000 / INPUT_SAMPLE_RATE));
+        }
+        else
+        {
+            // never write into a block the DSP thread has not finished with yet
+            while(Running && (A_InputRing.Backlog() >= (unsigned int)A_InputRing.BlockCount() - 1))
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            if(!Running) break;
+        }
+
+        Generator->Generate(ChunkA, ChunkB, GENERATOR_CHUNK);
+        WriteInput(ChunkA, ChunkB, GENERATOR_CHUNK, SampleNum);
+        SampleNum += GENERATOR_CHUNK;
+        Generated += GENERATOR_CHUNK;
+    }
+}
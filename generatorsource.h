@@ -0,0 +1,51 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef GENERATORSOURCE_H
+#define GENERATORSOURCE_H
+
+#include "samplesource.h"
+#include "signalgenerator.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+
+// Feeds the input rings from the synthetic EME signal generator, paced to real time or as fast as the DSP thread
+// hands blocks back. Each Start restarts the generator so every run sees identical input.
+
+class GeneratorSource : public SampleSource
+{
+    Q_OBJECT
+public:
+    explicit GeneratorSource(const GeneratorSettings &Settings, bool Paced, QObject *parent = nullptr);
+    ~GeneratorSource();
+
+    void Start(int LOfrequency, int gRdb_Gain_A, int gRdb_Gain_B, int LNAstate) override;
+    void Stop(void) override;
+
+private:
+
+    void Feed(void);                        // feeder thread body
+
+    GeneratorSettings Settings;             // generator configuration
+    SignalGenerator *Generator = nullptr;   // the generator for the current run
+    bool Paced;                             // true = real time, false = as fast as the DSP can take it
+
+    std::thread Feeder;                     // feeder thread
+    std::atomic<bool> Running {false};      // cleared to stop the feeder thread
+    std::atomic<long long> Generated {0};   // sample pairs written to the input rings since Start
+    unsigned int SampleNum = 0;             // sample number stamped on the next chunk
+    std::chrono::steady_clock::time_point Started;   // time generation started, for pacing and rate report
+};
+
+#endif // GENERATORSOURCE_H
@@ -0,0 +1,218 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+#ifndef INPUTRING_H
+#define INPUTRING_H
+
+#include "wakeup.h"
+#include "inputstats.h"
+
+#include <atomic>
+#include <cstring>
+
+
+// Single producer / single consumer ring of input sample blocks.
+//
+// The producer (SDR stream callback) copies whatever it is given with memcpy straight into contiguous ring storage,
+// crossing block boundaries freely, and publishes the count of completed blocks with release ordering. The consumer
+// (DSP thread) reads the write sequence with acquire ordering, so every sample of a published block is visible before
+// the block is used, and hands blocks back by advancing the read sequence. Sequence numbers are free running and are
+// compared by unsigned difference, so they may wrap.
+//
+// Every block is stamped with the absolute sample number of its first sample, taken from the callback's 32 bit
+// firstSampleNum and extended to 64 bits. Samples within a block are always contiguous: a forward gap in the sample
+// numbers of up to a quarter of the ring (or one block if larger) is filled with zeros, any other jump zero fills the
+// rest of the current block so the new numbering starts on a block boundary.
+//
+// The consumer can register a WakeUp, which the producer notifies every time it publishes a block.
+//
+// The producer also summarises every block (peak, RMS, DC, clipping, amplitude histogram) while the samples it has
+// just copied are still in cache, the summary is published with the block.
+
+class InputRing
+{
+public:
+    InputRing(int Size, int Count)
+    {
+        Allocate(Size, Count);
+    }
+
+    ~InputRing()
+    {
+        delete[] Buffer;
+        delete[] BlockStart;
+        delete[] Summary;
+    }
+
+    // change the block size and count, only while neither producer nor consumer is running (MainWindow's Stop
+    // returns once the DSP thread and the sample source have both stopped)
+    void Resize(int Size, int Count)
+    {
+        if((Size == BlockSize) && (Count == Blocks)) return;
+        delete[] Buffer;
+        delete[] BlockStart;
+        delete[] Summary;
+        Allocate(Size, Count);
+        WriteIndex = 0;
+        SamplesWritten = 0;
+        NextSample = 0;
+        Started = false;
+        WriteSeq.store(0, std::memory_order_relaxed);
+        ReadSeq.store(0, std::memory_order_relaxed);
+    }
+
+    // ---- Producer side ---- //
+
+    void Write(const short *Samples, int Count, unsigned int FirstSampleNum)
+    {
+        // extend the 32 bit sample number relative to where this write was expected to start
+        long long First = NextSample + (int)(FirstSampleNum - (unsigned int)NextSample);
+
+        if(!Started)
+        {
+            NextSample = First;
+            Started = true;
+        }
+        else if(First != NextSample)
+        {
+            long long Gap = First - NextSample;
+            if((Gap > 0) && (Gap <= MaxFill))
+            {
+                Append(nullptr, (int)Gap);                     // lost samples, keep the numbering contiguous
+                PaddedSamples.fetch_add(Gap, std::memory_order_relaxed);
+            }
+            else
+            {
+                int Fill = (BlockSize - (WriteIndex % BlockSize)) % BlockSize;
+                Append(nullptr, Fill);                         // restart numbering on the next block boundary
+                PaddedSamples.fetch_add(Fill, std::memory_order_relaxed);
+                NextSample = First;
+            }
+        }
+
+        Append(Samples, Count);
+    }
+
+    // wake-up notified whenever a block is published, set before the producer starts
+    void SetWakeUp(WakeUp *Consumer) { Wake = Consumer; }
+
+    // blocks written but not yet handed back by the consumer, as seen by the producer
+    unsigned int Backlog(void) const { return WriteSeq.load(std::memory_order_relaxed) - ReadSeq.load(std::memory_order_acquire); }
+
+    // ---- Consumer side ---- //
+
+    unsigned int WriteSequence(void) const { return WriteSeq.load(std::memory_order_acquire); }
+    unsigned int ReadSequence(void) const { return ReadSeq.load(std::memory_order_relaxed); }
+    unsigned int Available(void) const { return WriteSequence() - ReadSequence(); }
+
+    // pointer to the start of block 'Sequence' (only valid once published)
+    const short *Block(unsigned int Sequence) const { return &Buffer[(Sequence % Blocks) * BlockSize]; }
+
+    // hand block 'Sequence' (and all before it) back to the producer
+    void Release(unsigned int Sequence) { ReadSeq.store(Sequence + 1, std::memory_order_release); }
+
+    // absolute sample number of the first sample in block 'Sequence' (only valid once published)
+    long long BlockIndex(unsigned int Sequence) const { return BlockStart[Sequence % Blocks]; }
+
+    // input statistics of block 'Sequence' (only valid once published)
+    const BlockStats &Stats(unsigned int Sequence) const { return Summary[Sequence % Blocks]; }
+
+    // discard everything published so far, next block read will be the next one written
+    void Skip(void) { ReadSeq.store(WriteSequence(), std::memory_order_release); }
+
+    // samples inserted by the producer to cover gaps in the sample numbering
+    unsigned long long Padded(void) const { return PaddedSamples.load(std::memory_order_relaxed); }
+
+    int BlockLength(void) const { return BlockSize; }
+    int BlockCount(void) const { return Blocks; }
+
+private:
+
+    void Allocate(int Size, int Count)
+    {
+        BlockSize = Size;
+        Blocks = Count;
+        Capacity = BlockSize * Blocks;
+        MaxFill = (BlockSize > Capacity / 4) ? BlockSize : Capacity / 4;
+        Buffer = new short[Capacity];
+        memset(Buffer, 0, Capacity * sizeof(short));
+        BlockStart = new long long[Blocks];
+        memset(BlockStart, 0, Blocks * sizeof(long long));
+        Summary = new BlockStats[Blocks];
+    }
+
+    void Append(const short *Samples, int Count)    // copy Samples (or zeros if nullptr) and publish completed blocks
+    {
+        while(Count > 0)
+        {
+            // copy as much as possible in one go, only split where the storage wraps
+            int Chunk = Capacity - WriteIndex;
+            if(Chunk > Count) Chunk = Count;
+            if(Samples != nullptr)
+            {
+                memcpy(&Buffer[WriteIndex], Samples, Chunk * sizeof(short));
+                Samples += Chunk;
+            }
+            else memset(&Buffer[WriteIndex], 0, Chunk * sizeof(short));
+
+            // stamp every block started by this copy with its absolute sample number
+            for(int Start = ((WriteIndex + BlockSize - 1) / BlockSize) * BlockSize; Start < WriteIndex + Chunk; Start += BlockSize)
+                BlockStart[Start / BlockSize] = NextSample + (Start - WriteIndex);
+
+            // summarise the copy into each block it lands in
+            for(int Position = WriteIndex; Position < WriteIndex + Chunk; )
+            {
+                int Piece = BlockSize - (Position % BlockSize);
+                if(Piece > WriteIndex + Chunk - Position) Piece = WriteIndex + Chunk - Position;
+                BlockStats &BlockSummary = Summary[Position / BlockSize];
+                if((Position % BlockSize) == 0) BlockSummary.Clear();
+                BlockSummary.Add(&Buffer[Position], Piece);
+                Position += Piece;
+            }
+
+            NextSample += Chunk;
+            WriteIndex += Chunk;
+            if(WriteIndex >= Capacity) WriteIndex = 0;
+            Count -= Chunk;
+
+            // publish any blocks completed by this copy
+            SamplesWritten += Chunk;
+            unsigned int Completed = (unsigned int)(SamplesWritten / BlockSize);
+            if(Completed != WriteSeq.load(std::memory_order_relaxed))
+            {
+                WriteSeq.store(Completed, std::memory_order_release);
+                if(Wake != nullptr) Wake->Notify();
+            }
+        }
+    }
+
+    short *Buffer;                                  // ring storage, Blocks * BlockSize samples
+    long long *BlockStart;                          // absolute sample number of the first sample of each block
+    BlockStats *Summary;                            // input statistics of each block
+    int BlockSize;                                  // samples per block
+    int Blocks;                                     // number of blocks in the ring
+    int Capacity;                                   // total samples in the ring
+    int MaxFill;                                    // largest sample number gap filled with zeros
+    WakeUp *Wake = nullptr;                         // consumer to wake when a block is published
+
+    int WriteIndex = 0;                             // producer only: next sample position in Buffer
+    unsigned long long SamplesWritten = 0;          // producer only: total samples written
+    long long NextSample = 0;                       // producer only: absolute sample number expected next
+    bool Started = false;                           // producer only: set once the first write has been numbered
+
+    std::atomic<unsigned long long> PaddedSamples {0};    // zeros inserted to cover sample number gaps
+
+    alignas(64) std::atomic<unsigned int> WriteSeq {0};   // number of completed blocks (written by producer)
+    alignas(64) std::atomic<unsigned int> ReadSeq {0};    // number of consumed blocks (written by consumer)
+};
+
+#endif // INPUTRING_H
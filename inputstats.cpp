@@ -0,0 +1,241 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+#include "inputstats.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define STATS_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define STATS_NEON
+#endif
+
+
+// Lower bound of each histogram bin above the first, the bins are counted as "|x| >= bound" and differenced
+static const short BinBound[STATS_BINS - 1] = {256, 512, 1024, 2048, 4096, 8192, 16384};
+
+#define STATS_RUN 4000                  // samples per vector run, keeps the 8, 16 and 32 bit lane counters from overflowing
+
+
+#if defined(STATS_SSE2)
+
+static void AddRun(BlockStats &Stats, const short *Samples, int Length, unsigned int *Above)
+{
+    const __m128i Zero = _mm_setzero_si128();
+    const __m128i Ones = _mm_set1_epi16(1);
+    const __m128i ClipMinus1 = _mm_set1_epi16(STATS_CLIP_LEVEL - 1);
+
+    __m128i Peak = Zero, Sum = Zero, Squares = Zero, Clip = Zero;
+    __m128i Count[STATS_BINS - 1];      // 8 bit lane counters of |x| >= bound
+    for(int bin = 0; bin < STATS_BINS - 1; bin++) Count[bin] = Zero;
+
+    int index = 0;
+    for(; index + 16 <= Length; index += 16)
+    {
+        __m128i x0 = _mm_loadu_si128((const __m128i *)&Samples[index]);
+        __m128i x1 = _mm_loadu_si128((const __m128i *)&Samples[index + 8]);
+        __m128i Abs0 = _mm_max_epi16(x0, _mm_subs_epi16(Zero, x0));     // saturating, so -32768 gives 32767
+        __m128i Abs1 = _mm_max_epi16(x1, _mm_subs_epi16(Zero, x1));
+
+        Peak = _mm_max_epi16(Peak, _mm_max_epi16(Abs0, Abs1));
+        Sum = _mm_add_epi32(Sum, _mm_add_epi32(_mm_madd_epi16(x0, Ones), _mm_madd_epi16(x1, Ones)));
+
+        // pairs of squares fit an unsigned 32 bit lane (at most 2^31), widen to 64 bits before accumulating
+        __m128i Sq0 = _mm_madd_epi16(x0, x0);
+        __m128i Sq1 = _mm_madd_epi16(x1, x1);
+        Squares = _mm_add_epi64(Squares, _mm_add_epi64(_mm_unpacklo_epi32(Sq0, Zero), _mm_unpackhi_epi32(Sq0, Zero)));
+        Squares = _mm_add_epi64(Squares, _mm_add_epi64(_mm_unpacklo_epi32(Sq1, Zero), _mm_unpackhi_epi32(Sq1, Zero)));
+
+        // compare masks are -1 per lane, so subtracting them counts
+        Clip = _mm_sub_epi16(Clip, _mm_cmpgt_epi16(Abs0, ClipMinus1));
+        Clip = _mm_sub_epi16(Clip, _mm_cmpgt_epi16(Abs1, ClipMinus1));
+
+        // the histogram bounds are all multiples of 256, so compare |x| / 256 packed into bytes, 16 samples at a time
+        __m128i Coarse = _mm_packus_epi16(_mm_srli_epi16(Abs0, 8), _mm_srli_epi16(Abs1, 8));
+        // (written out so the counters stay in registers)
+        Count[0] = _mm_sub_epi8(Count[0], _mm_cmpgt_epi8(Coarse, _mm_set1_epi8(0)));    // |x| >= 256
+        Count[1] = _mm_sub_epi8(Count[1], _mm_cmpgt_epi8(Coarse, _mm_set1_epi8(1)));    // |x| >= 512
+        Count[2] = _mm_sub_epi8(Count[2], _mm_cmpgt_epi8(Coarse, _mm_set1_epi8(3)));    // |x| >= 1024
+        Count[3] = _mm_sub_epi8(Count[3], _mm_cmpgt_epi8(Coarse, _mm_set1_epi8(7)));    // |x| >= 2048
+        Count[4] = _mm_sub_epi8(Count[4], _mm_cmpgt_epi8(Coarse, _mm_set1_epi8(15)));   // |x| >= 4096
+        Count[5] = _mm_sub_epi8(Count[5], _mm_cmpgt_epi8(Coarse, _mm_set1_epi8(31)));   // |x| >= 8192
+        Count[6] = _mm_sub_epi8(Count[6], _mm_cmpgt_epi8(Coarse, _mm_set1_epi8(63)));   // |x| >= 16384
+    }
+
+    // reduce the lanes
+    short PeakLanes[8], ClipLanes[8];
+    int SumLanes[4];
+    unsigned long long SquareLanes[2], CountLanes[2];
+    _mm_storeu_si128((__m128i *)PeakLanes, Peak);
+    _mm_storeu_si128((__m128i *)ClipLanes, Clip);
+    _mm_storeu_si128((__m128i *)SumLanes, Sum);
+    _mm_storeu_si128((__m128i *)SquareLanes, Squares);
+    for(int lane = 0; lane < 8; lane++)
+    {
+        if(PeakLanes[lane] > Stats.Peak) Stats.Peak = PeakLanes[lane];
+        Stats.Clipped += ClipLanes[lane];
+    }
+    for(int lane = 0; lane < 4; lane++) Stats.Sum += SumLanes[lane];
+    Stats.SumSquares += SquareLanes[0] + SquareLanes[1];
+    for(int bin = 0; bin < STATS_BINS - 1; bin++)
+    {
+        _mm_storeu_si128((__m128i *)CountLanes, _mm_sad_epu8(Count[bin], Zero));  // horizontal byte sums
+        Above[bin] += (unsigned int)(CountLanes[0] + CountLanes[1]);
+    }
+
+    // remaining samples
+    for(; index < Length; index++)
+    {
+        int x = Samples[index];
+        int Abs = (x < 0) ? -x : x;
+        if(Abs > STATS_CLIP_LEVEL) Abs = STATS_CLIP_LEVEL;
+        if(Abs > Stats.Peak) Stats.Peak = Abs;
+        Stats.Sum += x;
+        Stats.SumSquares += (unsigned long long)(x * x);
+        if(Abs >= STATS_CLIP_LEVEL) Stats.Clipped++;
+        for(int bin = 0; bin < STATS_BINS - 1; bin++) if(Abs >= BinBound[bin]) Above[bin]++;
+    }
+}
+
+#elif defined(STATS_NEON)
+
+static void AddRun(BlockStats &Stats, const short *Samples, int Length, unsigned int *Above)
+{
+    int16x8_t Peak = vdupq_n_s16(0);
+    int32x4_t Sum = vdupq_n_s32(0);
+    uint64x2_t Squares = vdupq_n_u64(0);
+    uint16x8_t Clip = vdupq_n_u16(0);
+    uint16x8_t Count[STATS_BINS - 1];
+    for(int bin = 0; bin < STATS_BINS - 1; bin++) Count[bin] = vdupq_n_u16(0);
+
+    int index = 0;
+    for(; index + 8 <= Length; index += 8)
+    {
+        int16x8_t x = vld1q_s16(&Samples[index]);
+        int16x8_t Abs = vqabsq_s16(x);                                   // saturating, so -32768 gives 32767
+
+        Peak = vmaxq_s16(Peak, Abs);
+        Sum = vpadalq_s16(Sum, x);
+        uint32x4_t SqLow = vreinterpretq_u32_s32(vmull_s16(vget_low_s16(x), vget_low_s16(x)));
+        uint32x4_t SqHigh = vreinterpretq_u32_s32(vmull_s16(vget_high_s16(x), vget_high_s16(x)));
+        Squares = vpadalq_u32(Squares, SqLow);
+        Squares = vpadalq_u32(Squares, SqHigh);
+
+        // compare masks are all ones per lane, shift down to 1 to count
+        Clip = vaddq_u16(Clip, vshrq_n_u16(vcgeq_s16(Abs, vdupq_n_s16(STATS_CLIP_LEVEL)), 15));
+        for(int bin = 0; bin < STATS_BINS - 1; bin++)
+            Count[bin] = vaddq_u16(Count[bin], vshrq_n_u16(vcgeq_s16(Abs, vdupq_n_s16(BinBound[bin])), 15));
+    }
+
+    // reduce the lanes
+    if(vmaxvq_s16(Peak) > Stats.Peak) Stats.Peak = vmaxvq_s16(Peak);
+    Stats.Clipped += vaddlvq_u16(Clip);
+    Stats.Sum += vaddlvq_s32(Sum);
+    Stats.SumSquares += vgetq_lane_u64(Squares, 0) + vgetq_lane_u64(Squares, 1);
+    for(int bin = 0; bin < STATS_BINS - 1; bin++) Above[bin] += vaddlvq_u16(Count[bin]);
+
+    // remaining samples
+    for(; index < Length; index++)
+    {
+        int x = Samples[index];
+        int Abs = (x < 0) ? -x : x;
+        if(Abs > STATS_CLIP_LEVEL) Abs = STATS_CLIP_LEVEL;
+        if(Abs > Stats.Peak) Stats.Peak = Abs;
+        Stats.Sum += x;
+        Stats.SumSquares += (unsigned long long)(x * x);
+        if(Abs >= STATS_CLIP_LEVEL) Stats.Clipped++;
+        for(int bin = 0; bin < STATS_BINS - 1; bin++) if(Abs >= BinBound[bin]) Above[bin]++;
+    }
+}
+
+#else
+
+static void AddRun(BlockStats &Stats, const short *Samples, int Length, unsigned int *Above)
+{
+    for(int index = 0; index < Length; index++)
+    {
+        int x = Samples[index];
+        int Abs = (x < 0) ? -x : x;
+        if(Abs > STATS_CLIP_LEVEL) Abs = STATS_CLIP_LEVEL;
+        if(Abs > Stats.Peak) Stats.Peak = Abs;
+        Stats.Sum += x;
+        Stats.SumSquares += (unsigned long long)(x * x);
+        if(Abs >= STATS_CLIP_LEVEL) Stats.Clipped++;
+        for(int bin = 0; bin < STATS_BINS - 1; bin++) if(Abs >= BinBound[bin]) Above[bin]++;
+    }
+}
+
+#endif
+
+
+void BlockStats::Add(const short *Samples, int Length)
+{
+    if(Length <= 0) return;
+    Count += Length;
+
+    if(Samples == nullptr)
+    {
+        Histogram[0] += Length;     // zero fill only lands in the lowest bin
+        return;
+    }
+
+    unsigned int Above[STATS_BINS - 1] = {};
+    for(int Start = 0; Start < Length; Start += STATS_RUN)
+        AddRun(*this, &Samples[Start], (Length - Start < STATS_RUN) ? (Length - Start) : STATS_RUN, Above);
+
+    // turn the "at or above bound" counts into per bin counts
+    unsigned int Previous = Length;
+    for(int bin = 0; bin < STATS_BINS - 1; bin++)
+    {
+        Histogram[bin] += Previous - Above[bin];
+        Previous = Above[bin];
+    }
+    Histogram[STATS_BINS - 1] += Previous;
+}
+
+
+void BlockStats::Merge(const BlockStats &Other)
+{
+    Count += Other.Count;
+    if(Other.Peak > Peak) Peak = Other.Peak;
+    Clipped += Other.Clipped;
+    Sum += Other.Sum;
+    SumSquares += Other.SumSquares;
+    for(int bin = 0; bin < STATS_BINS; bin++) Histogram[bin] += Other.Histogram[bin];
+}
+
+
+double BlockStats::DC(void) const
+{
+    return (Count == 0) ? 0 : double(Sum) / Count;
+}
+
+
+double BlockStats::RMS(void) const
+{
+    return (Count == 0) ? 0 : std::sqrt(double(SumSquares) / Count);
+}
+
+
+double BlockStats::PeakdBFS(void) const
+{
+    return 20 * std::log10((Peak + 0.5) / 32768.0);
+}
+
+
+double BlockStats::RMSdBFS(void) const
+{
+    return 20 * std::log10((RMS() + 0.5) / (32768.0 / std::sqrt(2.0)));
+}
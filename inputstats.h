@@ -0,0 +1,41 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef INPUTSTATS_H
+#define INPUTSTATS_H
+
+#define STATS_BINS 8                    // amplitude histogram bins, one octave each from |x| < 256 up to |x| >= 16384
+#define STATS_CLIP_LEVEL 32767          // |x| at or above this counts as a clipped sample
+
+
+// Summary of a run of int16 input samples: peak, RMS, DC offset, clipped samples and a coarse amplitude histogram.
+// Summaries of consecutive runs can be merged, so a block is summarised piece by piece as the producer writes it.
+
+struct BlockStats
+{
+    int Count = 0;                              // samples summarised
+    int Peak = 0;                               // largest |x|
+    int Clipped = 0;                            // samples at or beyond STATS_CLIP_LEVEL
+    long long Sum = 0;                          // sum of x (for the DC offset)
+    unsigned long long SumSquares = 0;          // sum of x * x (for the RMS)
+    unsigned int Histogram[STATS_BINS] = {};    // samples with |x| in [0,256), [256,512), ... [16384,32768]
+
+    void Clear(void) { *this = BlockStats(); }
+    void Add(const short *Samples, int Length);     // summarise Samples (nullptr for zeros)
+    void Merge(const BlockStats &Other);
+
+    double DC(void) const;                      // mean
+    double RMS(void) const;                     // root mean square, including DC
+    double PeakdBFS(void) const;                // peak relative to full scale int16
+    double RMSdBFS(void) const;                 // RMS relative to a full scale sine
+};
+
+#endif // INPUTSTATS_H
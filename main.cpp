@@ -11,12 +11,138 @@
 
 
 #include "mainwindow.h"
+#include "rspduointerface.h"
+#include "filesource.h"
+#include "generatorsource.h"
+#include "firkernels.h"
+#include "fftfilter.h"
+#include "cicfilter.h"
+#include "fixedpoint.h"
+#include "filterdesign.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QStandardPaths>
+#include <QDebug>
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
-    MainWindow w;
+
+    // select the input source, the RSPduo unless a recording is to be replayed
+    QCommandLineParser Parser;
+    Parser.addHelpOption();
+    QCommandLineOption ReplayOption("replay", "Replay a recorded 2MHz interleaved A/B int16 IF file.", "file");
+    QCommandLineOption GenerateOption("generate", "Use the synthetic dual polarisation EME signal generator.");
+    QCommandLineOption FaradayOption("faraday-rate", "Generator Faraday rotation rate (degrees/S).", "rate");
+    QCommandLineOption DopplerOption("doppler-rate", "Generator Doppler drift (Hz/S).", "rate");
+    QCommandLineOption FastOption("fast", "Replay or generate as fast as the DSP can process instead of in real time.");
+    QCommandLineOption BlockSizeOption("block-size", "Input block size in samples, smaller for lower latency (200 to 80000).", "samples");
+    QCommandLineOption OverrunOption("overrun", "Input overrun recovery: skip (to newest block) or resync (both channels).", "policy");
+    QCommandLineOption PipelineOption("dsp-pipeline", "Run the DSP filter stages on a pipeline of threads, one core each: on or off.", "on|off");
+    QCommandLineOption KernelsOption("fir-kernels", "FIR kernels instead of the best supported: scalar, sse2, avx2, avx512 or neon.", "name");
+    QCommandLineOption FFTOption("fft-filters", "Filter stages by FFT convolution: auto (where the planner finds it faster), off or on.", "auto|off|on");
+    QCommandLineOption FrontEndOption("front-end", "First decimation from 2MHz: fir (D2A/D2B) or cic (CIC and compensation filter).", "fir|cic");
+    QCommandLineOption FixedPointOption("fixed-point", "Filter chain arithmetic: off (float) or on (int32 samples and Q15 coefficients, int16 output; not with the CIC front end or FFT filters on).", "on|off");
+    QCommandLineOption BenchmarkOption("benchmark-front-end", "Time the FIR and CIC front ends, report their alias rejection and exit.");
+    QCommandLineOption FixedBenchmarkOption("benchmark-fixed-point", "Compare the SNR and speed of the fixed point and float chains and exit.");
+    QCommandLineOption DesignOption("design-filter", "Design a filter, print it as a filters.h table and exit, spec: "
+                                    "remez|kaiser,decimate|interpolate,ratio,rate,passband,stopband,ripple dB,attenuation dB[,taps].", "spec");
+    QCommandLineOption StageFilterOption("stage-filter", "Run a receive stage (D2B, D5, US6 or US4) on a designed filter at its own length, "
+                                         "repeat for more stages, spec as --design-filter.", "name=spec");
+    Parser.addOption(ReplayOption);
+    Parser.addOption(GenerateOption);
+    Parser.addOption(FaradayOption);
+    Parser.addOption(DopplerOption);
+    Parser.addOption(FastOption);
+    Parser.addOption(BlockSizeOption);
+    Parser.addOption(OverrunOption);
+    Parser.addOption(PipelineOption);
+    Parser.addOption(KernelsOption);
+    Parser.addOption(FFTOption);
+    Parser.addOption(FrontEndOption);
+    Parser.addOption(FixedPointOption);
+    Parser.addOption(BenchmarkOption);
+    Parser.addOption(FixedBenchmarkOption);
+    Parser.addOption(DesignOption);
+    Parser.addOption(StageFilterOption);
+    Parser.process(a);
+
+    // pick the FIR kernels for this CPU, an unsupported name leaves the best supported ones selected
+    SelectFIRKernels(Parser.isSet(KernelsOption) ? Parser.value(KernelsOption).toLatin1().constData() : nullptr);
+    if(Parser.isSet(FFTOption)) FFTFilters = (Parser.value(FFTOption) == "on") ? FFTFiltersOn : (Parser.value(FFTOption) == "off") ? FFTFiltersOff : FFTFiltersAuto;
+
+    // designed filters are kept in the application's cache directory, each is only designed once
+    QString FilterCache = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/filters";
+    if(QDir().mkpath(FilterCache)) SetFilterCache(QDir::toNativeSeparators(FilterCache).toStdString());
+
+    if(Parser.isSet(DesignOption))
+    {
+        FilterSpec Spec;
+        if(!Spec.Parse(Parser.value(DesignOption).toStdString()))
+        {
+            qDebug().noquote() << "Filter Design: invalid spec " + Parser.value(DesignOption);
+            return 1;
+        }
+        bool Designed = false;
+        std::vector<double> Coef = CachedFilter(Spec, &Designed);
+        if(Coef.empty())
+        {
+            qDebug().noquote() << "Filter Design: spec not reachable (over twice the estimated length or 4096 taps), relax the ripple, attenuation or transition band";
+            return 1;
+        }
+        FilterResponse Response = MeasureFilter(Coef, Spec);
+        qDebug().noquote() << QString::asprintf("Filter Design: %d taps, passband ripple %.3fdB, stopband attenuation %.1fdB (%s)",
+                                                int(Coef.size()), Response.Ripple, Response.Attenuation, Designed ? "designed" : "from cache");
+        std::string Name = ((Spec.Stage == FilterSpec::Decimate) ? "D" : "US") + std::to_string(Spec.Ratio);
+        qDebug().noquote() << QString::fromStdString(FilterTable(Coef, Spec, Name));
+        return 0;
+    }
+
+    if(Parser.isSet(BenchmarkOption))
+    {
+        for(int Ratio : { 4, 2 })
+        {
+            FrontEndBenchmark Result = BenchmarkFrontEnds(Ratio);
+            qDebug().noquote() << QString::asprintf("Front End 2MHz to %dKHz (%s kernels): FIR %.2f nS/sample, alias rejection %.1fdB; "
+                                                    "CIC %.2f nS/sample, alias rejection %.1fdB; CIC %.2fx faster",
+                                                    2000 / Ratio, FIR->Name, Result.FIRTime, Result.FIRRejection,
+                                                    Result.CICTime, Result.CICRejection, Result.FIRTime / Result.CICTime);
+        }
+        return 0;
+    }
+
+    if(Parser.isSet(FixedBenchmarkOption))
+    {
+        for(double Level : { 10.0, 100.0, 1000.0, 10000.0, 20000.0, 30000.0 })
+        {
+            FixedPointComparison Result = CompareFixedPoint(Level);
+            qDebug().noquote() << QString::asprintf("Fixed Point, tone of %.0f counts (%s kernels): output %.1f rms; float SNR %.1fdB, %.2f nS/sample; "
+                                                    "fixed point SNR %.1fdB (%.1fdB at its int16 output), %.2f nS/sample", Level, FIR->Name,
+                                                    Result.OutputLevel, Result.FloatSNR, Result.FloatTime, Result.FixedSNR,
+                                                    Result.OutputSNR, Result.FixedTime);
+        }
+        return 0;
+    }
+
+    SampleSource *Source;
+    if(Parser.isSet(ReplayOption)) Source = new FileSource(Parser.value(ReplayOption), !Parser.isSet(FastOption));
+    else if(Parser.isSet(GenerateOption))
+    {
+        GeneratorSettings Settings;
+        if(Parser.isSet(FaradayOption)) Settings.FaradayRate = Parser.value(FaradayOption).toDouble();
+        if(Parser.isSet(DopplerOption)) Settings.DopplerRate = Parser.value(DopplerOption).toDouble();
+        Source = new GeneratorSource(Settings, !Parser.isSet(FastOption));
+    }
+    else Source = new RSPduoInterface;
+
+    MainWindow w(Source);
+    if(Parser.isSet(BlockSizeOption)) w.SetBlockSize(Parser.value(BlockSizeOption).toInt());
+    if(Parser.isSet(OverrunOption)) w.SetOverrunPolicy((Parser.value(OverrunOption) == "resync") ? ResyncBoth : SkipToNewest);
+    if(Parser.isSet(PipelineOption)) w.SetPipeline((Parser.value(PipelineOption) == "on") ? 1 : 0);
+    if(Parser.isSet(FrontEndOption)) w.SetFrontEnd((Parser.value(FrontEndOption) == "cic") ? 1 : 0);
+    if(Parser.isSet(FixedPointOption)) w.SetFixedPoint((Parser.value(FixedPointOption) == "on") ? 1 : 0);
+    if(Parser.isSet(StageFilterOption)) w.SetStageFilters(Parser.values(StageFilterOption).join(';'));
     w.show();
 
     return a.exec();
@@ -20,7 +20,6 @@
 
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
-#include "rspduointerface.h"
 #include "processthread.h"
 
 #include <QDebug>
@@ -29,7 +28,7 @@
 #include <QtMath>
 #include <QPoint>
 
-MainWindow::MainWindow(QWidget *parent) :
+MainWindow::MainWindow(SampleSource *Source, QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow)
 {
@@ -41,18 +40,20 @@ MainWindow::MainWindow(QWidget *parent) :
     WorkerThread.start();
     WorkerThread.setPriority(QThread::TimeCriticalPriority);
 
-    // Initalise RSPduo interface object
-    P_RSPduo = new RSPduoInterface;
+    // Take over the input sample source object
+    P_Source = Source;
+    P_Source->setParent(this);
 
     // Initalise Timer object
     P_Timer = new QTimer(this);
 
     // Connect Signals and Slots
-    connect(P_RSPduo, SIGNAL(Status(QString)), this, SLOT(DisplayStatus(QString)));
+    connect(P_Source, SIGNAL(Status(QString)), this, SLOT(DisplayStatus(QString)));
     connect(P_Timer, SIGNAL(timeout()), this, SLOT(on_Timer()));
     connect(this, SIGNAL(StartProcessThread()), P_ProcessThread, SLOT(Start()));
-    connect(this, SIGNAL(StopProcessThread()), P_ProcessThread, SLOT(Stop()));
+    connect(this, SIGNAL(StopProcessThread()), P_ProcessThread, SLOT(Stop()), Qt::BlockingQueuedConnection);   // returns once DSP has stopped
     connect(P_ProcessThread, SIGNAL(StatusMessage(QString)), this, SLOT(DisplayStatus(QString)));
+    connect(P_ProcessThread, SIGNAL(InputStats(BlockStats,BlockStats)), this, SLOT(DisplayInputStats(BlockStats,BlockStats)));
     connect(this, SIGNAL(GenerateSinCosTable(double,double)), P_ProcessThread, SLOT(GenerateSinCosTable(double,double)));
 
     // Read Saved Settings if available or use defaults provided
@@ -67,6 +68,12 @@ MainWindow::MainWindow(QWidget *parent) :
     RequiredPhase = settings.value("RequiredPhase",RequiredPhase).toInt();
     SelectedCalPort = settings.value("SelectedCalPort",SelectedCalPort).toString();
     AutoCal = settings.value("AutoCal", AutoCal).toInt();
+    BlockSize = settings.value("BlockSize", BlockSize).toInt();
+    Overrun = settings.value("OverrunPolicy", Overrun).toInt();
+    Pipelined = settings.value("DSPPipeline", Pipelined).toInt();
+    FrontEnd = settings.value("FrontEnd", FrontEnd).toInt();
+    FixedPoint = settings.value("FixedPoint", FixedPoint).toInt();
+    StageFilters = settings.value("StageFilters", StageFilters).toString();
 
     // Build list of available output audio devices
     OutputDeviceInfoList = QAudioDeviceInfo::availableDevices(QAudio::AudioOutput);
@@ -187,6 +194,12 @@ void MainWindow::closeEvent(QCloseEvent *event)  // Save settings when closing M
     settings.setValue("RequiredPhase", RequiredPhase);
     settings.setValue("SelectedCalPort", SelectedCalPort);
     settings.setValue("AutoCal",AutoCal);
+    settings.setValue("BlockSize",BlockSize);
+    settings.setValue("OverrunPolicy",Overrun);
+    settings.setValue("DSPPipeline",Pipelined);
+    settings.setValue("FrontEnd",FrontEnd);
+    settings.setValue("FixedPoint",FixedPoint);
+    settings.setValue("StageFilters",StageFilters);
 
 }
 
@@ -207,11 +220,12 @@ void MainWindow::on_Timer()
         loop++;
     }
     if(loop != 0) AverageTime /= loop;
-    // 40ms is required for each DSP process, warn if getting close to this
-    if(AverageTime > 0.035)
+    // one block period (40ms by default) is available for each DSP process, warn if getting close to this
+    double BlockPeriod = double(BlockSize) / INPUT_SAMPLE_RATE;
+    if(AverageTime > 0.875 * BlockPeriod)
     {
         QString Message;
-        Message = QString::asprintf("Warning: DSP Process Time = %2.0f%%",100*AverageTime/0.040);
+        Message = QString::asprintf("Warning: DSP Process Time = %2.0f%%",100*AverageTime/BlockPeriod);
         //ui->StatusTextEdit->appendPlainText(Message);
         qDebug() << Message;
     }
@@ -379,7 +393,17 @@ void MainWindow::on_StartButton_clicked()
 {
     if(ui->StartButton->text() == "Start")
     {
-        P_RSPduo->Start(CentreFrequency*1000, IFGainA, IFGainB, LNAGain);
+        // size the input blocks before the source starts writing, smaller blocks give lower latency
+        BlockSize = SetInputBlockSize(BlockSize);
+        P_ProcessThread->BlockSize = BlockSize;
+        P_ProcessThread->Overrun = Overrun;
+        P_ProcessThread->Pipelined = Pipelined;
+        P_ProcessThread->FrontEnd = FrontEnd;
+        P_ProcessThread->FixedPoint = FixedPoint;
+        P_ProcessThread->StageFilters = StageFilters;
+        DisplayStatus(QString::asprintf("Input Block Size %d Samples (%.1f mS)", BlockSize, (1000.0 * BlockSize) / INPUT_SAMPLE_RATE));
+
+        P_Source->Start(CentreFrequency*1000, IFGainA, IFGainB, LNAGain);
         P_Timer->start(100); // update phase dispaly
 
         // ensure current parameters are set
@@ -415,9 +439,12 @@ void MainWindow::on_StartButton_clicked()
 
     else if(ui->StartButton->text() == "Stop")
     {
+        // both return once stopped, so the next Start can resize the input rings with no reader or writer left
         emit StopProcessThread();
-        P_RSPduo->Stop();
+        P_Source->Stop();
         P_Timer->stop();
+        InputStatsA.Clear();  // remove the level display
+        InputStatsB.Clear();
         ui->StartButton->setText("Start");
         Processing = 0; // reset processing flag
         CloseCalibratorPort();
@@ -425,6 +452,14 @@ void MainWindow::on_StartButton_clicked()
 }
 
 
+void MainWindow::DisplayInputStats(BlockStats A, BlockStats B)
+{
+    // keep the latest input statistics for the level display (peak/RMS dBFS)
+    InputStatsA = A;
+    InputStatsB = B;
+}
+
+
 void MainWindow::DisplayStatus(QString MessageString)
 {
     ui->StatusTextEdit->appendPlainText(MessageString);
@@ -454,7 +489,7 @@ void MainWindow::on_GainSpinBoxA_valueChanged(int arg1)
 {
     IFGainA = arg1;
     // update IFgain on RSPduo if running
-    if(Processing == 1) P_RSPduo->ChangeIFGainA(IFGainA);
+    if(Processing == 1) P_Source->ChangeIFGainA(IFGainA);
 }
 
 
@@ -462,7 +497,7 @@ void MainWindow::on_GainSpinBoxB_valueChanged(int arg1)
 {
     IFGainB = arg1;
     // update IFgain on RSPduo if running
-    if(Processing == 1) P_RSPduo->ChangeIFGainB(IFGainA,IFGainB);
+    if(Processing == 1) P_Source->ChangeIFGainB(IFGainA,IFGainB);
 }
 
 
@@ -470,7 +505,7 @@ void MainWindow::on_LNAspinBox_valueChanged(int arg1)
 {
     LNAGain = arg1;
     // update LNAgain on RSPduo if running
-    if(Processing == 1) P_RSPduo->ChangeLNAGain(LNAGain,IFGainA,IFGainB);
+    if(Processing == 1) P_Source->ChangeLNAGain(LNAGain,IFGainA,IFGainB);
 }
 
 
@@ -612,12 +647,13 @@ void MainWindow::paintEvent(QPaintEvent *event)
     if((PhaseDisplayTimeout < 10) || (PhaseTestMode == 1))
     {
         int index = P_ProcessThread->LatestOutputDataIndex;
+        DSPthread *DSP = P_ProcessThread->P_DSPthread;
         for(int loop = 0; loop < BufferSize; loop++)
         {
-            IAcopy[loop] = P_ProcessThread->P_DSPthread->I_CircularOutputBufferA[index];
-            QAcopy[loop] = P_ProcessThread->P_DSPthread->Q_CircularOutputBufferA[index];
-            IBcopy[loop] = P_ProcessThread->P_DSPthread->I_CircularOutputBufferB[index];
-            QBcopy[loop] = P_ProcessThread->P_DSPthread->Q_CircularOutputBufferB[index];
+            IAcopy[loop] = DSP->FixedPoint ? DSP->I_CircularOutputBufferA16[index] : DSP->I_CircularOutputBufferA[index];
+            QAcopy[loop] = DSP->FixedPoint ? DSP->Q_CircularOutputBufferA16[index] : DSP->Q_CircularOutputBufferA[index];
+            IBcopy[loop] = DSP->FixedPoint ? DSP->I_CircularOutputBufferB16[index] : DSP->I_CircularOutputBufferB[index];
+            QBcopy[loop] = DSP->FixedPoint ? DSP->Q_CircularOutputBufferB16[index] : DSP->Q_CircularOutputBufferB[index];
             index++;
             if(index >= P_ProcessThread->P_DSPthread->CircularOutputBufferSize) index = 0;
         }
@@ -699,6 +735,14 @@ void MainWindow::paintEvent(QPaintEvent *event)
     painter.setPen(QPen(Qt::black, 0, Qt::SolidLine, Qt::RoundCap));
     if(OverloadFlag == 1) painter.drawText(37,90,"Overload");
 
+    // draw input levels, and flag ADC clipping
+    if(InputStatsA.Count != 0)
+        painter.drawText(37,105,QString::asprintf("A %.0f/%.0f dBFS%s", InputStatsA.PeakdBFS(), InputStatsA.RMSdBFS(),
+                                                  (InputStatsA.Clipped != 0) ? " Clip" : ""));
+    if(InputStatsB.Count != 0)
+        painter.drawText(37,120,QString::asprintf("B %.0f/%.0f dBFS%s", InputStatsB.PeakdBFS(), InputStatsB.RMSdBFS(),
+                                                  (InputStatsB.Clipped != 0) ? " Clip" : ""));
+
     // set phase automatically if AutuCal enabled
     if(AutoCal == 1)
     {
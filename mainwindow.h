@@ -13,7 +13,7 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
-#include "rspduointerface.h"
+#include "samplesource.h"
 #include "processthread.h"
 
 #include <QMainWindow>
@@ -25,7 +25,7 @@
 #include <QSerialPortInfo>
 #include <QSerialPort>
 
-extern int OverloadFlag;  // defined in rspduointerface.c
+extern int OverloadFlag;  // defined in samplesource.cpp
 
 namespace Ui {
 class MainWindow;
@@ -36,13 +36,20 @@ class MainWindow : public QMainWindow
     Q_OBJECT
 
 public:
-    explicit MainWindow(QWidget *parent = 0);
+    explicit MainWindow(SampleSource *Source, QWidget *parent = 0);
     ~MainWindow();
     void closeEvent(QCloseEvent *event);
+    void SetBlockSize(int Samples) { BlockSize = Samples; }  // input block size override (samples)
+    void SetOverrunPolicy(int Policy) { Overrun = Policy; }  // input overrun recovery override
+    void SetPipeline(int On) { Pipelined = On; }             // pipelined DSP override
+    void SetFrontEnd(int CIC) { FrontEnd = CIC; }            // CIC front end override
+    void SetFixedPoint(int On) { FixedPoint = On; }          // fixed point filter chain override
+    void SetStageFilters(const QString &Designs) { StageFilters = Designs; }   // stage filter designs override
 
 public slots:
 
     void DisplayStatus(QString);
+    void DisplayInputStats(BlockStats, BlockStats);
 
 signals:
 
@@ -77,7 +84,7 @@ private:
 
     QThread WorkerThread;                          // worker thread for ProcessThread
     ProcessThread *P_ProcessThread;                // pointer to Process Thread
-    RSPduoInterface *P_RSPduo;                     // pointer for RSPduoInterface class
+    SampleSource *P_Source;                        // pointer to the input sample source (RSPduo or replay)
     QTimer *P_Timer;                               // pointer for interval Timer
     QSerialPort *P_CalPort = nullptr;              // pointer to the calibrator serial port object
     QList<QAudioDeviceInfo> OutputDeviceInfoList;  // list of audio output devices
@@ -88,7 +95,15 @@ private:
     int IFGainA = 40;                              // current IF gain setting for tuner A
     int IFGainB = 40;                              // current IF gain setting for tuner B
     int LNAGain = 5;                               // current LNA gain setting
+    int BlockSize = INPUT_BUFFER_SIZE;             // input block size (samples), smaller for lower latency
+    int Overrun = SkipToNewest;                    // input overrun recovery, SkipToNewest or ResyncBoth
+    int Pipelined = 0;                             // DSP filter stages on a pipeline of threads = 1, single thread = 0
+    int FrontEnd = 0;                              // first decimation, D2A/D2B FIR = 0, CIC = 1
+    int FixedPoint = 0;                            // filter chain arithmetic, float = 0, fixed point = 1
+    QString StageFilters;                          // designs for the D2B, D5, US6 and US4 stages, empty for filters.h
     double PhaseCorrection = 0;                    // calculated value for dual mode phase correction (radians)
+    BlockStats InputStatsA;                        // latest input statistics for channel A (100mS)
+    BlockStats InputStatsB;                        // latest input statistics for channel B, empty if not dual
     int PhaseDisplayTimeout = 0;                   // used to count delay before phase display is stopped
     QString SelectedMode;                          // selected mode
     int DuplicateA = 0;                            // duplicate channel A in channel B if = 1
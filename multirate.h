@@ -0,0 +1,917 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+#ifndef MULTIRATE_H
+#define MULTIRATE_H
+
+#include "delayline.h"
+#include "firkernels.h"
+#include "fftfilter.h"
+#include "cicfilter.h"
+#include "filters.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+
+// Multirate filter stages, and a chain that runs them one after another over each frame.
+//
+// A stage filters Channels channels of complex samples in step, with the same ratio and coefficients but one delay
+// line per channel and component, except that two channels (A and B) are interleaved into one delay line of four
+// lanes, I and Q of each, so one vector multiply with a broadcast coefficient serves all four streams. It carries
+// its state from one frame to the next, so frames of any size give a continuous output. Ratios are template
+// parameters; the tap count parameter sizes the filters.h table, and Setup can instead give a decimator or
+// interpolator a table of any length (a design, see LoadDesign). float samples go through the FIR kernels selected
+// at startup, int16 samples through their Q15 kernels with Q15 coefficient tables; int32 (the fixed point chain)
+// and any other sample type use plain loops. A stage adds its products up in MAC<T>::Accumulator and stores
+// MAC<T>::Output() of it.
+//
+// Every stage provides
+//     Sample, ChannelCount     sample type and number of channels
+//     Enabled                  stage is bypassed by Chain when false
+//     Process(In, Out)         filter In.Count samples per channel into Out, returns Out.Count
+//     Reset()                  clear the history and restart the phase
+// and the first stage of a chain also
+//     Input                    input sample type
+//     Process(In, Count, Out)  filter Count samples from each of the Channels arrays In[] into Out
+
+
+// ---- Complex sample buffer, I and Q in separate arrays per channel ---- //
+
+template<typename T, int Channels>
+class IQBuffer
+{
+public:
+    typedef T Sample;
+
+    IQBuffer() {}
+    IQBuffer(const IQBuffer &) = delete;
+    IQBuffer &operator=(const IQBuffer &) = delete;
+
+    ~IQBuffer()
+    {
+        for(int Channel = 0; Channel < Channels; Channel++) { delete[] I[Channel]; delete[] Q[Channel]; }
+    }
+
+    void Allocate(int Size)
+    {
+        for(int Channel = 0; Channel < Channels; Channel++)
+        {
+            delete[] I[Channel];
+            delete[] Q[Channel];
+            I[Channel] = new T[Size];
+            Q[Channel] = new T[Size];
+        }
+        Capacity = Size;
+        Count = 0;
+    }
+
+    T *I[Channels] {};                          // I samples of each channel
+    T *Q[Channels] {};                          // Q samples of each channel
+    int Count = 0;                              // samples per channel
+    int Capacity = 0;                           // allocated samples per channel
+};
+
+
+// ---- Multiply accumulate for a sample type ---- //
+
+template<typename T>
+struct MAC
+{
+    typedef T Accumulator;
+    static T Output(T Acc) { return Acc; }
+
+    static T Dot(const T *x, const T *h, int Length)
+    {
+        T Acc = 0;
+        for(int k = 0; k < Length; k++) Acc += x[k] * h[k];
+        return Acc;
+    }
+
+    static void DotIQ(const T *I, const T *Q, const T *h, int Length, T *OutI, T *OutQ)
+    {
+        T AccI = 0, AccQ = 0;
+        for(int k = 0; k < Length; k++) { AccI += I[k] * h[k]; AccQ += Q[k] * h[k]; }
+        *OutI = AccI;
+        *OutQ = AccQ;
+    }
+
+    static void FoldIQ(const T *I1, const T *Q1, const T *I2, const T *Q2, const T *h, int Length, T *OutI, T *OutQ)
+    {
+        T AccI = 0, AccQ = 0;
+        for(int k = 0; k < Length; k++) { AccI += (I1[k] + I2[k]) * h[k]; AccQ += (Q1[k] + Q2[k]) * h[k]; }
+        *OutI = AccI;
+        *OutQ = AccQ;
+    }
+
+    static void Dot4(const T *x, const T *h, int Length, T *Out)
+    {
+        T Acc[4] = {0, 0, 0, 0};
+        for(int k = 0; k < Length; k++)
+            for(int Lane = 0; Lane < 4; Lane++) Acc[Lane] += x[(4 * k) + Lane] * h[k];
+        for(int Lane = 0; Lane < 4; Lane++) Out[Lane] = Acc[Lane];
+    }
+
+    static void Fold4(const T *x1, const T *x2, const T *h, int Length, T *Out)
+    {
+        T Acc[4] = {0, 0, 0, 0};
+        for(int k = 0; k < Length; k++)
+            for(int Lane = 0; Lane < 4; Lane++) Acc[Lane] += (x1[(4 * k) + Lane] + x2[(4 * k) + Lane]) * h[k];
+        for(int Lane = 0; Lane < 4; Lane++) Out[Lane] = Acc[Lane];
+    }
+
+    static void Dot4Lanes(const T *x, const T *h, int Length, T *Out)
+    {
+        T Acc[4] = {0, 0, 0, 0};
+        for(int k = 0; k < 4 * Length; k += 4)
+            for(int Lane = 0; Lane < 4; Lane++) Acc[Lane] += x[k + Lane] * h[k + Lane];
+        for(int Lane = 0; Lane < 4; Lane++) Out[Lane] = Acc[Lane];
+    }
+};
+
+template<>
+struct MAC<float>
+{
+    typedef float Accumulator;
+    static float Output(float Acc) { return Acc; }
+
+    static float Dot(const float *x, const float *h, int Length)
+    {
+        return FIR->Dot(x, h, Length);
+    }
+
+    static void DotIQ(const float *I, const float *Q, const float *h, int Length, float *OutI, float *OutQ)
+    {
+        FIR->DotIQ(I, Q, h, Length, OutI, OutQ);
+    }
+
+    static void FoldIQ(const float *I1, const float *Q1, const float *I2, const float *Q2, const float *h, int Length, float *OutI, float *OutQ)
+    {
+        FIR->FoldIQ(I1, Q1, I2, Q2, h, Length, OutI, OutQ);
+    }
+
+    static void Dot4(const float *x, const float *h, int Length, float *Out)
+    {
+        FIR->Dot4(x, h, Length, Out);
+    }
+
+    static void Fold4(const float *x1, const float *x2, const float *h, int Length, float *Out)
+    {
+        FIR->Fold4(x1, x2, h, Length, Out);
+    }
+
+    static void Dot4Lanes(const float *x, const float *h, int Length, float *Out)
+    {
+        FIR->Dot4Lanes(x, h, Length, Out);
+    }
+};
+
+// int16 samples and Q15 coefficients, exact sums in 64 bits (2^15 times the result), rounded and saturated back
+template<>
+struct MAC<short>
+{
+    typedef long long Accumulator;
+
+    static short Output(long long Acc)
+    {
+        long long Rounded = (Acc + (1 << 14)) >> 15;
+        return short((Rounded > 32767) ? 32767 : ((Rounded < -32768) ? -32768 : Rounded));
+    }
+
+    static long long Dot(const short *x, const short *h, int Length)
+    {
+        return FIR->DotQ15(x, h, Length);
+    }
+
+    static void DotIQ(const short *I, const short *Q, const short *h, int Length, long long *OutI, long long *OutQ)
+    {
+        FIR->DotIQQ15(I, Q, h, Length, OutI, OutQ);
+    }
+
+    static void FoldIQ(const short *I1, const short *Q1, const short *I2, const short *Q2, const short *h, int Length, long long *OutI, long long *OutQ)
+    {
+        FIR->FoldIQQ15(I1, Q1, I2, Q2, h, Length, OutI, OutQ);
+    }
+
+    static void Dot4(const short *x, const short *h, int Length, long long *Out)
+    {
+        FIR->Dot4Q15(x, h, Length, Out);
+    }
+
+    static void Fold4(const short *x1, const short *x2, const short *h, int Length, long long *Out)
+    {
+        FIR->Fold4Q15(x1, x2, h, Length, Out);
+    }
+
+    static void Dot4Lanes(const short *x, const short *h, int Length, long long *Out)
+    {
+        FIR->Dot4LanesQ15(x, h, Length, Out);
+    }
+};
+
+// int32 samples carrying Fraction bits below the int16 input count and Q15 coefficients (the fixed point chain),
+// exact sums in 64 bits rounded and saturated back to int32
+template<>
+struct MAC<int>
+{
+    typedef long long Accumulator;
+    static constexpr int Fraction = 12;
+
+    static int Output(long long Acc)
+    {
+        long long Rounded = (Acc + (1 << 14)) >> 15;
+        return int((Rounded > INT_MAX) ? INT_MAX : ((Rounded < INT_MIN) ? INT_MIN : Rounded));
+    }
+
+    static short ToInt16(int x)                 // to the int16 input scale, rounded and saturated
+    {
+        int Rounded = int((x + (1LL << (Fraction - 1))) >> Fraction);
+        return short((Rounded > 32767) ? 32767 : ((Rounded < -32768) ? -32768 : Rounded));
+    }
+
+    static long long Dot(const int *x, const int *h, int Length)
+    {
+        long long Acc = 0;
+        for(int k = 0; k < Length; k++) Acc += (long long)x[k] * h[k];
+        return Acc;
+    }
+
+    static void DotIQ(const int *I, const int *Q, const int *h, int Length, long long *OutI, long long *OutQ)
+    {
+        long long AccI = 0, AccQ = 0;
+        for(int k = 0; k < Length; k++) { AccI += (long long)I[k] * h[k]; AccQ += (long long)Q[k] * h[k]; }
+        *OutI = AccI;
+        *OutQ = AccQ;
+    }
+
+    static void FoldIQ(const int *I1, const int *Q1, const int *I2, const int *Q2, const int *h, int Length, long long *OutI, long long *OutQ)
+    {
+        long long AccI = 0, AccQ = 0;
+        for(int k = 0; k < Length; k++) { AccI += ((long long)I1[k] + I2[k]) * h[k]; AccQ += ((long long)Q1[k] + Q2[k]) * h[k]; }
+        *OutI = AccI;
+        *OutQ = AccQ;
+    }
+
+    static void Dot4(const int *x, const int *h, int Length, long long *Out)
+    {
+        long long Acc[4] = {0, 0, 0, 0};
+        for(int k = 0; k < Length; k++)
+            for(int Lane = 0; Lane < 4; Lane++) Acc[Lane] += (long long)x[(4 * k) + Lane] * h[k];
+        for(int Lane = 0; Lane < 4; Lane++) Out[Lane] = Acc[Lane];
+    }
+
+    static void Fold4(const int *x1, const int *x2, const int *h, int Length, long long *Out)
+    {
+        long long Acc[4] = {0, 0, 0, 0};
+        for(int k = 0; k < Length; k++)
+            for(int Lane = 0; Lane < 4; Lane++) Acc[Lane] += ((long long)x1[(4 * k) + Lane] + x2[(4 * k) + Lane]) * h[k];
+        for(int Lane = 0; Lane < 4; Lane++) Out[Lane] = Acc[Lane];
+    }
+};
+
+
+// ---- Quadrature mixer and decimate by M, from a real int16 input ---- //
+//
+// The oscillator is a table that repeats every TableLength input samples. Mixing and then filtering gives an output,
+// at oscillator position p, whose tap k is the input sample k back times the oscillator at p - k. So there is one set
+// of filter coefficients pre-multiplied by the oscillator for each p (SetOscillator), and the real input is filtered
+// directly, only where an output is due. Two channels share one history of four lanes (A, A, B, B) against
+// coefficients interleaved the same way (I of A, Q of A, I of B, Q of B). UseCIC() may switch a float stage to a CIC
+// front end (CICDecimator) instead, for both channels, decimating by its own ratio of at least M. An int32 stage
+// filters its int16 input on the Q15 kernels and has the float stage's gain, MAC<int>::Fraction bits finer.
+
+template<int M, int Taps, typename T = float, int Channels = 1>
+class Mixer
+{
+    static constexpr bool Interleaved = (Channels == 2);
+    typedef typename std::conditional<std::is_same<T, int>::value, short, T>::type Tap;   // history and coefficients
+
+public:
+    typedef T Sample;
+    typedef short Input;                        // chain input sample type, when first in a chain
+    static constexpr int ChannelCount = Channels;
+    bool Enabled = true;
+
+    Mixer() {}
+    Mixer(const Mixer &) = delete;
+    Mixer &operator=(const Mixer &) = delete;
+
+    ~Mixer()
+    {
+        delete[] Table4;
+        for(int Channel = 0; Channel < Channels; Channel++) { delete[] TableI[Channel]; delete[] TableQ[Channel]; delete CIC[Channel]; }
+    }
+
+    void Setup(const double (&Coef)[Taps], int Length)
+    {
+        Filter = Coef;
+        TableLength = Length;
+        if constexpr(std::is_same<T, float>::value)
+            for(int Channel = 0; Channel < Channels; Channel++) if(!CIC[Channel]) CIC[Channel] = new CICDecimator;
+        if constexpr(Interleaved)
+        {
+            delete[] Table4;
+            Table4 = new Tap[TableLength * Taps * 4]();
+            History4.Allocate(Taps, false, 4);
+            return;
+        }
+        for(int Channel = 0; Channel < Channels; Channel++)
+        {
+            delete[] TableI[Channel];
+            delete[] TableQ[Channel];
+            TableI[Channel] = new Tap[TableLength * Taps]();
+            TableQ[Channel] = new Tap[TableLength * Taps]();
+            History[Channel].Allocate(Taps);
+        }
+    }
+
+    // always direct form, returns the most outputs from Samples inputs, at the CIC ratio with the CIC front end
+    int Plan(int Samples) { return Samples / (CICRatio_ ? CICRatio_ : M) + 1; }
+
+    // CIC front end decimating by Ratio (>= M) with its compensation filter, or the FIR for Ratio 0, after Setup
+    void UseCIC(int Ratio, const double *Compensation, int Length)
+    {
+        CICRatio_ = 0;
+        if constexpr(std::is_same<T, float>::value) if(Ratio)
+        {
+            for(int Channel = 0; Channel < Channels; Channel++) CIC[Channel]->SetRatio(Ratio, Compensation, Length);
+            CICRatio_ = Ratio;
+        }
+    }
+
+    int CICRatio(void) const { return CICRatio_; }  // 0 for the FIR
+
+    // oscillator of one channel, TableLength Sin and Cos values
+    void SetOscillator(int Channel, const double *Sin, const double *Cos)
+    {
+        if constexpr(std::is_same<T, float>::value) CIC[Channel]->SetOscillator(Sin, Cos, TableLength);
+        for(int Pointer = 0; Pointer < TableLength; Pointer++)
+        {
+            for(int k = 0; k < Taps; k++)
+            {
+                int Mixed = ((Pointer - k) % TableLength + TableLength) % TableLength;
+                if constexpr(Interleaved)
+                {
+                    Table4[(((Pointer * Taps) + k) * 4) + (2 * Channel)] = Coefficient<Tap>(Filter[k] * Sin[Mixed]);
+                    Table4[(((Pointer * Taps) + k) * 4) + (2 * Channel) + 1] = Coefficient<Tap>(Filter[k] * Cos[Mixed]);
+                }
+                else
+                {
+                    TableI[Channel][(Pointer * Taps) + k] = Coefficient<Tap>(Filter[k] * Sin[Mixed]);
+                    TableQ[Channel][(Pointer * Taps) + k] = Coefficient<Tap>(Filter[k] * Cos[Mixed]);
+                }
+            }
+        }
+    }
+
+    int Process(const Input *const *In, int Count, IQBuffer<T, Channels> &Out)
+    {
+        int OP = 0;
+        if constexpr(std::is_same<T, float>::value) if(CICRatio_)
+        {
+            for(int Channel = 0; Channel < Channels; Channel++) OP = CIC[Channel]->Process(In[Channel], Count, Out.I[Channel], Out.Q[Channel]);
+            Out.Count = OP;
+            return OP;
+        }
+        for(int n = 0; n < Count; n++)
+        {
+            if constexpr(Interleaved)
+            {
+                Tap Lanes[4] = { Tap(In[0][n]), Tap(In[0][n]), Tap(In[1][n]), Tap(In[1][n]) };
+                History4.Push(Lanes);
+            }
+            else for(int Channel = 0; Channel < Channels; Channel++) History[Channel].Push(In[Channel][n]);
+
+            if(++Stage >= M)
+            {
+                // complex output from the coefficients for the oscillator position of the newest sample
+                if constexpr(Interleaved)
+                {
+                    typename MAC<Tap>::Accumulator Acc[4];
+                    MAC<Tap>::Dot4Lanes(History4.Window(), &Table4[Pointer * Taps * 4], Taps, Acc);
+                    Out.I[0][OP] = Output(Acc[0]); Out.Q[0][OP] = Output(Acc[1]);
+                    Out.I[1][OP] = Output(Acc[2]); Out.Q[1][OP] = Output(Acc[3]);
+                }
+                else for(int Channel = 0; Channel < Channels; Channel++)
+                {
+                    const Tap *Window = History[Channel].Window();
+                    Out.I[Channel][OP] = Output(MAC<Tap>::Dot(Window, &TableI[Channel][Pointer * Taps], Taps));
+                    Out.Q[Channel][OP] = Output(MAC<Tap>::Dot(Window, &TableQ[Channel][Pointer * Taps], Taps));
+                }
+                Stage = 0;
+                OP++;
+            }
+            if(++Pointer >= TableLength) Pointer = 0;
+        }
+        Out.Count = OP;
+        return OP;
+    }
+
+    void Reset(void)
+    {
+        Stage = 0;
+        Pointer = 0;
+        for(int Channel = 0; Channel < Channels; Channel++) if(CIC[Channel]) CIC[Channel]->Reset();
+        if constexpr(Interleaved) History4.Clear();
+        else for(int Channel = 0; Channel < Channels; Channel++) History[Channel].Clear();
+    }
+
+private:
+    static T Output(typename MAC<Tap>::Accumulator Acc)
+    {
+        if constexpr(std::is_same<T, int>::value) return MAC<int>::Output(Acc * (1 << MAC<int>::Fraction));
+        else return MAC<T>::Output(Acc);
+    }
+
+    const double *Filter = nullptr;             // decimation filter coefficients
+    Tap *TableI[Channels] {};                   // coefficients times the oscillator, Taps per oscillator position
+    Tap *TableQ[Channels] {};
+    DelayLine<Tap> History[Channels];           // real input history
+    Tap *Table4 = nullptr;                      // two channels: the four tables interleaved, 4 * Taps per position
+    DelayLine<Tap> History4;                    // two channels: input history in four lanes
+    int TableLength = 0;                        // oscillator table length
+    int Stage = 0;                              // input samples since the last output
+    int Pointer = 0;                            // oscillator position of the next input sample
+    int CICRatio_ = 0;                          // CIC decimation when the CIC front end is in use, else 0
+    CICDecimator *CIC[Channels] {};             // CIC front end of each channel
+};
+
+
+// ---- Polyphase decimate by M ---- //
+//
+// Subfilter s takes every Mth input sample, the outputs of all M are added once all have their sample. A symmetric
+// (linear phase) filter is folded: subfilter M-1-s is subfilter s backwards, so it keeps its history oldest first and
+// the pair is one pre-added dot product. For odd M the middle subfilter folds onto an oldest first copy of itself.
+// Two channels keep I and Q of both in the four lanes of one delay line per subfilter. Plan() may switch a float
+// stage to FFT filtering (FFTDecimator) instead, for both channels.
+
+template<int M, int Taps, typename T = float, int Channels = 1>
+class Decimator
+{
+    static_assert(Taps % M == 0, "polyphase filter taps must be a multiple of the decimation factor");
+    static constexpr bool Interleaved = (Channels == 2);
+
+public:
+    typedef T Sample;
+    static constexpr int ChannelCount = Channels;
+    bool Enabled = true;
+
+    Decimator() {}
+    Decimator(const Decimator &) = delete;
+    Decimator &operator=(const Decimator &) = delete;
+
+    ~Decimator()
+    {
+        for(int Channel = 0; Channel < Channels; Channel++) delete Fast[Channel];
+    }
+
+    // the coefficients, a table of any length (Taps is only the length of the default filter in filters.h)
+    template<int Subfilter> void Setup(const PolyphaseTable<T, M, Subfilter> &Coefficients) { Setup(Coefficients.Coef[0], Subfilter); }
+    void Setup(const PolyphaseVector<T, M> &Coefficients) { Setup(Coefficients[0], Coefficients.Taps); }
+
+    // M subfilters of Subfilter taps, one after another, as a PolyphaseTable lays them out
+    void Setup(const T *Coefficients, int Subfilter)
+    {
+        Coef = Coefficients;
+        Length = Subfilter;
+        Symmetric = true;
+        for(int s = 0; s < M; s++)
+            for(int i = 0; i < Length; i++) if(Row(s)[i] != Row(M-1-s)[Length-1-i]) Symmetric = false;
+        FoldMiddle = Symmetric && (M % 2 == 1) && (Length % 2 == 0);
+
+        if constexpr(Interleaved)
+        {
+            for(int s = 0; s < M; s++) Line4[s].Allocate(Length, Symmetric && (s > (M-1)/2), 4);
+            Middle4.Allocate(Length, true, 4);
+            return;
+        }
+        for(int Channel = 0; Channel < Channels; Channel++)
+        {
+            for(int s = 0; s < M; s++)
+            {
+                I_Line[Channel][s].Allocate(Length, Symmetric && (s > (M-1)/2));
+                Q_Line[Channel][s].Allocate(Length, Symmetric && (s > (M-1)/2));
+            }
+            I_Middle[Channel].Allocate(Length, true);
+            Q_Middle[Channel].Allocate(Length, true);
+        }
+    }
+
+    // direct form or FFT (see PlanFFTDecimator) for up to Samples inputs per Process, after Setup, returns the most outputs
+    int Plan(int Samples)
+    {
+        FastSize = 0;
+        if constexpr(std::is_same<T, float>::value) FastSize = PlanFFTDecimator(M, Length, Symmetric, Samples);
+        for(int Channel = 0; Channel < Channels; Channel++)
+        {
+            delete Fast[Channel];
+            Fast[Channel] = nullptr;
+            if constexpr(std::is_same<T, float>::value) if(FastSize) Fast[Channel] = new FFTDecimator(Coef, M, Length, FastSize);
+        }
+        return Samples / M + 1;
+    }
+
+    int Process(const IQBuffer<T, Channels> &In, IQBuffer<T, Channels> &Out)   // Out may be In
+    {
+        int OP = 0;
+        if constexpr(std::is_same<T, float>::value) if(FastSize)
+        {
+            for(int Channel = 0; Channel < Channels; Channel++) OP = Fast[Channel]->Process(In.I[Channel], In.Q[Channel], In.Count, Out.I[Channel], Out.Q[Channel]);
+            Out.Count = OP;
+            return OP;
+        }
+        for(int n = 0; n < In.Count; n++)
+        {
+            if constexpr(Interleaved)
+            {
+                T Lanes[4] = { In.I[0][n], In.Q[0][n], In.I[1][n], In.Q[1][n] };
+                Line4[Stage].Push(Lanes);
+                if(FoldMiddle && (Stage == M/2)) Middle4.Push(Lanes);
+            }
+            else for(int Channel = 0; Channel < Channels; Channel++)
+            {
+                I_Line[Channel][Stage].Push(In.I[Channel][n]);
+                Q_Line[Channel][Stage].Push(In.Q[Channel][n]);
+                if(FoldMiddle && (Stage == M/2)) { I_Middle[Channel].Push(In.I[Channel][n]); Q_Middle[Channel].Push(In.Q[Channel][n]); }
+            }
+            if(++Stage >= M)
+            {
+                if constexpr(Interleaved) Output4(Out, OP);
+                else for(int Channel = 0; Channel < Channels; Channel++) Output(Channel, &Out.I[Channel][OP], &Out.Q[Channel][OP]);
+                Stage = 0;
+                OP++;
+            }
+        }
+        Out.Count = OP;
+        return OP;
+    }
+
+    void Reset(void)
+    {
+        Stage = 0;
+        for(int Channel = 0; Channel < Channels; Channel++) if(Fast[Channel]) Fast[Channel]->Reset();
+        if constexpr(Interleaved)
+        {
+            for(int s = 0; s < M; s++) Line4[s].Clear();
+            Middle4.Clear();
+            return;
+        }
+        for(int Channel = 0; Channel < Channels; Channel++)
+        {
+            for(int s = 0; s < M; s++) { I_Line[Channel][s].Clear(); Q_Line[Channel][s].Clear(); }
+            I_Middle[Channel].Clear();
+            Q_Middle[Channel].Clear();
+        }
+    }
+
+    bool Folded(void) const { return Symmetric; }
+    int FFTSize(void) const { return FastSize; }     // 0 for direct form
+
+private:
+    const T *Row(int s) const { return Coef + (s * Length); }   // subfilter s
+
+    void Output(int Channel, T *OutI, T *OutQ)
+    {
+        const DelayLine<T> *I = I_Line[Channel];
+        const DelayLine<T> *Q = Q_Line[Channel];
+        typename MAC<T>::Accumulator SumI = 0, SumQ = 0, AccI, AccQ;
+        if(Symmetric)
+        {
+            for(int s = 0; s < M/2; s++)
+            {
+                MAC<T>::FoldIQ(I[s].Window(), Q[s].Window(), I[M-1-s].Window(), Q[M-1-s].Window(), Row(s), Length, &AccI, &AccQ);
+                SumI += AccI; SumQ += AccQ;
+            }
+            if(FoldMiddle)
+            {
+                MAC<T>::FoldIQ(I[M/2].Window(), Q[M/2].Window(), I_Middle[Channel].Window(), Q_Middle[Channel].Window(), Row(M/2), Length/2, &AccI, &AccQ);
+                SumI += AccI; SumQ += AccQ;
+            }
+            else if(M % 2 == 1)
+            {
+                MAC<T>::DotIQ(I[M/2].Window(), Q[M/2].Window(), Row(M/2), Length, &AccI, &AccQ);
+                SumI += AccI; SumQ += AccQ;
+            }
+        }
+        else
+        {
+            for(int s = 0; s < M; s++)
+            {
+                MAC<T>::DotIQ(I[s].Window(), Q[s].Window(), Row(s), Length, &AccI, &AccQ);
+                SumI += AccI; SumQ += AccQ;
+            }
+        }
+        *OutI = MAC<T>::Output(SumI);
+        *OutQ = MAC<T>::Output(SumQ);
+    }
+
+    // as Output for all four lanes at once, de-interleaved into Out
+    void Output4(IQBuffer<T, Channels> &Out, int OP)
+    {
+        typename MAC<T>::Accumulator Sum[4] = {0, 0, 0, 0}, Acc[4];
+        if(Symmetric)
+        {
+            for(int s = 0; s < M/2; s++)
+            {
+                MAC<T>::Fold4(Line4[s].Window(), Line4[M-1-s].Window(), Row(s), Length, Acc);
+                for(int Lane = 0; Lane < 4; Lane++) Sum[Lane] += Acc[Lane];
+            }
+            if(FoldMiddle)
+            {
+                MAC<T>::Fold4(Line4[M/2].Window(), Middle4.Window(), Row(M/2), Length/2, Acc);
+                for(int Lane = 0; Lane < 4; Lane++) Sum[Lane] += Acc[Lane];
+            }
+            else if(M % 2 == 1)
+            {
+                MAC<T>::Dot4(Line4[M/2].Window(), Row(M/2), Length, Acc);
+                for(int Lane = 0; Lane < 4; Lane++) Sum[Lane] += Acc[Lane];
+            }
+        }
+        else
+        {
+            for(int s = 0; s < M; s++)
+            {
+                MAC<T>::Dot4(Line4[s].Window(), Row(s), Length, Acc);
+                for(int Lane = 0; Lane < 4; Lane++) Sum[Lane] += Acc[Lane];
+            }
+        }
+        Out.I[0][OP] = MAC<T>::Output(Sum[0]); Out.Q[0][OP] = MAC<T>::Output(Sum[1]);
+        Out.I[1][OP] = MAC<T>::Output(Sum[2]); Out.Q[1][OP] = MAC<T>::Output(Sum[3]);
+    }
+
+    const T *Coef = nullptr;                    // M subfilters of Length taps
+    int Length = Taps / M;                      // taps per subfilter
+    bool Symmetric = false;                     // coefficients folded
+    bool FoldMiddle = false;                    // middle subfilter (odd M) folded onto I/Q_Middle
+    DelayLine<T> I_Line[Channels][M];           // subfilter histories
+    DelayLine<T> Q_Line[Channels][M];
+    DelayLine<T> I_Middle[Channels];            // oldest first copy of the middle subfilter history
+    DelayLine<T> Q_Middle[Channels];
+    DelayLine<T> Line4[M];                      // two channels: subfilter histories in four lanes
+    DelayLine<T> Middle4;
+    int Stage = 0;                              // next subfilter
+    int FastSize = 0;                           // FFT size when FFT filtering, else 0
+    FFTDecimator *Fast[Channels] {};            // FFT filter of each channel
+};
+
+
+// ---- Polyphase upsample by L, keeping every Keep th output ---- //
+//
+// Each input sample gives L outputs, one per subfilter (the gain L is in the coefficients). Only the outputs kept by
+// the following decimate by Keep are computed, so an L/Keep rational resampler costs one subfilter per output.
+// Two channels keep I and Q of both in the four lanes of one delay line. Plan() may switch a float stage to FFT
+// filtering (FFTInterpolator) instead, for both channels.
+
+template<int L, int Taps, typename T = float, int Channels = 1, int Keep = 1>
+class Interpolator
+{
+    static_assert(Taps % L == 0, "polyphase filter taps must be a multiple of the upsampling factor");
+    static constexpr bool Interleaved = (Channels == 2);
+
+public:
+    typedef T Sample;
+    static constexpr int ChannelCount = Channels;
+    bool Enabled = true;
+
+    Interpolator() {}
+    Interpolator(const Interpolator &) = delete;
+    Interpolator &operator=(const Interpolator &) = delete;
+
+    ~Interpolator()
+    {
+        for(int Channel = 0; Channel < Channels; Channel++) delete Fast[Channel];
+    }
+
+    // the coefficients, a table of any length (Taps is only the length of the default filter in filters.h)
+    template<int Subfilter> void Setup(const PolyphaseTable<T, L, Subfilter> &Coefficients) { Setup(Coefficients.Coef[0], Subfilter); }
+    void Setup(const PolyphaseVector<T, L> &Coefficients) { Setup(Coefficients[0], Coefficients.Taps); }
+
+    // L subfilters of Subfilter taps, one after another, as a PolyphaseTable lays them out
+    void Setup(const T *Coefficients, int Subfilter)
+    {
+        Coef = Coefficients;
+        Length = Subfilter;
+        if constexpr(Interleaved)
+        {
+            Line4.Allocate(Length, false, 4);
+            return;
+        }
+        for(int Channel = 0; Channel < Channels; Channel++)
+        {
+            I_Line[Channel].Allocate(Length);
+            Q_Line[Channel].Allocate(Length);
+        }
+    }
+
+    // direct form or FFT (see PlanFFTInterpolator) for up to Samples inputs per Process, after Setup, returns the most outputs
+    int Plan(int Samples)
+    {
+        FastSize = 0;
+        if constexpr(std::is_same<T, float>::value) FastSize = PlanFFTInterpolator(L, Length, Keep, Samples);
+        for(int Channel = 0; Channel < Channels; Channel++)
+        {
+            delete Fast[Channel];
+            Fast[Channel] = nullptr;
+            if constexpr(std::is_same<T, float>::value) if(FastSize) Fast[Channel] = new FFTInterpolator(Coef, L, Keep, Length, FastSize);
+        }
+        return (Samples * L) / Keep + 1;
+    }
+
+    int Process(const IQBuffer<T, Channels> &In, IQBuffer<T, Channels> &Out)   // Out must not be In unless L <= Keep
+    {
+        int OP = 0;
+        if constexpr(std::is_same<T, float>::value) if(FastSize)
+        {
+            for(int Channel = 0; Channel < Channels; Channel++) OP = Fast[Channel]->Process(In.I[Channel], In.Q[Channel], In.Count, Out.I[Channel], Out.Q[Channel]);
+            Out.Count = OP;
+            return OP;
+        }
+        for(int n = 0; n < In.Count; n++)
+        {
+            if constexpr(Interleaved)
+            {
+                T Lanes[4] = { In.I[0][n], In.Q[0][n], In.I[1][n], In.Q[1][n] };
+                Line4.Push(Lanes);
+            }
+            else for(int Channel = 0; Channel < Channels; Channel++)
+            {
+                I_Line[Channel].Push(In.I[Channel][n]);
+                Q_Line[Channel].Push(In.Q[Channel][n]);
+            }
+            for(int Phase = 0; Phase < L; Phase++)
+            {
+                if(Skip > 0) { Skip--; continue; }  // not kept, skip it
+                Skip = Keep - 1;
+                if constexpr(Interleaved)
+                {
+                    typename MAC<T>::Accumulator Acc[4];
+                    MAC<T>::Dot4(Line4.Window(), Row(Phase), Length, Acc);
+                    Out.I[0][OP] = MAC<T>::Output(Acc[0]); Out.Q[0][OP] = MAC<T>::Output(Acc[1]);
+                    Out.I[1][OP] = MAC<T>::Output(Acc[2]); Out.Q[1][OP] = MAC<T>::Output(Acc[3]);
+                }
+                else for(int Channel = 0; Channel < Channels; Channel++)
+                {
+                    typename MAC<T>::Accumulator AccI, AccQ;
+                    MAC<T>::DotIQ(I_Line[Channel].Window(), Q_Line[Channel].Window(), Row(Phase), Length, &AccI, &AccQ);
+                    Out.I[Channel][OP] = MAC<T>::Output(AccI);
+                    Out.Q[Channel][OP] = MAC<T>::Output(AccQ);
+                }
+                OP++;
+            }
+        }
+        Out.Count = OP;
+        return OP;
+    }
+
+    void Reset(void)
+    {
+        Skip = 0;
+        for(int Channel = 0; Channel < Channels; Channel++) if(Fast[Channel]) Fast[Channel]->Reset();
+        if constexpr(Interleaved) Line4.Clear();
+        else for(int Channel = 0; Channel < Channels; Channel++) { I_Line[Channel].Clear(); Q_Line[Channel].Clear(); }
+    }
+
+    int FFTSize(void) const { return FastSize; }     // 0 for direct form
+
+private:
+    const T *Row(int Phase) const { return Coef + (Phase * Length); }   // subfilter Phase
+
+    const T *Coef = nullptr;                    // L subfilters of Length taps
+    int Length = Taps / L;                      // taps per subfilter
+    DelayLine<T> I_Line[Channels];              // input history
+    DelayLine<T> Q_Line[Channels];
+    DelayLine<T> Line4;                         // two channels: input history in four lanes
+    int Skip = 0;                               // outputs to skip before the next one computed
+    int FastSize = 0;                           // FFT size when FFT filtering, else 0
+    FFTInterpolator *Fast[Channels] {};         // FFT filter of each channel
+};
+
+
+// ---- Chain of stages ---- //
+//
+// Runs a frame through each enabled stage in turn, in passes of up to Block input samples: every pass goes through
+// all the stages while its data is still in L1/L2 cache, rather than each stage sweeping the whole frame out of L3 or
+// memory before the next starts. The stages carry their state from one pass to the next, so the output is the same
+// whatever the block size. The first stage takes the chain input, the others alternate between two work buffers of
+// Block samples, so no stage may give more samples than the chain input block. Stage<N>() gives stage N for setup.
+
+template<typename... Stages>
+class Chain
+{
+    typedef typename std::tuple_element<0, std::tuple<Stages...>>::type Head;
+    static constexpr int Channels = Head::ChannelCount;
+
+public:
+    typedef IQBuffer<typename Head::Sample, Channels> Buffer;
+    typedef typename Head::Input Input;
+
+    template<int N> auto &Stage(void) { return std::get<N>(Stage_); }
+
+    // input samples per pass, after the stages are set up and enabled as each plans how to filter its part of a
+    // pass. A bypassed stage passes the count on unchanged and is not planned, so it must be allocated again
+    // before it is enabled.
+    void Allocate(int Block)
+    {
+        BlockSize = Block;
+        Work[0].Allocate(Block);
+        Work[1].Allocate(Block);
+        int Samples = Block;
+        std::apply([&](auto &... Each) { ((Samples = Each.Enabled ? Each.Plan(Samples) : Samples), ...); }, Stage_);
+    }
+
+    // filter Count input samples of each channel, the chain output goes to Out (which must hold all of it)
+    Buffer &Process(const Input *const *In, int Count, Buffer &Out)
+    {
+        Out.Count = 0;
+        const Input *Pass[Channels];
+        for(int Start = 0; Start < Count; Start += BlockSize)
+        {
+            for(int Channel = 0; Channel < Channels; Channel++) Pass[Channel] = In[Channel] + Start;
+            std::get<0>(Stage_).Process(Pass, std::min(BlockSize, Count - Start), Work[0]);
+            Buffer *From = &Work[0];
+            Buffer *To = &Work[1];
+            RunRange<1>(std::make_index_sequence<sizeof...(Stages) - 1>{}, From, To);
+            Append(*From, Out);
+        }
+        return Out;
+    }
+
+    // The stages of one pass run in separate calls, for a pipeline with each group of stages on its own thread.
+    // A stage is only ever touched by one of the calls, so the groups can run concurrently on successive passes.
+
+    // filter one pass of at most BlockSize input samples through the head and stages 1 to Last into Out
+    template<int Last>
+    void ProcessPass(const Input *const *In, int Count, Buffer &Out)
+    {
+        std::get<0>(Stage_).Process(In, Count, Out);
+        Buffer *From = &Out;
+        Buffer *To = &Work[0];
+        RunRange<1>(std::make_index_sequence<Last>{}, From, To);
+        if(From != &Out) Copy(*From, Out);
+    }
+
+    // filter one pass from In through stages First to Last into Out, In is overwritten
+    template<int First, int Last>
+    void ProcessPass(Buffer &In, Buffer &Out)
+    {
+        Buffer *From = &In;
+        Buffer *To = &Out;
+        RunRange<First>(std::make_index_sequence<Last - First + 1>{}, From, To);
+        if(From != &Out) Copy(*From, Out);
+    }
+
+    void Reset(void)
+    {
+        std::apply([](auto &... Each) { (Each.Reset(), ...); }, Stage_);
+    }
+
+private:
+    template<std::size_t First, std::size_t... N>
+    void RunRange(std::index_sequence<N...>, Buffer *&From, Buffer *&To)
+    {
+        (Run(std::get<First + N>(Stage_), From, To), ...);
+    }
+
+    template<typename S>
+    static void Run(S &Each, Buffer *&From, Buffer *&To)
+    {
+        if(!Each.Enabled) return;
+        Each.Process(*From, *To);
+        std::swap(From, To);
+    }
+
+    static void Append(const Buffer &From, Buffer &Out)
+    {
+        for(int Channel = 0; Channel < Channels; Channel++)
+        {
+            memcpy(&Out.I[Channel][Out.Count], From.I[Channel], From.Count * sizeof(typename Buffer::Sample));
+            memcpy(&Out.Q[Channel][Out.Count], From.Q[Channel], From.Count * sizeof(typename Buffer::Sample));
+        }
+        Out.Count += From.Count;
+    }
+
+    static void Copy(const Buffer &From, Buffer &Out)
+    {
+        Out.Count = 0;
+        Append(From, Out);
+    }
+
+    std::tuple<Stages...> Stage_;
+    Buffer Work[2];                             // pass work buffers
+    int BlockSize = 1;                          // input samples per pass
+};
+
+#endif // MULTIRATE_H
@@ -0,0 +1,252 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "spscqueue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+
+// Runs the passes of a filter chain through a line of threads, one per group of stages, so each group has a core
+// of its own instead of all of them sharing the DSP thread.
+//
+// The calling thread feeds the first queue (Claim a slot, fill it, Publish it). Each work stage takes a slot from
+// its input queue, processes it into a slot of its output queue and hands the input slot back; the sink takes
+// the slots from the last queue. All slots are allocated by Start(), nothing is allocated while running. A full
+// queue stalls the stage feeding it, so a slow stage holds the feeder back rather than letting work pile up.
+// Stop() closes the first queue, each stage passes the close on once it has drained its input, so every slot fed
+// in is processed before the threads are joined.
+//
+// The feeder and the stage threads are pinned to the first cores of the process affinity mask (taskset, cgroup
+// cpusets) when it has a core for each of them, on Linux only, elsewhere they are left to the scheduler.
+
+// utilisation of one pipeline stage over a reporting interval
+struct PipelineLoad
+{
+    const char *Name;
+    double Busy;             // fraction of the time spent processing
+    double Blocked;          // fraction of the time spent waiting on a full output queue
+};
+
+
+template<typename Buffer>
+class Pipeline
+{
+public:
+    typedef std::function<void(Buffer &In, Buffer &Out)> Work;   // one work stage, In may be used as scratch
+    typedef std::function<void(Buffer &In)> Sink;                // the last stage, consumes the pass
+
+    ~Pipeline()
+    {
+        Stop();
+    }
+
+    bool Running(void) const { return !Threads.empty(); }
+    bool Pinned(void) const { return PinnedCores; }
+
+    // start a thread for each work stage and for the sink, with queues of Depth slots (a power of 2) between them
+    // holding Capacity samples per channel. Names has one entry for the feeder, each work stage and the sink.
+    void Start(const std::vector<Work> &Stages, Sink Last, const std::vector<const char *> &Names, int Depth, int Capacity)
+    {
+        Stop();
+
+        int Count = (int)Stages.size();
+        for(int Index = 0; Index <= Count; Index++)
+        {
+            SPSCQueue<Buffer> *Queue = new SPSCQueue<Buffer>(Depth);
+            for(int Slot = 0; Slot < Depth; Slot++) Queue->Slot(Slot).Allocate(Capacity);
+            Queues.push_back(Queue);
+        }
+
+        Loads.assign(Count + 2, PipelineLoad());
+        for(int Index = 0; Index < Count + 2; Index++) Loads[Index].Name = Names[Index];
+        Busy = std::vector<std::atomic<long long>>(Count + 2);
+        Reported.assign(Count + 2, 0);
+        Sampled.assign(Count + 2, 0);
+        ReportedBlocked.assign(Count + 2, 0);
+        ReportedAt = std::chrono::steady_clock::now();
+
+        // pin only when every thread can have a core of its own among those the process may use
+        Cores = AllowedCores();
+        PinnedCores = ((int)Cores.size() >= Count + 2);
+        if(PinnedCores) PinFeeder();
+
+        for(int Index = 0; Index < Count; Index++)
+        {
+            Threads.emplace_back([this, Index, Stage = Stages[Index]]
+            {
+                if(PinnedCores) PinTo(Cores[Index + 1]);
+                SPSCQueue<Buffer> &In = *Queues[Index];
+                SPSCQueue<Buffer> &Out = *Queues[Index + 1];
+                Buffer *Next;
+                while((Next = In.Front()) != nullptr)
+                {
+                    Buffer *Slot = Out.Claim();
+                    auto Begin = std::chrono::steady_clock::now();
+                    Stage(*Next, *Slot);
+                    Busy[Index + 1].fetch_add(Elapsed(Begin), std::memory_order_relaxed);
+                    Out.Publish();
+                    In.Pop();
+                }
+                Out.Close();
+            });
+        }
+
+        Threads.emplace_back([this, Count, Last]
+        {
+            if(PinnedCores) PinTo(Cores[Count + 1]);
+            SPSCQueue<Buffer> &In = *Queues[Count];
+            Buffer *Next;
+            while((Next = In.Front()) != nullptr)
+            {
+                auto Begin = std::chrono::steady_clock::now();
+                Last(*Next);
+                Busy[Count + 1].fetch_add(Elapsed(Begin), std::memory_order_relaxed);
+                In.Pop();
+            }
+        });
+    }
+
+    // let every slot fed in drain through, then join the threads and free the queues
+    void Stop(void)
+    {
+        if(!Running()) return;
+
+        Queues[0]->Close();
+        for(std::thread &Each : Threads) Each.join();
+        Threads.clear();
+        for(SPSCQueue<Buffer> *Queue : Queues) delete Queue;
+        Queues.clear();
+        if(PinnedCores) UnpinFeeder();
+    }
+
+    // ---- Feeder side (the thread that called Start) ---- //
+
+    // next free slot of the first queue, waiting while the stages are behind
+    Buffer *Claim(void)
+    {
+        Buffer *Slot = Queues[0]->Claim();
+        FeedStart = std::chrono::steady_clock::now();
+        return Slot;
+    }
+
+    // pass the claimed slot on to the first work stage
+    void Publish(void)
+    {
+        Busy[0].fetch_add(Elapsed(FeedStart), std::memory_order_relaxed);
+        Queues[0]->Publish();
+    }
+
+    // processing time (S) of the busiest of the feeder, stages and sink since the last call, the pipeline's load:
+    // the stages run at once, so the slowest one sets how much input the pipeline keeps up with
+    double Slowest(void)
+    {
+        long long Largest = 0;
+        for(int Index = 0; Index < (int)Busy.size(); Index++)
+        {
+            long long Total = Busy[Index].load(std::memory_order_relaxed);
+            Largest = std::max(Largest, Total - Sampled[Index]);
+            Sampled[Index] = Total;
+        }
+        return Largest * 1e-9;
+    }
+
+    // per stage utilisation since the last call, feeder first and sink last
+    const std::vector<PipelineLoad> &Load(void)
+    {
+        auto Now = std::chrono::steady_clock::now();
+        double Interval = std::chrono::duration<double, std::nano>(Now - ReportedAt).count();
+        ReportedAt = Now;
+
+        for(int Index = 0; Index < (int)Loads.size(); Index++)
+        {
+            long long Total = Busy[Index].load(std::memory_order_relaxed);
+            long long Blocked = (Index < (int)Queues.size()) ? Queues[Index]->Blocked() : 0;
+            Loads[Index].Busy = (Total - Reported[Index]) / Interval;
+            Loads[Index].Blocked = (Blocked - ReportedBlocked[Index]) / Interval;
+            Reported[Index] = Total;
+            ReportedBlocked[Index] = Blocked;
+        }
+        return Loads;
+    }
+
+private:
+    static long long Elapsed(std::chrono::steady_clock::time_point Begin)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Begin).count();
+    }
+
+#if defined(__linux__)
+    static std::vector<int> AllowedCores(void)
+    {
+        std::vector<int> Allowed;
+        cpu_set_t Set;
+        CPU_ZERO(&Set);
+        if(sched_getaffinity(0, sizeof(Set), &Set) != 0) return Allowed;
+        for(int Core = 0; Core < CPU_SETSIZE; Core++) if(CPU_ISSET(Core, &Set)) Allowed.push_back(Core);
+        return Allowed;
+    }
+
+    static void PinTo(int Core)
+    {
+        cpu_set_t Set;
+        CPU_ZERO(&Set);
+        CPU_SET(Core, &Set);
+        pthread_setaffinity_np(pthread_self(), sizeof(Set), &Set);
+    }
+
+    void PinFeeder(void)
+    {
+        pthread_getaffinity_np(pthread_self(), sizeof(FeederSet), &FeederSet);
+        PinTo(Cores[0]);
+    }
+
+    void UnpinFeeder(void)
+    {
+        pthread_setaffinity_np(pthread_self(), sizeof(FeederSet), &FeederSet);
+    }
+
+    cpu_set_t FeederSet;                         // feeder affinity before Start
+#else
+    static std::vector<int> AllowedCores(void) { return std::vector<int>(); }
+    static void PinTo(int) {}
+    void PinFeeder(void) {}
+    void UnpinFeeder(void) {}
+#endif
+
+    std::vector<SPSCQueue<Buffer> *> Queues;     // queue N feeds work stage N, the last one feeds the sink
+    std::vector<std::thread> Threads;            // work stages then the sink
+    std::vector<int> Cores;                      // cores the process may use, feeder, stages and sink pinned to the first
+    bool PinnedCores = false;                    // threads pinned to their own cores
+
+    std::chrono::steady_clock::time_point FeedStart;    // feeder slot claimed
+    std::vector<std::atomic<long long>> Busy;    // time spent processing by feeder, stages and sink (nS)
+    std::vector<long long> Reported;             // Busy at the last Load()
+    std::vector<long long> Sampled;              // Busy at the last Slowest()
+    std::vector<long long> ReportedBlocked;      // queue Blocked() at the last Load()
+    std::chrono::steady_clock::time_point ReportedAt;   // time of the last Load()
+    std::vector<PipelineLoad> Loads;
+};
+
+#endif // PIPELINE_H
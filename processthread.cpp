@@ -31,16 +31,17 @@ ProcessThread::ProcessThread(QObject *parent) : QObject(parent)
 
     // connect Signals and Slots
     connect(P_Timer, SIGNAL(timeout()), this, SLOT(on_Timer()));
-    connect(this, SIGNAL(StartDSP_A()),P_DSPthread, SLOT(ProcessBufferA()));
-    connect(this, SIGNAL(StartDSP_AB()),P_DSPthread, SLOT(ProcessBufferAB()));
+    connect(this, SIGNAL(StartDSP()),P_DSPthread, SLOT(Run()));
     connect(P_DSPthread, SIGNAL(StatusMessage(QString)), this, SLOT(SendStatusMessage(QString)));
-    connect(this, SIGNAL(GenSinCosTable(double,double)), P_DSPthread, SLOT(GenerateSinCosTable(double,double)));
+    connect(P_DSPthread, SIGNAL(InputStats(BlockStats,BlockStats)), this, SLOT(SendInputStats(BlockStats,BlockStats)));
 }
 
 
 ProcessThread::~ProcessThread()
 {
-    // stop ProcessThreads
+    // stop ProcessThreads, leaving the DSP Run() loop first
+    P_DSPthread->DSPMode = 0;
+    P_DSPthread->DataReady.Notify();
     WorkerThread.quit();
     WorkerThread.wait();
 }
@@ -59,10 +60,16 @@ void ProcessThread::SendStatusMessage(QString Message)
 }
 
 
+void ProcessThread::SendInputStats(BlockStats A, BlockStats B)
+{
+    emit InputStats(A, B);
+}
+
+
 void ProcessThread::GenerateSinCosTable(double Aphase, double Bphase)
 {
-    // send command to DSP thread to recalculate LO phase
-    emit GenSinCosTable(Aphase, Bphase);
+    // hand the new LO phases to the DSP thread, which recalculates its tables between frames
+    P_DSPthread->SetPhases(Aphase, Bphase);
 }
 
 
@@ -77,7 +84,9 @@ void ProcessThread::Start(void)
      else AudioOutputBufferSize = 76800;
 
      // Timer used for Dual O/P (IP) and also for Audio Output to supplement the Notify signal
-     P_Timer->start(40); // 40mS
+     // runs at the input block period (40mS for the default block size) so small blocks reach the output promptly
+     int BlockPeriod = (BlockSize * 1000) / INPUT_SAMPLE_RATE;  // mS
+     P_Timer->start(qBound(2, BlockPeriod, 40));
 
 
      // Open UDP Socket for UDP Output Modes
@@ -178,21 +187,23 @@ void ProcessThread::Start(void)
         int BytesWritten = P_OutputBuffer_A->write(TempBuffer); // write bytes to output device buffer
      }
 
-     // take copy of current input buffer
-     P_DSPthread->PreviousLastBuffer = A_LastBuffer;
-
-     P_DSPthread->Finished = 1; // set false finish to kick start processing
-
      //Set DSP Mode and start DSP processing
      P_DSPthread->SampleRate = SampleRate;                 // copy sample rate
      P_DSPthread->DuplicateA = DuplicateA;                 // copy duplicate flag
      P_DSPthread->TIMF2Output = TIMF2Output;               // copy TIMF2Output flag
      P_DSPthread->RAW16Output = RAW16Output;               // copy RAW16Output flag
      P_DSPthread->SoundCardOutput = SoundCardOutput;       // copy Sound Card output flag
+     P_DSPthread->Assembler->Policy = (OverrunPolicy)Overrun;  // copy input overrun recovery
+     P_DSPthread->Pipelined = Pipelined;                   // copy pipelined DSP selection
+     P_DSPthread->FrontEnd = FrontEnd;                     // copy front end selection
+     P_DSPthread->FixedPoint = FixedPoint;                 // copy fixed point chain selection
+     P_DSPthread->StageFilters = StageFilters;             // copy stage filter designs
 
      // Start Processing                                   // Remove DSPMode 0 (Stop)
      if(DualOP == 0) P_DSPthread->DSPMode = 1;             // Start Processing Channel A only
      if(DualOP == 1) P_DSPthread->DSPMode = 2;             // Satrt processing Channel A & B
+     P_DSPthread->RunQueued();                             // counted for Stop to wait on
+     emit StartDSP();                                      // DSP thread runs until DSPMode returns to 0
 
 }
 
@@ -232,19 +243,19 @@ int datagrams = 0;
         {
             if(SelectB == 1) // Output Channel B
             {
-                OutInt16 = (qint16) P_DSPthread->I_CircularOutputBufferSCB[AFOutPoint]; // I channel float to 16 bit integer
+                OutInt16 = (qint16) P_DSPthread->I_CircularOutputBufferSCB[AFOutPoint]; // I channel 16 bit integer
                 IOutLow = OutInt16 & 0x00ff;
                 IOutHigh = OutInt16 >> 8;
-                OutInt16 = (qint16) P_DSPthread->Q_CircularOutputBufferSCB[AFOutPoint]; // Q channel float to 16 bit integer
+                OutInt16 = (qint16) P_DSPthread->Q_CircularOutputBufferSCB[AFOutPoint]; // Q channel 16 bit integer
                 QOutLow = OutInt16 & 0x00ff;
                 QOutHigh = OutInt16 >> 8;
             }
             else  // Output Channel A
             {
-                OutInt16 = (qint16) P_DSPthread->I_CircularOutputBufferSCA[AFOutPoint]; // I channel float to 16 bit integer
+                OutInt16 = (qint16) P_DSPthread->I_CircularOutputBufferSCA[AFOutPoint]; // I channel 16 bit integer
                 IOutLow = OutInt16 & 0x00ff;
                 IOutHigh = OutInt16 >> 8;
-                OutInt16 = (qint16) P_DSPthread->Q_CircularOutputBufferSCA[AFOutPoint]; // Q channel float to 16 bit integer
+                OutInt16 = (qint16) P_DSPthread->Q_CircularOutputBufferSCA[AFOutPoint]; // Q channel 16 bit integer
                 QOutLow = OutInt16 & 0x00ff;
                 QOutHigh = OutInt16 >> 8;
             }
@@ -287,20 +298,20 @@ int datagrams = 0;
 
         {
             // For Channel A
-            OutInt16 = (qint16) P_DSPthread->I_CircularOutputBufferSCA[AFOutPoint]; // I channel float to 16 bit integer
+            OutInt16 = (qint16) P_DSPthread->I_CircularOutputBufferSCA[AFOutPoint]; // I channel 16 bit integer
             IOutLow = OutInt16 & 0x00ff;
             IOutHigh = OutInt16 >> 8;
-            OutInt16 = (qint16) P_DSPthread->Q_CircularOutputBufferSCA[AFOutPoint]; // Q channel float to 16 bit integer
+            OutInt16 = (qint16) P_DSPthread->Q_CircularOutputBufferSCA[AFOutPoint]; // Q channel 16 bit integer
             QOutLow = OutInt16 & 0x00ff;
             QOutHigh = OutInt16 >> 8;
             TempBuffer.append(IOutLow); TempBuffer.append(IOutHigh);    // append I/Q data bytes to output
             TempBuffer.append(QOutLow); TempBuffer.append(QOutHigh);
 
             // For Channel B
-            OutInt16 = (qint16) P_DSPthread->I_CircularOutputBufferSCB[AFOutPoint]; // I channel float to 16 bit integer
+            OutInt16 = (qint16) P_DSPthread->I_CircularOutputBufferSCB[AFOutPoint]; // I channel 16 bit integer
             IOutLow = OutInt16 & 0x00ff;
             IOutHigh = OutInt16 >> 8;
-            OutInt16 = (qint16) P_DSPthread->Q_CircularOutputBufferSCB[AFOutPoint]; // Q channel float to 16 bit integer
+            OutInt16 = (qint16) P_DSPthread->Q_CircularOutputBufferSCB[AFOutPoint]; // Q channel 16 bit integer
             QOutLow = OutInt16 & 0x00ff;
             QOutHigh = OutInt16 >> 8;
             TempBuffer.append(IOutLow); TempBuffer.append(IOutHigh);    // append I/Q data bytes to output
@@ -361,13 +372,13 @@ int datagrams = 0;
 
             for(int loop = 0; loop < (PayloadSamples); loop++)
             {
-                // send dual channel data, convert double to float
-                floatUnion.f = (float)P_DSPthread->I_CircularOutputBufferA[IPOutPoint];
+                // send dual channel data as float, from the int16 buffers of the fixed point chain
+                floatUnion.f = P_DSPthread->FixedPoint ? P_DSPthread->I_CircularOutputBufferA16[IPOutPoint] : P_DSPthread->I_CircularOutputBufferA[IPOutPoint];
                 TempBuffer.append(floatUnion.bytes[0]);
                 TempBuffer.append(floatUnion.bytes[1]);
                 TempBuffer.append(floatUnion.bytes[2]);
                 TempBuffer.append(floatUnion.bytes[3]);
-                floatUnion.f = (float)P_DSPthread->Q_CircularOutputBufferA[IPOutPoint];
+                floatUnion.f = P_DSPthread->FixedPoint ? P_DSPthread->Q_CircularOutputBufferA16[IPOutPoint] : P_DSPthread->Q_CircularOutputBufferA[IPOutPoint];
                 TempBuffer.append(floatUnion.bytes[0]);
                 TempBuffer.append(floatUnion.bytes[1]);
                 TempBuffer.append(floatUnion.bytes[2]);
@@ -375,12 +386,12 @@ int datagrams = 0;
 
                 if(DualOP == 1)  // send channel B only in dual output mode
                 {
-                    floatUnion.f = (float)P_DSPthread->I_CircularOutputBufferB[IPOutPoint];
+                    floatUnion.f = P_DSPthread->FixedPoint ? P_DSPthread->I_CircularOutputBufferB16[IPOutPoint] : P_DSPthread->I_CircularOutputBufferB[IPOutPoint];
                     TempBuffer.append(floatUnion.bytes[0]);
                     TempBuffer.append(floatUnion.bytes[1]);
                     TempBuffer.append(floatUnion.bytes[2]);
                     TempBuffer.append(floatUnion.bytes[3]);
-                    floatUnion.f = (float)P_DSPthread->Q_CircularOutputBufferB[IPOutPoint];
+                    floatUnion.f = P_DSPthread->FixedPoint ? P_DSPthread->Q_CircularOutputBufferB16[IPOutPoint] : P_DSPthread->Q_CircularOutputBufferB[IPOutPoint];
                     TempBuffer.append(floatUnion.bytes[0]);
                     TempBuffer.append(floatUnion.bytes[1]);
                     TempBuffer.append(floatUnion.bytes[2]);
@@ -456,7 +467,7 @@ int datagrams = 0;
 
             for(int loop = 0; loop < (PAYLOAD/8); loop++)  // Note: 8 output bytes per sample for RAW16
             {
-                // send dual channel soundcard data, convert double to 16bit integer
+                // send dual channel soundcard data, 16bit integer
                 intUnion.i32 = (qint32) P_DSPthread->I_CircularOutputBufferSCA[AFOutPoint];
                 TempBuffer.append(intUnion.bytes[0]);
                 TempBuffer.append(intUnion.bytes[1]);
@@ -597,7 +608,7 @@ void ProcessThread::Stop(void)
 {
      P_Timer->stop();
 
-     P_DSPthread->DSPMode = 0; // stop processing
+     P_DSPthread->WaitStopped(); // stop processing, returns once Run() has left the input rings and chains
 
      // stop and delete audio channel A if open
      if(P_AudioDevice_A != nullptr)
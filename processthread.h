@@ -13,7 +13,7 @@
 #ifndef PROCESSTHREAD_H
 #define PROCESSTHREAD_H
 
-#include "rspduointerface.h"
+#include "samplesource.h"
 #include "dspthread.h"
 #include <bits/stdc++.h> //for timimg
 
@@ -31,12 +31,6 @@
 
 #define Linrad_Block_Size  4096        // Size of Linrad Buffer as sent in RAW16 Mode Request
 
-extern volatile int A_LastBuffer;      // Last Input Buffer number for channel A
-extern volatile int B_LastBuffer;      // Last Input Buffer number for channel B
-
-extern short (*A_InputBuffer)[INPUT_BUFFER_SIZE];  // pointer to channel A input array [BufferNo][Buffer]
-extern short (*B_InputBuffer)[INPUT_BUFFER_SIZE];  // pointer to channel B input array [BufferNo][Buffer]
-
 
 class ProcessThread : public QObject
 {
@@ -47,6 +41,12 @@ public:
                                         // Copy of variables from MainWindow
     QString SelectedOutputDevice_A;     // the selected audio output device for channel A
     int SampleRate = 96000;             // selected sample rate, default to 96000
+    int BlockSize = INPUT_BUFFER_SIZE;  // input block size (samples) set by SetInputBlockSize
+    int Overrun = SkipToNewest;         // input overrun recovery, SkipToNewest or ResyncBoth
+    int Pipelined = 0;                  // DSP filter stages on a pipeline of threads = 1, single thread = 0
+    int FrontEnd = 0;                   // first decimation, D2A/D2B FIR = 0, CIC = 1
+    int FixedPoint = 0;                 // filter chain arithmetic, float = 0, fixed point = 1
+    QString StageFilters;               // designs for the D2B, D5, US6 and US4 stages, empty for filters.h
     int DualOP = 0;                     // current Dual O/P mode
     int DuplicateA = 0;                 // duplicate channel A in channel B if = 1
     int TIMF2Output = 0;                // Linrad TIMF2 UDP Output = 1, else 0
@@ -61,15 +61,15 @@ public:
 signals:
 
     void StatusMessage(QString);
-    void StartDSP_A(void);
-    void StartDSP_AB(void);
-    void GenSinCosTable(double, double);
+    void InputStats(BlockStats, BlockStats);
+    void StartDSP(void);
 
 public slots:
 
      void Start(void);
      void Stop(void);
      void SendStatusMessage(QString);
+     void SendInputStats(BlockStats, BlockStats);
      void GenerateSinCosTable(double, double);
 
 private:
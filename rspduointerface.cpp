@@ -56,11 +56,10 @@
 
 #include "rspduointerface.h"
 #include "sdrplay_api.h"
-#include "windows.h"
 
 #include <QDebug>
 #include <QString>
-#include <QList>
+#include <QThread>
 
 
 
@@ -80,48 +79,16 @@ int masterInitialised = 0;
 int slaveUninitialised = 0;
 
 
-int Buffers = BUFFERS;
-int InputBufferSize = INPUT_BUFFER_SIZE;
-
-short (*B_InputBuffer)[INPUT_BUFFER_SIZE];      // for input buffer array pointers [BUFFERS][INPUT_BUFFER_SIZE]
-short (*A_InputBuffer)[INPUT_BUFFER_SIZE];      // array is allocated with 'new' command in RSPduoInterface
-
-int A_LastBuffer;                               // index to last updated input buffers
-int B_LastBuffer;
-
-QList<QString> MessageList;                     // Qlist to store messages for ststus display
-int OverloadFlag = 0;                           // RSPduo Overload condition = 1, else 0
+EventQueue SourceEvents;                        // API events for the status display, formatted by on_Timeout
 
 // Callback functions outside of any class
 
 void StreamACallback(short *xi, short *xq, sdrplay_api_StreamCbParamsT *params, unsigned int numSamples, unsigned int reset, void *cbContext)
 {
-    QString MessageString;
-
-    if (reset)
-    {
-        //MessageString = QString::asprintf("StreamACallback: numSamples=%d", numSamples);
-        //qDebug() << MessageString;
-        //MessageList.append(MessageString); // send to Status Display
-    }
     // Process stream callback data here
 
-    static int CurrentIndex = 0;  // current index into Buffer
-    static int BufferNo = 0;      // current Buffer
-
-    for(int loop = 0; loop < numSamples; loop++)
-    {
-        A_InputBuffer[BufferNo][CurrentIndex] = xi[loop];
-        CurrentIndex++;
-        if(CurrentIndex >= INPUT_BUFFER_SIZE)
-        {
-            CurrentIndex = 0;  // when current buffer is full, start another.
-            A_LastBuffer = BufferNo;
-            BufferNo++;
-            if(BufferNo >= BUFFERS) BufferNo = 0;
-        }
-
-    }
+    // copy into ring stamped with the sample number, completed blocks are published to the DSP thread
+    A_InputRing.Write(xi, numSamples, params->firstSampleNum);
 
     return;
 
@@ -130,32 +97,10 @@ void StreamACallback(short *xi, short *xq, sdrplay_api_StreamCbParamsT *params,
 
 void StreamBCallback(short *xi, short *xq, sdrplay_api_StreamCbParamsT *params, unsigned int numSamples, unsigned int reset, void *cbContext)
 {
-    QString MessageString;
-
-    if (reset)
-    {
-       //MessageString = QString::asprintf("StreamBCallback: numSamples=%d", numSamples);
-       //qDebug() << MessageString;
-       //MessageList.append(MessageString); // send to Status Display
-    }
     //     Process stream callback data here - this callback will only be used in dual tuner mode
 
-    static int CurrentIndex = 0;  // current index into Buffer
-    static int BufferNo = 0;      // current Buffer
-
-    for(int loop = 0; loop < numSamples; loop++)
-    {
-        B_InputBuffer[BufferNo][CurrentIndex] = xi[loop];
-        CurrentIndex++;
-        if(CurrentIndex >= INPUT_BUFFER_SIZE)
-        {
-            CurrentIndex = 0;  // when current buffer is full, start another.
-            B_LastBuffer = BufferNo;
-            BufferNo++;
-            if(BufferNo >= BUFFERS) BufferNo = 0;
-        }
-
-    }
+    // copy into ring stamped with the sample number, completed blocks are published to the DSP thread
+    B_InputRing.Write(xi, numSamples, params->firstSampleNum);
 
     return;
 }
@@ -163,24 +108,22 @@ void StreamBCallback(short *xi, short *xq, sdrplay_api_StreamCbParamsT *params,
 
 void EventCallback(sdrplay_api_EventT eventId, sdrplay_api_TunerSelectT tuner, sdrplay_api_EventParamsT *params, void *cbContext)
 {
-    QString MessageString;
+    // only record the event here, it is formatted for display by RSPduoInterface::on_Timeout on the GUI thread
+    SourceEvent Event {};
+    Event.Tuner = (tuner == sdrplay_api_Tuner_A) ? 'A' : 'B';
 
     switch (eventId)
     {
     case sdrplay_api_GainChange:
-            MessageString = QString::asprintf("GainChange: tuner=%s gRdB=%d lnaGRdB=%d systemGain=%.2f",
-                                    (tuner == sdrplay_api_Tuner_A) ? "A" : "B", params->gainParams.gRdB,
-                                               params->gainParams.lnaGRdB, params->gainParams.currGain);
-           qDebug() << MessageString;
-           MessageList.append(MessageString); // send to Status Display
+            Event.Type = SourceEvent::GainChange;
+            Event.gRdB = params->gainParams.gRdB;
+            Event.lnaGRdB = params->gainParams.lnaGRdB;
+            Event.SystemGain = params->gainParams.currGain;
+            break;
 
-        break;
     case sdrplay_api_PowerOverloadChange:
-            MessageString = QString::asprintf("PowerOverloadChange: %s %s",(tuner == sdrplay_api_Tuner_A) ?
-                             "Tuner_A" : "Tuner_B", (params->powerOverloadParams.powerOverloadChangeType ==
-                                sdrplay_api_Overload_Detected) ? "Overload_Detected" :"Overload_Corrected");
-
-            qDebug() << MessageString;
+            Event.Type = SourceEvent::Overload;
+            Event.Code = params->powerOverloadParams.powerOverloadChangeType;
 
             // set or reset Overload flag for Mainwindow display
             if(params->powerOverloadParams.powerOverloadChangeType == sdrplay_api_Overload_Detected) OverloadFlag = 1;
@@ -192,26 +135,8 @@ void EventCallback(sdrplay_api_EventT eventId, sdrplay_api_TunerSelectT tuner, s
             break;
 
     case sdrplay_api_RspDuoModeChange:
-            MessageString = QString::asprintf("sdrplay_api_EventCb: %s, tuner=%s modeChangeType=%s",
-            "RspDuoModeChange", (tuner == sdrplay_api_Tuner_A) ?
-            "Tuner_A" : "Tuner_B",
-            (params->rspDuoModeParams.modeChangeType == sdrplay_api_MasterInitialised) ?
-            "MasterInitialised" :
-            (params->rspDuoModeParams.modeChangeType == sdrplay_api_SlaveAttached) ?
-            "SlaveAttached" :
-            (params->rspDuoModeParams.modeChangeType == sdrplay_api_SlaveDetached) ?
-            "SlaveDetached" :
-            (params->rspDuoModeParams.modeChangeType == sdrplay_api_SlaveInitialised) ?
-            "SlaveInitialised" :
-            (params->rspDuoModeParams.modeChangeType == sdrplay_api_SlaveUninitialised) ?
-            "SlaveUninitialised" :
-            (params->rspDuoModeParams.modeChangeType == sdrplay_api_MasterDllDisappeared) ?
-            "MasterDllDisappeared" :
-            (params->rspDuoModeParams.modeChangeType == sdrplay_api_SlaveDllDisappeared) ?
-            "SlaveDllDisappeared" : "unknown type");
-
-            qDebug() << MessageString;
-            MessageList.append(MessageString); // send to Status Display
+            Event.Type = SourceEvent::ModeChange;
+            Event.Code = params->rspDuoModeParams.modeChangeType;
 
             if (params->rspDuoModeParams.modeChangeType == sdrplay_api_MasterInitialised)
                 masterInitialised = 1;
@@ -220,17 +145,16 @@ void EventCallback(sdrplay_api_EventT eventId, sdrplay_api_TunerSelectT tuner, s
             break;
 
     case sdrplay_api_DeviceRemoved:
-           MessageString = QString::asprintf("sdrplay_api_EventCb: %s", "sdrplay_api_DeviceRemoved");
-           qDebug() << MessageString;
-           MessageList.append(MessageString); // send to Status Display
+           Event.Type = SourceEvent::DeviceRemoved;
            break;
 
     default:
-           MessageString = QString::asprintf("sdrplay_api_EventCb: %d, unknown event", eventId);
-           qDebug() << MessageString;
-           MessageList.append(MessageString); // send to Status Display
+           Event.Type = SourceEvent::Unknown;
+           Event.Code = eventId;
            break;
     }
+
+    SourceEvents.Push(Event);
 }
 
 
@@ -239,12 +163,9 @@ void EventCallback(sdrplay_api_EventT eventId, sdrplay_api_TunerSelectT tuner, s
 // RSPduoInterface class definitions below:
 
 
-RSPduoInterface::RSPduoInterface(QWidget *parent) : QWidget(parent)
+RSPduoInterface::RSPduoInterface(QObject *parent) : SampleSource(parent)
 {
 
-        A_InputBuffer = new short[BUFFERS][INPUT_BUFFER_SIZE];   // allocate Input Buffer arrays
-        B_InputBuffer = new short[BUFFERS][INPUT_BUFFER_SIZE];
-
         Timer = new QTimer;
         connect(Timer, SIGNAL(timeout()), this, SLOT(on_Timeout(void)));
         Timer->start(100); // 100mS
@@ -252,18 +173,65 @@ RSPduoInterface::RSPduoInterface(QWidget *parent) : QWidget(parent)
 
 RSPduoInterface::~RSPduoInterface()
 {
-    delete A_InputBuffer;
-    delete B_InputBuffer;
     Timer->stop();
     delete Timer;
 }
 
 void RSPduoInterface::on_Timeout(void)
 {
-    // loop to output any status messages held in MessageList
-    while(!MessageList.isEmpty())
+    // format and output any events queued by EventCallback
+    SourceEvent Event;
+    while(SourceEvents.Pop(Event))
+    {
+        QString MessageString = FormatEvent(Event);
+        qDebug() << MessageString;
+        if(Event.Type != SourceEvent::Overload) emit Status(MessageString); // send to Status Display
+    }
+
+    unsigned int Dropped = SourceEvents.DroppedCount();
+    if(Dropped != ReportedDropped)
     {
-        emit Status(MessageList.takeFirst());
+        emit Status(QString::asprintf("sdrplay_api_EventCb: %u events lost, queue full", Dropped - ReportedDropped));
+        ReportedDropped = Dropped;
+    }
+}
+
+
+QString RSPduoInterface::FormatEvent(const SourceEvent &Event)
+{
+    switch (Event.Type)
+    {
+    case SourceEvent::GainChange:
+            return QString::asprintf("GainChange: tuner=%c gRdB=%d lnaGRdB=%d systemGain=%.2f",
+                                     Event.Tuner, Event.gRdB, Event.lnaGRdB, Event.SystemGain);
+
+    case SourceEvent::Overload:
+            return QString::asprintf("PowerOverloadChange: Tuner_%c %s", Event.Tuner,
+                                     (Event.Code == sdrplay_api_Overload_Detected) ? "Overload_Detected" : "Overload_Corrected");
+
+    case SourceEvent::ModeChange:
+            return QString::asprintf("sdrplay_api_EventCb: %s, tuner=Tuner_%c modeChangeType=%s",
+            "RspDuoModeChange", Event.Tuner,
+            (Event.Code == sdrplay_api_MasterInitialised) ?
+            "MasterInitialised" :
+            (Event.Code == sdrplay_api_SlaveAttached) ?
+            "SlaveAttached" :
+            (Event.Code == sdrplay_api_SlaveDetached) ?
+            "SlaveDetached" :
+            (Event.Code == sdrplay_api_SlaveInitialised) ?
+            "SlaveInitialised" :
+            (Event.Code == sdrplay_api_SlaveUninitialised) ?
+            "SlaveUninitialised" :
+            (Event.Code == sdrplay_api_MasterDllDisappeared) ?
+            "MasterDllDisappeared" :
+            (Event.Code == sdrplay_api_SlaveDllDisappeared) ?
+            "SlaveDllDisappeared" : "unknown type");
+
+    case SourceEvent::DeviceRemoved:
+            return QString::asprintf("sdrplay_api_EventCb: %s", "sdrplay_api_DeviceRemoved");
+
+    default:
+            return QString::asprintf("sdrplay_api_EventCb: %d, unknown event", Event.Code);
     }
 }
 
@@ -517,7 +485,7 @@ void RSPduoInterface::Start(int LOfrequeccy, int gRdB_Gain_A, int gRdB_Gain_B,in
                 {
                     while (1)
                     {
-                        Sleep(1000);
+                        QThread::msleep(1000);
                         if (masterInitialised) // Keep polling flag set in event callback until the master is initialised
                         {
                             // Redo call - should succeed this time
@@ -587,7 +555,7 @@ void RSPduoInterface::Stop(void)
             // We’re stopping in master/slave mode as a master and the slave is still running
             while (1)
             {
-                Sleep(1000);
+                QThread::msleep(1000);
                 if (slaveUninitialised)
                 {
                     // Keep polling flag set in event callback until the slave is uninitialised
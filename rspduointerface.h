@@ -13,31 +13,24 @@
 #ifndef RSPDUOINTERFACE_H
 #define RSPDUOINTERFACE_H
 
-#include <QWidget>
-#include <QTimer>
-
+#include "samplesource.h"
+#include "eventqueue.h"
 
-#define BUFFERS 10                          // Number of input buffers.
-#define INPUT_BUFFER_SIZE 80000             // Size of each input buffer, which should equal block processing
-                                            // size for 40mS at 2MHz input rate. (0.04 * 2000000 = 80000)
+#include <QTimer>
 
 
-class RSPduoInterface : public QWidget
+class RSPduoInterface : public SampleSource
 {
     Q_OBJECT
 public:
-    explicit RSPduoInterface(QWidget *parent = nullptr);
+    explicit RSPduoInterface(QObject *parent = nullptr);
     ~RSPduoInterface();
 
-    void Start(int LOfrequency, int gRdb_Gain_A, int gRdb_Gain_B, int LNAstate);
-    void Stop (void);
-    void ChangeIFGainA(int gRdB_Gain);
-    void ChangeIFGainB(int gRdb_GainA, int gRdb_GainB);
-    void ChangeLNAGain(int LNAstate, int gRdb_GainA, int gRdb_GainB);
-
-signals:
-
-    Status(QString);
+    void Start(int LOfrequency, int gRdb_Gain_A, int gRdb_Gain_B, int LNAstate) override;
+    void Stop (void) override;
+    void ChangeIFGainA(int gRdB_Gain) override;
+    void ChangeIFGainB(int gRdb_GainA, int gRdb_GainB) override;
+    void ChangeLNAGain(int LNAstate, int gRdb_GainA, int gRdb_GainB) override;
 
 private slots:
 
@@ -46,6 +39,9 @@ private slots:
 private:
 
     QTimer *Timer;
+    unsigned int ReportedDropped = 0;     // queue overflow count at last report
+
+    static QString FormatEvent(const SourceEvent &Event);
 
 };
 
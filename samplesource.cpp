@@ -0,0 +1,32 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+#include "samplesource.h"
+
+
+InputRing A_InputRing(INPUT_BUFFER_SIZE, BUFFERS);   // channel A input blocks, written by the active sample source
+InputRing B_InputRing(INPUT_BUFFER_SIZE, BUFFERS);   // channel B input blocks, written by the active sample source
+
+int OverloadFlag = 0;                                // Source Overload condition = 1, else 0
+
+
+int SetInputBlockSize(int Samples)
+{
+    if(Samples < MIN_INPUT_BLOCK_SIZE) Samples = MIN_INPUT_BLOCK_SIZE;
+    if(Samples > INPUT_BUFFER_SIZE) Samples = INPUT_BUFFER_SIZE;
+    Samples -= Samples % INPUT_BLOCK_STEP;
+
+    int Count = (BUFFERS * INPUT_BUFFER_SIZE) / Samples;   // same total ring length (400mS) at any block size
+    A_InputRing.Resize(Samples, Count);
+    B_InputRing.Resize(Samples, Count);
+    return Samples;
+}
@@ -0,0 +1,71 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef SAMPLESOURCE_H
+#define SAMPLESOURCE_H
+
+#include "inputring.h"
+
+#include <QObject>
+#include <QString>
+
+
+#define BUFFERS 10                          // Number of input buffers at the largest block size.
+#define INPUT_BUFFER_SIZE 80000             // Largest (and default) input block, the block processing size for
+                                            // 40mS at 2MHz input rate. (0.04 * 2000000 = 80000)
+#define MIN_INPUT_BLOCK_SIZE 200            // Smallest input block for low latency streaming (0.1mS)
+#define INPUT_BLOCK_STEP 40                 // Block sizes are a multiple of the 40 sample tuner oscillator period
+#define INPUT_SAMPLE_RATE 2000000           // Real IF input sample rate of both channels (450KHz IF)
+#define FILTER_BLOCK_SIZE 4000              // Input samples per pass through the DSP filter chain, sized so the
+                                            // intermediate buffers of every stage stay in L1/L2 cache
+#define PIPELINE_DEPTH 8                    // Filter passes queued between the stages of the pipelined DSP (a power of 2)
+
+extern InputRing A_InputRing;               // channel A input block ring
+extern InputRing B_InputRing;               // channel B input block ring
+extern int OverloadFlag;                    // Source Overload condition = 1, else 0
+
+// Set the input block size (the DSP processing granularity) keeping the total buffered input time the same.
+// Returns the size actually used. Only call while the sample source and DSP processing are stopped.
+int SetInputBlockSize(int Samples);
+
+
+// Abstract source of the dual channel real IF input. Each backend (RSPduo hardware, file replay, ...) feeds
+// the A and B input rings and reports progress through the Status signal. The tuner controls default to
+// doing nothing for backends that have no tuner.
+
+class SampleSource : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SampleSource(QObject *parent = nullptr) : QObject(parent) {}
+    virtual ~SampleSource() {}
+
+    virtual void Start(int LOfrequency, int gRdb_Gain_A, int gRdb_Gain_B, int LNAstate) = 0;
+    virtual void Stop(void) = 0;
+    virtual void ChangeIFGainA(int gRdB_Gain) { (void)gRdB_Gain; }
+    virtual void ChangeIFGainB(int gRdb_GainA, int gRdb_GainB) { (void)gRdb_GainA; (void)gRdb_GainB; }
+    virtual void ChangeLNAGain(int LNAstate, int gRdb_GainA, int gRdb_GainB) { (void)LNAstate; (void)gRdb_GainA; (void)gRdb_GainB; }
+
+signals:
+
+    void Status(QString);
+
+protected:
+
+    // write one chunk of both channels into the input rings, stamped with the sample number of the first sample
+    static void WriteInput(const short *A, const short *B, int Count, unsigned int FirstSampleNum)
+    {
+        A_InputRing.Write(A, Count, FirstSampleNum);
+        B_InputRing.Write(B, Count, FirstSampleNum);
+    }
+};
+
+#endif // SAMPLESOURCE_H
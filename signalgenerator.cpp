@@ -0,0 +1,216 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+#include "signalgenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+#define JT65_SYMBOLS 126                            // symbols per transmission
+#define JT65_SYMBOL_TIME (4096.0 / 11025.0)         // symbol length (S)
+#define JT65_TONE_SPACING (11025.0 / 4096.0)        // tone spacing (Hz)
+#define JT65_START 1.0                              // transmission start within each minute (S)
+#define JT65_PERIOD 60.0                            // transmission period (S)
+
+
+SignalGenerator::SignalGenerator(const GeneratorSettings &Settings)
+{
+    S = Settings;
+    RandomState = S.Seed ? S.Seed : 1;
+
+    // IF carrier, Chunk samples are an exact number of cycles so one table serves every chunk
+    for(int loop = 0; loop < Chunk; loop++)
+    {
+        double Phase = 2 * M_PI * IFFrequency * loop / SampleRate;
+        CarrierCos[loop] = (float)cos(Phase);
+        CarrierSin[loop] = (float)sin(Phase);
+    }
+
+    // message: half the symbols carry the sync tone, in a seeded pseudo random order
+    for(int loop = 0; loop < JT65_SYMBOLS; loop++)
+    {
+        Sync[loop] = Random() & 1;
+        Symbols[loop] = Random() % 64;
+    }
+
+    // noise table with one extra chunk so any start offset can be read without wrapping
+    NoiseTable = new float[NoiseTableSize + Chunk];
+    for(int loop = 0; loop < NoiseTableSize; loop++) NoiseTable[loop] = (float)(Gaussian() * S.NoiseRMS);
+    memcpy(&NoiseTable[NoiseTableSize], NoiseTable, Chunk * sizeof(float));
+}
+
+
+SignalGenerator::~SignalGenerator()
+{
+    delete[] NoiseTable;
+}
+
+
+double SignalGenerator::Time(void) const
+{
+    return ((double)Chunks * Chunk - (Chunk - OutIndex)) / SampleRate;
+}
+
+
+void SignalGenerator::Generate(short *A, short *B, int Count)
+{
+    while(Count > 0)
+    {
+        if(OutIndex == Chunk) NewChunk();
+
+        int Copy = Chunk - OutIndex;
+        if(Copy > Count) Copy = Count;
+        memcpy(A, &OutA[OutIndex], Copy * sizeof(short));
+        memcpy(B, &OutB[OutIndex], Copy * sizeof(short));
+        A += Copy;
+        B += Copy;
+        OutIndex += Copy;
+        Count -= Copy;
+    }
+}
+
+
+void SignalGenerator::NewSegment(void)
+{
+    double Now = (double)Chunks * Chunk / SampleRate;
+    double Mid = Now + 0.5 * SegmentChunks * Chunk / SampleRate;
+
+    // advance both tones to the start of this segment
+    Signal.Phase = fmod(Signal.Phase + Signal.Omega * SegmentChunks * Chunk, 2 * M_PI);
+    Calibrator.Phase = fmod(Calibrator.Phase + Calibrator.Omega * SegmentChunks * Chunk, 2 * M_PI);
+
+    // EME signal: current JT65 tone, Doppler shifted, silent outside the transmission
+    double Amplitude = 0;
+    double Frequency = S.SignalOffset;
+    double InPeriod = fmod(Mid, JT65_PERIOD) - JT65_START;
+    int Symbol = (InPeriod >= 0) ? (int)(InPeriod / JT65_SYMBOL_TIME) : -1;
+    if((Symbol >= 0) && (Symbol < JT65_SYMBOLS))
+    {
+        Amplitude = S.SignalAmplitude;
+        if(!Sync[Symbol]) Frequency += (Symbols[Symbol] + 2) * JT65_TONE_SPACING;
+    }
+    Frequency += S.DopplerShift + S.DopplerRate * Mid;
+    Signal.Omega = 2 * M_PI * Frequency / SampleRate;
+
+    // Faraday rotation splits the linearly polarised signal between the two channels
+    double Angle = (S.FaradayAngle + S.FaradayRate * Mid) * M_PI / 180.0;
+    double PhaseB = S.PhaseB * M_PI / 180.0;
+    Signal.GainA[0] = (float)(Amplitude * cos(Angle));
+    Signal.GainA[1] = 0;
+    Signal.GainB[0] = (float)(Amplitude * sin(Angle) * cos(PhaseB));
+    Signal.GainB[1] = (float)(Amplitude * sin(Angle) * sin(PhaseB));
+
+    // calibrator: same level in both channels, only the instrument phase between them
+    Calibrator.Omega = 2 * M_PI * S.CalOffset / SampleRate;
+    Calibrator.GainA[0] = (float)S.CalAmplitude;
+    Calibrator.GainA[1] = 0;
+    Calibrator.GainB[0] = (float)(S.CalAmplitude * cos(PhaseB));
+    Calibrator.GainB[1] = (float)(S.CalAmplitude * sin(PhaseB));
+
+    // rebuild the lane tables exactly, the float rotations only run for one segment
+    Tone *Tones[2] = {&Signal, &Calibrator};
+    for(Tone *T : Tones)
+    {
+        for(int lane = 0; lane < Chunk; lane++)
+        {
+            double Phase = T->Phase + T->Omega * lane;
+            T->LaneRe[lane] = (float)cos(Phase);
+            T->LaneIm[lane] = (float)sin(Phase);
+        }
+        T->StepRe = (float)cos(T->Omega * Chunk);
+        T->StepIm = (float)sin(T->Omega * Chunk);
+    }
+}
+
+
+// accumulate lane phasors times a complex gain into both channels and rotate the lanes on by one chunk
+static void AccumulateLanes(float *__restrict LaneRe, float *__restrict LaneIm, const float *Gains, float StepRe, float StepIm,
+                            float *__restrict ARe, float *__restrict AIm, float *__restrict BRe, float *__restrict BIm, int Count)
+{
+    const float gAr = Gains[0], gAi = Gains[1], gBr = Gains[2], gBi = Gains[3];
+
+    for(int lane = 0; lane < Count; lane++)
+    {
+        float pr = LaneRe[lane];
+        float pi = LaneIm[lane];
+        ARe[lane] += gAr * pr - gAi * pi;
+        AIm[lane] += gAr * pi + gAi * pr;
+        BRe[lane] += gBr * pr - gBi * pi;
+        BIm[lane] += gBr * pi + gBi * pr;
+        LaneRe[lane] = pr * StepRe - pi * StepIm;
+        LaneIm[lane] = pr * StepIm + pi * StepRe;
+    }
+}
+
+
+void SignalGenerator::AddTone(Tone &T)
+{
+    const float Gains[4] = {T.GainA[0], T.GainA[1], T.GainB[0], T.GainB[1]};
+    AccumulateLanes(T.LaneRe, T.LaneIm, Gains, T.StepRe, T.StepIm, ARe, AIm, BRe, BIm, Chunk);
+}
+
+
+void SignalGenerator::NewChunk(void)
+{
+    if((Chunks % SegmentChunks) == 0) NewSegment();
+
+    memset(ARe, 0, sizeof(ARe));
+    memset(AIm, 0, sizeof(AIm));
+    memset(BRe, 0, sizeof(BRe));
+    memset(BIm, 0, sizeof(BIm));
+
+    AddTone(Signal);
+    AddTone(Calibrator);
+
+    // up to the IF, add independent noise to each channel and convert to int16
+    const float *__restrict NoiseA = &NoiseTable[Random() % NoiseTableSize];
+    const float *__restrict NoiseB = &NoiseTable[Random() % NoiseTableSize];
+    short *__restrict OutputA = OutA;
+    short *__restrict OutputB = OutB;
+    int Clips = 0;
+    for(int loop = 0; loop < Chunk; loop++)
+    {
+        float a = ARe[loop] * CarrierCos[loop] - AIm[loop] * CarrierSin[loop] + NoiseA[loop];
+        float b = BRe[loop] * CarrierCos[loop] - BIm[loop] * CarrierSin[loop] + NoiseB[loop];
+        int ia = (int)(a + copysignf(0.5f, a));                 // round to nearest
+        int ib = (int)(b + copysignf(0.5f, b));
+        int ca = std::min(std::max(ia, -32768), 32767);
+        int cb = std::min(std::max(ib, -32768), 32767);
+        Clips += (ca != ia) + (cb != ib);
+        OutputA[loop] = (short)ca;
+        OutputB[loop] = (short)cb;
+    }
+
+    ClippedSamples += Clips;
+    Chunks++;
+    OutIndex = 0;
+}
+
+
+unsigned int SignalGenerator::Random(void)
+{
+    RandomState ^= RandomState << 13;
+    RandomState ^= RandomState >> 17;
+    RandomState ^= RandomState << 5;
+    return RandomState;
+}
+
+
+double SignalGenerator::Gaussian(void)
+{
+    // Box-Muller, one deviate per call is plenty for filling a table
+    double u1 = (Random() + 1.0) / 4294967297.0;
+    double u2 = (Random() + 1.0) / 4294967297.0;
+    return sqrt(-2.0 * log(u1)) * cos(2 * M_PI * u2);
+}
@@ -0,0 +1,103 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef SIGNALGENERATOR_H
+#define SIGNALGENERATOR_H
+
+
+// Synthetic dual polarisation EME input for load testing without an RSPduo.
+//
+// Produces the same real IF the RSPduo delivers in dual tuner mode: two channels of int16 samples at 2MHz with the
+// wanted band centred on 450KHz. The signal content is a JT65 style 65 tone FSK transmission received by moonbounce
+// (Doppler shifted and drifting, its linear polarisation rotated between channel A and B by Faraday rotation), a
+// calibrator tone present equally in both channels, a fixed channel B phase offset for the phase correction to remove,
+// and independent thermal noise on each channel. The output is fully determined by the settings, including the seed.
+//
+// Generation is done in 200 sample chunks (an exact number of IF carrier cycles) using per lane phasor tables that are
+// rebuilt once a millisecond, so every inner loop is a straight multiply-add over float arrays the compiler vectorises.
+// Plain C++ with no Qt dependency so it can be shared with the sdrplay_api emulator.
+
+struct GeneratorSettings
+{
+    double NoiseRMS = 400.0;            // thermal noise per channel at the IF (RMS counts)
+    double SignalAmplitude = 40.0;      // EME signal amplitude (counts) before polarisation split
+    double SignalOffset = 10000.0;      // JT65 sync tone offset from the IF centre (Hz)
+    double DopplerShift = 300.0;        // initial Doppler shift of the EME signal (Hz)
+    double DopplerRate = -0.02;         // Doppler drift (Hz per second)
+    double FaradayAngle = 30.0;         // initial polarisation angle of the EME signal from channel A (degrees)
+    double FaradayRate = 0.5;           // Faraday rotation rate (degrees per second)
+    double CalAmplitude = 200.0;        // calibrator tone amplitude in each channel (counts)
+    double CalOffset = 45000.0;         // calibrator offset from the IF centre (Hz)
+    double PhaseB = 40.0;               // channel B phase relative to channel A (degrees)
+    unsigned int Seed = 1;              // noise and message seed
+};
+
+
+class SignalGenerator
+{
+public:
+    explicit SignalGenerator(const GeneratorSettings &Settings);
+    ~SignalGenerator();
+
+    void Generate(short *A, short *B, int Count);     // next Count samples of both channels
+    double Time(void) const;                          // seconds of input generated so far
+    unsigned long long Clipped(void) const { return ClippedSamples; }   // output samples limited to int16 range
+
+    static constexpr double SampleRate = 2000000.0;   // real IF sample rate (Hz)
+    static constexpr double IFFrequency = 450000.0;   // IF centre (Hz)
+    static constexpr int Chunk = 200;                 // samples per chunk, a whole number of IF cycles
+    static constexpr int SegmentChunks = 10;          // chunks between phasor rebuilds (1mS)
+
+private:
+
+    struct Tone                                       // one baseband tone feeding both channels
+    {
+        double Phase = 0;                             // phase at the start of the current segment (radians)
+        double Omega = 0;                             // frequency for the current segment (radians per sample)
+        float GainA[2];                               // complex gain into channel A (re, im)
+        float GainB[2];                               // complex gain into channel B (re, im)
+        float StepRe, StepIm;                         // rotation that advances every lane by one chunk
+        alignas(64) float LaneRe[Chunk];              // e^j(Phase + Omega * lane) for the current chunk
+        alignas(64) float LaneIm[Chunk];
+    };
+
+    void NewSegment(void);                            // set tone frequencies and gains, rebuild lane tables
+    void NewChunk(void);                              // generate the next chunk into OutA / OutB
+    void AddTone(Tone &T);                            // accumulate one tone into both channels
+    unsigned int Random(void);                        // xorshift32
+    double Gaussian(void);                            // unit variance normal deviate
+
+    GeneratorSettings S;
+
+    Tone Signal;                                      // the EME signal (current JT65 tone)
+    Tone Calibrator;                                  // the calibrator tone
+
+    unsigned char Sync[126];                          // JT65 style sync pattern, 1 = sync tone
+    unsigned char Symbols[126];                       // data symbols 0 - 63
+
+    static constexpr int NoiseTableSize = 65536;
+    float *NoiseTable;                                // Gaussian noise, NoiseRMS, plus one chunk of wrap around
+
+    alignas(64) float CarrierCos[Chunk];              // IF carrier over one chunk
+    alignas(64) float CarrierSin[Chunk];
+    alignas(64) float ARe[Chunk], AIm[Chunk];         // channel A complex baseband for the current chunk
+    alignas(64) float BRe[Chunk], BIm[Chunk];         // channel B complex baseband for the current chunk
+
+    short OutA[Chunk];                                // finished chunk of channel A IF samples
+    short OutB[Chunk];                                // finished chunk of channel B IF samples
+    int OutIndex = Chunk;                             // next unused sample in OutA / OutB
+
+    unsigned long long Chunks = 0;                    // chunks generated
+    unsigned long long ClippedSamples = 0;
+    unsigned int RandomState;
+};
+
+#endif // SIGNALGENERATOR_H
@@ -0,0 +1,132 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include "wakeup.h"
+
+#include <atomic>
+#include <chrono>
+
+
+// Bounded single producer / single consumer queue of preallocated work buffers, linking two pipeline threads.
+//
+// The slots are owned by the queue and filled in place: the producer claims the next free slot, fills it and
+// publishes it, the consumer takes the oldest published slot, uses it and pops it to hand it back. Published and
+// consumed counts are free running and compared by unsigned difference, as in InputRing, with release/acquire
+// ordering so a slot's contents are visible before it changes hands. Neither side locks anything while the queue
+// is neither full nor empty. A full queue makes the producer wait (backpressure, timed so it can be reported), an
+// empty one makes the consumer wait, each sleeping on a WakeUp rung by the other side.
+//
+// Close() is the producer's end of stream: the consumer drains what is left and then Front() returns nullptr.
+
+template<typename T>
+class SPSCQueue
+{
+public:
+    explicit SPSCQueue(int Size)   // Size must be a power of 2
+    {
+        Count = Size;
+        Slots = new T[Count];
+    }
+
+    ~SPSCQueue()
+    {
+        delete[] Slots;
+    }
+
+    SPSCQueue(const SPSCQueue &) = delete;
+    SPSCQueue &operator=(const SPSCQueue &) = delete;
+
+    // slot by index, to allocate the buffers before either side starts
+    T &Slot(int Index) { return Slots[Index]; }
+    int Size(void) const { return Count; }
+
+    // empty the queue and clear the statistics, only while neither side is running
+    void Reset(void)
+    {
+        Written.store(0, std::memory_order_relaxed);
+        Read.store(0, std::memory_order_relaxed);
+        Closed.store(false);
+        BlockedTime.store(0, std::memory_order_relaxed);
+    }
+
+    // ---- Producer side ---- //
+
+    // next free slot, waiting while the queue is full
+    T *Claim(void)
+    {
+        unsigned int Head = Written.load(std::memory_order_relaxed);
+        if((Head - Read.load(std::memory_order_acquire)) >= (unsigned int)Count)
+        {
+            auto Start = std::chrono::steady_clock::now();
+            unsigned int Seen = SpaceReady.Count();
+            while((Head - Read.load(std::memory_order_acquire)) >= (unsigned int)Count) Seen = SpaceReady.Wait(Seen);
+            BlockedTime.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count(),
+                                  std::memory_order_relaxed);
+        }
+        return &Slots[Head & (Count - 1)];
+    }
+
+    // hand the claimed slot to the consumer
+    void Publish(void)
+    {
+        Written.store(Written.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        DataReady.Notify();
+    }
+
+    // no more slots will be published
+    void Close(void)
+    {
+        Closed.store(true);
+        DataReady.Notify();
+    }
+
+    // time the producer has spent waiting for a free slot (nS)
+    long long Blocked(void) const { return BlockedTime.load(std::memory_order_relaxed); }
+
+    // ---- Consumer side ---- //
+
+    // oldest published slot, waiting while the queue is empty, nullptr once closed and drained
+    T *Front(void)
+    {
+        unsigned int Tail = Read.load(std::memory_order_relaxed);
+        unsigned int Seen = DataReady.Count();
+        while(Written.load(std::memory_order_acquire) == Tail)
+        {
+            if(Closed.load() && (Written.load(std::memory_order_acquire) == Tail)) return nullptr;
+            Seen = DataReady.Wait(Seen);
+        }
+        return &Slots[Tail & (Count - 1)];
+    }
+
+    // hand the front slot back to the producer
+    void Pop(void)
+    {
+        Read.store(Read.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        SpaceReady.Notify();
+    }
+
+private:
+    T *Slots;                                       // Count work buffers
+    int Count;                                      // number of slots, a power of 2
+    WakeUp DataReady;                               // rung by the producer, the consumer sleeps on it
+    WakeUp SpaceReady;                              // rung by the consumer, the producer sleeps on it
+    std::atomic<bool> Closed {false};               // end of stream, set by the producer
+    std::atomic<long long> BlockedTime {0};         // producer time spent waiting on a full queue (nS)
+
+    alignas(64) std::atomic<unsigned int> Written {0};   // slots published (written by producer)
+    alignas(64) std::atomic<unsigned int> Read {0};      // slots handed back (written by consumer)
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,65 @@
+// RSPduoEME Copyright 2020 David Warwick G4EEV
+//
+// This file is part of RSPduoEME.
+//
+// RSPduoEME is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of the License, or(at your option) any later version.
+// RSPduoEME is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details. You should have
+// received a copy of the GNU General Public License along with RSPduoEMRE, if not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef WAKEUP_H
+#define WAKEUP_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+
+// Wakes a consumer thread when a producer has published new work.
+//
+// Notify() only bumps an event count unless the consumer is actually asleep, so a producer running ahead of the
+// consumer never touches the mutex. The consumer passes the count it last saw to Wait(), which returns at once if
+// anything was notified since then. The sleeping flag and the count are both sequentially consistent, so either the
+// producer sees the consumer asleep and wakes it, or the consumer sees the new count before it sleeps.
+
+class WakeUp
+{
+public:
+
+    // ---- Producer side (any thread) ---- //
+
+    void Notify(void)
+    {
+        Events.fetch_add(1);
+        if(Sleeping.load())
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            Condition.notify_one();
+        }
+    }
+
+    // ---- Consumer side ---- //
+
+    unsigned int Count(void) const { return Events.load(); }
+
+    // sleep until the event count differs from Seen, returns the new count
+    unsigned int Wait(unsigned int Seen)
+    {
+        std::unique_lock<std::mutex> Lock(Mutex);
+        Sleeping.store(true);
+        Condition.wait(Lock, [&]{ return Events.load() != Seen; });
+        Sleeping.store(false);
+        return Events.load();
+    }
+
+private:
+
+    std::mutex Mutex;
+    std::condition_variable Condition;
+    std::atomic<unsigned int> Events {0};       // number of notifications so far
+    std::atomic<bool> Sleeping {false};         // consumer is (about to be) waiting on Condition
+};
+
+#endif // WAKEUP_H